@@ -0,0 +1,197 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/// @brief Sorter benchmark: sweeps sizes, key types and key functors across the Sorter methods and
+/// their std counterparts, writing one CSV row per configuration:
+///
+///     method,key_type,key_ftor,size,reps,ns_per_elem
+///
+/// Usage: cav_bench [output.csv] [max_elems_per_config]
+/// Timings exclude the copy of the input (measured separately and subtracted), build in Release.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "cav/mish/Chrono.hpp"
+#include "cav/numeric/sort.hpp"
+
+namespace {
+
+template <typename T>
+struct Rec {
+    T        key;
+    uint32_t payload[3];
+};
+
+struct IdentityKey {
+    static constexpr std::string_view name = "identity";
+
+    template <typename T>
+    using elem_t = T;
+
+    using ftor = cav::IdentityFtor;  // enables the Sorter identity-key fast paths
+
+    template <typename T>
+    static T make(T k) {
+        return k;
+    }
+};
+
+struct MemberKey {
+    static constexpr std::string_view name = "member";
+
+    template <typename T>
+    using elem_t = Rec<T>;
+
+    using ftor = MemberKey;
+
+    template <typename T>
+    static Rec<T> make(T k) {
+        return {k, {}};
+    }
+
+    template <typename T>
+    T operator()(Rec<T> const& r) const {
+        return r.key;
+    }
+};
+
+template <typename T>
+constexpr std::string_view key_type_name() {
+    if constexpr (std::is_same_v<T, int32_t>)
+        return "int32";
+    else if constexpr (std::is_same_v<T, uint64_t>)
+        return "uint64";
+    else if constexpr (std::is_same_v<T, float>)
+        return "float";
+    else
+        return "double";
+}
+
+template <typename T>
+T random_key(std::mt19937_64& rnd) {
+    if constexpr (std::is_floating_point_v<T>)
+        return std::uniform_real_distribution<T>(-1e6, 1e6)(rnd);
+    else
+        return static_cast<T>(rnd());
+}
+
+struct Bench {
+    FILE*                  out;
+    size_t                 max_elems;
+    cav::Sorter<>          sorter = {};
+    cav::Chrono<cav::nsec> timer  = {};
+    std::mt19937_64        rnd{0};
+
+    /// @brief Time `reps` runs of `algo` on copies of consecutive slices of `pool`, best of
+    /// `trials` (both for the copy-only and for the copy + algo loops).
+    template <typename E, typename F>
+    double time_ns(std::vector<E> const& pool, std::vector<E>& work, size_t reps, F&& algo) {
+        constexpr size_t trials = 3;
+
+        size_t n       = work.size();
+        size_t slices  = pool.size() / n;
+        double copy_ns = 1e300, tot_ns = 1e300;
+        for (size_t t = 0; t < trials; ++t) {
+            timer.lap();
+            for (size_t r = 0; r < reps; ++r)
+                std::copy_n(pool.begin() + (r % slices) * n, n, work.begin());
+            copy_ns = std::min(copy_ns, static_cast<double>(timer.lap()));
+
+            for (size_t r = 0; r < reps; ++r) {
+                std::copy_n(pool.begin() + (r % slices) * n, n, work.begin());
+                algo(work);
+            }
+            tot_ns = std::min(tot_ns, static_cast<double>(timer.lap()));
+        }
+        return std::max(0.0, tot_ns - copy_ns);
+    }
+
+    template <typename T, typename K>
+    void run_size(size_t n) {
+        using E     = typename K::template elem_t<T>;
+        size_t reps = std::max<size_t>(1, max_elems / n);
+        auto   key  = typename K::ftor{};
+        auto   cmp  = [&](E const& a, E const& b) { return key(a) < key(b); };
+        std::vector<E> pool(std::max(n, std::min<size_t>(max_elems, n * 64)));
+        for (auto& e : pool)
+            e = K::make(random_key<T>(rnd));
+        std::vector<E> work(n);
+
+        auto row = [&](std::string_view method, auto&& algo) {
+            double ns = time_ns(pool, work, reps, algo);
+            std::fprintf(out,
+                         "%.*s,%.*s,%.*s,%zu,%zu,%.4f\n",
+                         static_cast<int>(method.size()),
+                         method.data(),
+                         static_cast<int>(key_type_name<T>().size()),
+                         key_type_name<T>().data(),
+                         static_cast<int>(K::name.size()),
+                         K::name.data(),
+                         n,
+                         reps,
+                         ns / static_cast<double>(reps * n));
+        };
+
+        row("std_sort", [&](auto& w) { std::sort(w.begin(), w.end(), cmp); });
+        row("sort", [&](auto& w) { sorter.sort(w, key); });
+        row("radix_sort", [&](auto& w) { sorter.radix_sort(w, key); });
+        row("net_sort", [&](auto& w) { sorter.net_sort(w, key); });
+        if (n <= 1024)
+            row("insertion_sort", [&](auto& w) { sorter.insertion_sort(w, key); });
+        row("std_nth_element",
+            [&](auto& w) { std::nth_element(w.begin(), w.begin() + n / 2, w.end(), cmp); });
+        row("nth_element", [&](auto& w) { sorter.nth_element(w, n / 2, key); });
+    }
+
+    template <typename T, typename K>
+    void run() {
+        for (size_t n : {2,   3,   4,   6,   8,   12,   16,   20,   24,    32,    48,    64,
+                         96,  128, 192, 256, 512, 1024, 4096, 16384, 65536, 262144, 1048576})
+            if (n <= max_elems)
+                run_size<T, K>(n);
+    }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    FILE* out = argc > 1 ? std::fopen(argv[1], "w") : stdout;
+    if (out == nullptr) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    size_t max_elems = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1U << 22U;
+
+    Bench bench{out, max_elems};
+    std::fprintf(out, "method,key_type,key_ftor,size,reps,ns_per_elem\n");
+    bench.run<int32_t, IdentityKey>();
+    bench.run<uint64_t, IdentityKey>();
+    bench.run<float, IdentityKey>();
+    bench.run<double, IdentityKey>();
+    bench.run<int32_t, MemberKey>();
+    bench.run<uint64_t, MemberKey>();
+    bench.run<double, MemberKey>();
+
+    if (out != stdout)
+        std::fclose(out);
+    return EXIT_SUCCESS;
+}
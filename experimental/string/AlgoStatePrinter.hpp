@@ -13,14 +13,25 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 
-#ifdef CAV_INCLUDE_UTILS_ALGOSTATEPRINTER_HPP
+#ifndef CAV_INCLUDE_UTILS_ALGOSTATEPRINTER_HPP
 #define CAV_INCLUDE_UTILS_ALGOSTATEPRINTER_HPP
 
 #include <fmt/core.h>
 
-#include "StaticStr.hpp"
-#include "limits.hpp"
-#include "tuple.hpp"
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "../../include/cav/comptime/syntactic_sugars.hpp"
+#include "../../include/cav/mish/util_functions.hpp"
+#include "../../include/cav/numeric/limits.hpp"
+#include "../../include/cav/string/StaticStr.hpp"
+#include "../../include/cav/tuplish/tuple.hpp"
 
 namespace cav {
 
@@ -30,7 +41,13 @@ struct delay_pair {
     static constexpr int delay = D;
 };
 
-/// @brief Over-engineered state printer
+/// @brief Over-engineered state printer.
+///
+/// By default the lines are formatted and printed on the calling thread. After enable_async() the
+/// state is instead copied into a lock-free single-producer/single-consumer ring and a background
+/// thread formats and prints it (header period included). When the ring is full the line is
+/// dropped and counted (see dropped_lines()) instead of blocking the caller. Extra print_state
+/// arguments are not supported in async mode.
 template <StaticStr Header,
           int       HeaderPeriod,
           StaticStr FmtString,
@@ -55,8 +72,32 @@ public:
         , output(c_output) {
     }
 
+    /// @brief Print from a background thread from now on, through a ring of ring_size lines
+    /// (rounded up to a power of two). Pending lines are flushed by disable_async/destruction.
+    void enable_async(size_t ring_size = 1024) {
+        async = std::make_unique<AsyncSink>(output, std::bit_ceil(max(ring_size, size_t{2})));
+    }
+
+    void disable_async() {
+        async.reset();
+    }
+
+    [[nodiscard]] bool is_async() const {
+        return async != nullptr;
+    }
+
+    /// @brief Lines lost because the async ring was full
+    [[nodiscard]] uint64_t dropped_lines() const {
+        return async ? async->dropped.load(std::memory_order_relaxed) : 0;
+    }
+
     template <typename... OTs>
     void print_state(typename Ts::type const&... ts, OTs&&... other) {
+        if (async) {
+            assert(sizeof...(OTs) == 0 && "Extra arguments are not supported in async mode");
+            async->push(ts...);
+            return;
+        }
         if (--header_back_counter <= 0) {
             fmt::print(output, header.data());
             header_back_counter = h_period;
@@ -78,6 +119,67 @@ public:
 
 
 private:
+    /// @brief SPSC ring of states plus the consumer thread that prints them. head is written only
+    /// by the producer and tail only by the consumer, each on its own cache line.
+    struct AsyncSink {
+        FILE*                           output;
+        std::unique_ptr<tup_type[]>     ring;
+        size_t                          mask;
+        alignas(64) std::atomic<size_t> head                = 0;
+        size_t                          cached_tail         = 0;  // producer copy of tail
+        std::atomic<uint64_t>           dropped             = 0;
+        alignas(64) std::atomic<size_t> tail                = 0;
+        int64_t                         header_back_counter = 0;
+        std::jthread                    consumer;  // last: joined before the ring is destroyed
+
+        AsyncSink(FILE* c_output, size_t ring_size)
+            : output(c_output)
+            , ring(std::make_unique<tup_type[]>(ring_size))
+            , mask(ring_size - 1)
+            , consumer([this](std::stop_token const& stop) { _consume(stop); }) {
+        }
+
+        void push(typename Ts::type const&... ts) {
+            size_t pos = head.load(std::memory_order_relaxed);
+            if (pos - cached_tail > mask) {
+                cached_tail = tail.load(std::memory_order_acquire);
+                if (pos - cached_tail > mask) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            ring[pos & mask] = {ts...};
+            head.store(pos + 1, std::memory_order_release);
+        }
+
+        void _consume(std::stop_token const& stop) {
+            size_t pos = tail.load(std::memory_order_relaxed);
+            for (;;) {
+                bool   stopping = stop.stop_requested();  // checked before the last drain
+                size_t end      = head.load(std::memory_order_acquire);
+                for (; pos != end; ++pos) {
+                    _print(ring[pos & mask]);
+                    tail.store(pos + 1, std::memory_order_release);
+                }
+                if (stopping)
+                    break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (uint64_t lost = dropped.load(std::memory_order_relaxed); lost > 0)
+                fmt::print(output, "({} state lines dropped)\n", lost);
+            std::fflush(output);
+        }
+
+        void _print(tup_type const& st) {
+            if (--header_back_counter <= 0) {
+                fmt::print(output, header.data());
+                header_back_counter = h_period;
+            }
+            static constexpr auto ext_str = str_concat(fmt_string, "\n");
+            st.reduce([&](auto const&... ts) { fmt::print(output, ext_str.data(), ts...); });
+        }
+    };
+
     [[nodiscard]] constexpr bool _ready_to_print(
         typename Ts::type const&... new_ts) const noexcept {
         int64_t delay = time - last_print_time;
@@ -96,6 +198,8 @@ private:
     int64_t  time                = 0;
     int64_t  last_print_time     = -_min(Ts::delay...);
     int64_t  header_back_counter = 0;
+
+    std::unique_ptr<AsyncSink> async = nullptr;
 };
 
 }  // namespace cav
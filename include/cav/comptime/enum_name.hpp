@@ -16,13 +16,16 @@
 #ifndef CAV_INCLUDE_ENUM_NAME_HPP
 #define CAV_INCLUDE_ENUM_NAME_HPP
 
+#include <array>
 #include <bit>
 #include <cstddef>
+#include <optional>
 #include <source_location>
 #include <string_view>
 #include <type_traits>
 
 #include "../comptime/type_name.hpp"
+#include "../string/PerfectHash.hpp"
 #include "../string/StaticStr.hpp"
 
 namespace cav {
@@ -123,12 +126,33 @@ template <auto X>
     return map[idx];
 }
 
+namespace detail {
+    template <typename ET>
+    inline constexpr auto enum_name_index = []() consteval {
+        constexpr size_t e_size = enum_size<ET>::value;
+        auto             names  = std::array<std::string_view, e_size>{};
+        for_each_idx<e_size>([&]<auto I>(ct<I>) { names[I] = enum_name_impl<ET, I>::name; });
+        return PerfectStrHash(names);
+    }();
+}  // namespace detail
+
+/// @brief Enum value called name (as returned by enum_name), found with a compile-time perfect
+/// hash of the enum names
+template <typename ET>
+[[nodiscard]] constexpr std::optional<ET> enum_from_name(std::string_view name) {
+    int idx = detail::enum_name_index<ET>.find(name);
+    if (idx < 0)
+        return std::nullopt;
+    return static_cast<ET>(idx);
+}
+
 #ifdef CAV_COMP_TESTS
 namespace detail::test {
     CAV_PASS(enum_name<TEST::A>() == enum_name(TEST::A));
     CAV_PASS(enum_name<TEST::B>() == enum_name(TEST::B));
     CAV_PASS(enum_name<A>() == enum_name(static_cast<TEST>(0)));
     CAV_PASS(enum_name<B>() == enum_name(B));
+    CAV_PASS(enum_from_name<TEST>("B") == TEST::B && !enum_from_name<TEST2>("C"));
 }  // namespace detail::test
 #endif
 
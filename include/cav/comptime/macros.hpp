@@ -64,6 +64,10 @@
 #define CAV_STR(s)  CAV__STR(s)
 #define CAV__STR(s) #s
 
+/// @brief Concatenate two tokens after expanding them (e.g., unique names with __LINE__)
+#define CAV_CONCAT(a, b)  CAV__CONCAT(a, b)
+#define CAV__CONCAT(a, b) a##b
+
 /// @brief Often one would like to use a type only if it is defined. However, std::conditional_t
 /// instantiates both branches so one cannot insert non-existing types to check if they exist
 /// with a require expression, and then use them safely.
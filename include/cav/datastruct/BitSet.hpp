@@ -0,0 +1,379 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_DATASTRUCT_BITSET_HPP
+#define CAV_INCLUDE_DATASTRUCT_BITSET_HPP
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+
+#include "../comptime/test.hpp"
+#include "../mish/util_functions.hpp"
+#include "../vectors/OwnSpan.hpp"
+
+namespace cav {
+
+/// @brief Runtime-sized set of flags packed in 64-bit words (one bit per flag instead of the byte
+/// of an OwnSpan<bool>), in a cache-line aligned allocation. The bulk operations (count, the
+/// and/or/andnot combinations, the empty words skipped by find_next) are plain loops over whole
+/// words plus masked head/tail words, written so the compiler vectorizes them for the target ISA
+/// (e.g., vpopcntq with AVX512-VPOPCNTDQ). Set bits are visited with countr_zero (tzcnt), one
+/// iteration per set bit.
+///
+/// The bits past size() in the last word are always zero. atomic_test_and_set can be called
+/// concurrently on the same bitset (for concurrent marking), everything else is not thread-safe.
+class BitSet {
+    static constexpr size_t word_bits  = 64;
+    static constexpr size_t line_align = 64;
+
+    using words_t = OwnSpan<uint64_t, AlignedDel<uint64_t, line_align>>;
+
+public:
+    using size_type = size_t;
+
+    /// @brief Forward iterator over the indexes of the set bits (ends at std::default_sentinel)
+    class set_bit_iterator {
+    public:
+        using value_type      = size_t;
+        using difference_type = ptrdiff_t;
+
+        constexpr set_bit_iterator() = default;
+
+        constexpr set_bit_iterator(uint64_t const* c_words, size_t c_n_words)
+            : words(c_words)
+            , n_words(c_n_words)
+            , cur(c_n_words > 0 ? c_words[0] : 0) {
+            _skip_empty();
+        }
+
+        [[nodiscard]] constexpr size_t operator*() const noexcept {
+            return w * word_bits + static_cast<size_t>(std::countr_zero(cur));
+        }
+
+        constexpr set_bit_iterator& operator++() noexcept {
+            cur &= cur - 1;
+            _skip_empty();
+            return *this;
+        }
+
+        constexpr set_bit_iterator operator++(int) noexcept {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        [[nodiscard]] constexpr bool operator==(std::default_sentinel_t /*s*/) const noexcept {
+            return w >= n_words;
+        }
+
+        [[nodiscard]] constexpr bool operator==(set_bit_iterator const& other) const noexcept {
+            return w == other.w && cur == other.cur;
+        }
+
+    private:
+        uint64_t const* words   = nullptr;
+        size_t          n_words = 0;
+        size_t          w       = 0;
+        uint64_t        cur     = 0;
+
+        constexpr void _skip_empty() noexcept {
+            while (cur == 0 && ++w < n_words)
+                cur = words[w];
+        }
+    };
+
+    struct set_bits_view {
+        set_bit_iterator first;
+
+        [[nodiscard]] constexpr set_bit_iterator begin() const noexcept {
+            return first;
+        }
+
+        [[nodiscard]] static constexpr std::default_sentinel_t end() noexcept {
+            return {};
+        }
+    };
+
+    constexpr BitSet() = default;
+
+    explicit constexpr BitSet(size_t n_bits, bool value = false)
+        : words_span(_n_words(n_bits), value ? ~uint64_t{0} : uint64_t{0})
+        , nbits(n_bits) {
+        _clear_tail();
+    }
+
+    [[nodiscard]] constexpr size_t size() const noexcept {
+        return nbits;
+    }
+
+    [[nodiscard]] constexpr size_t n_words() const noexcept {
+        return words_span.size();
+    }
+
+    /// @brief The underlying words, bit i is bit (i % 64) of word i / 64
+    [[nodiscard]] constexpr std::span<uint64_t const> words() const noexcept {
+        return {_words(), n_words()};
+    }
+
+    ////////////////////////////// SINGLE BITS //////////////////////////////
+
+    [[nodiscard]] constexpr bool test(size_t i) const noexcept {
+        assert(i < nbits);
+        return (_words()[i / word_bits] & _bit(i)) != 0;
+    }
+
+    [[nodiscard]] constexpr bool operator[](size_t i) const noexcept {
+        return test(i);
+    }
+
+    constexpr void set(size_t i) noexcept {
+        assert(i < nbits);
+        _words()[i / word_bits] |= _bit(i);
+    }
+
+    constexpr void reset(size_t i) noexcept {
+        assert(i < nbits);
+        _words()[i / word_bits] &= ~_bit(i);
+    }
+
+    constexpr void assign(size_t i, bool value) noexcept {
+        assert(i < nbits);
+        uint64_t& word = _words()[i / word_bits];
+        word           = (word & ~_bit(i)) | (uint64_t{value} << (i % word_bits));
+    }
+
+    /// @brief Set bit i, returns its previous value
+    constexpr bool test_and_set(size_t i) noexcept {
+        bool old = test(i);
+        set(i);
+        return old;
+    }
+
+    /// @brief test_and_set as a single atomic RMW on the word (a lock-free fetch_or), safe against
+    /// concurrent atomic_test_and_set/atomic_test calls on any bit
+    bool atomic_test_and_set(size_t i, std::memory_order order = std::memory_order_relaxed) {
+        assert(i < nbits);
+        auto word = std::atomic_ref<uint64_t>(_words()[i / word_bits]);
+        return (word.fetch_or(_bit(i), order) & _bit(i)) != 0;
+    }
+
+    [[nodiscard]] bool atomic_test(size_t i,
+                                   std::memory_order order = std::memory_order_relaxed) const {
+        assert(i < nbits);
+        auto word = std::atomic_ref<uint64_t>(const_cast<uint64_t&>(_words()[i / word_bits]));
+        return (word.load(order) & _bit(i)) != 0;
+    }
+
+    /////////////////////////////// BULK OPS ///////////////////////////////
+
+    constexpr void fill(bool value) noexcept {
+        uint64_t* ws = _words();
+        for (size_t w = 0; w < n_words(); ++w)
+            ws[w] = value ? ~uint64_t{0} : uint64_t{0};
+        _clear_tail();
+    }
+
+    /// @brief Number of set bits in [first, last)
+    [[nodiscard]] constexpr size_t count(size_t first = 0, size_t last = max_size) const noexcept {
+        last = min(last, nbits);
+        if (first >= last)
+            return 0;
+
+        uint64_t const* ws = _words();
+        size_t          fw = first / word_bits;
+        size_t          lw = (last - 1) / word_bits;
+        if (fw == lw)
+            return std::popcount(ws[fw] & _head_mask(first) & _tail_mask(last));
+
+        size_t res = std::popcount(ws[fw] & _head_mask(first));
+        for (size_t w = fw + 1; w < lw; ++w)
+            res += std::popcount(ws[w]);
+        return res + std::popcount(ws[lw] & _tail_mask(last));
+    }
+
+    [[nodiscard]] constexpr bool any() const noexcept {
+        return find_first() < nbits;
+    }
+
+    [[nodiscard]] constexpr bool none() const noexcept {
+        return !any();
+    }
+
+    [[nodiscard]] constexpr size_t find_first() const noexcept {
+        return find_next(0);
+    }
+
+    /// @brief First set bit with index >= i, size() if there is none. Empty words are skipped 8 at
+    /// a time (an OR-reduction of 8 words per step).
+    [[nodiscard]] constexpr size_t find_next(size_t i) const noexcept {
+        if (i >= nbits)
+            return nbits;
+
+        uint64_t const* ws   = _words();
+        size_t          w    = i / word_bits;
+        uint64_t        word = ws[w] & _head_mask(i);
+        if (word == 0) {
+            ++w;
+            for (; w + 8 <= n_words(); w += 8) {
+                uint64_t any_set = 0;
+                for (size_t k = 0; k < 8; ++k)
+                    any_set |= ws[w + k];
+                if (any_set != 0)
+                    break;
+            }
+            for (; w < n_words() && ws[w] == 0; ++w)
+                ;
+            if (w == n_words())
+                return nbits;
+            word = ws[w];
+        }
+        return w * word_bits + static_cast<size_t>(std::countr_zero(word));
+    }
+
+    /// @brief Call fn(i) for every set bit i, in increasing order
+    template <typename Fn>
+    constexpr void for_each_set(Fn&& fn) const {
+        uint64_t const* ws = _words();
+        for (size_t w = 0; w < n_words(); ++w)
+            for (uint64_t word = ws[w]; word != 0; word &= word - 1)
+                fn(w * word_bits + static_cast<size_t>(std::countr_zero(word)));
+    }
+
+    /// @brief Range of the indexes of the set bits: for (size_t i : bs.set_bits())
+    [[nodiscard]] constexpr set_bits_view set_bits() const noexcept {
+        return {set_bit_iterator(_words(), n_words())};
+    }
+
+    /// @brief this[i] &= other[i] for i in [first, last) (other must have at least last bits)
+    constexpr BitSet& and_with(BitSet const& other, size_t first = 0, size_t last = max_size) {
+        _combine(other, first, last, [](uint64_t a, uint64_t b) { return a & b; });
+        return *this;
+    }
+
+    constexpr BitSet& or_with(BitSet const& other, size_t first = 0, size_t last = max_size) {
+        _combine(other, first, last, [](uint64_t a, uint64_t b) { return a | b; });
+        return *this;
+    }
+
+    /// @brief this[i] &= !other[i] for i in [first, last)
+    constexpr BitSet& andnot_with(BitSet const& other, size_t first = 0, size_t last = max_size) {
+        _combine(other, first, last, [](uint64_t a, uint64_t b) { return a & ~b; });
+        return *this;
+    }
+
+    constexpr BitSet& operator&=(BitSet const& other) {
+        return and_with(other);
+    }
+
+    constexpr BitSet& operator|=(BitSet const& other) {
+        return or_with(other);
+    }
+
+private:
+    static constexpr size_t max_size = ~size_t{0};
+
+    words_t words_span = {};
+    size_t  nbits      = 0;
+
+    [[nodiscard]] static constexpr size_t _n_words(size_t n_bits) noexcept {
+        return (n_bits + word_bits - 1) / word_bits;
+    }
+
+    [[nodiscard]] static constexpr uint64_t _bit(size_t i) noexcept {
+        return uint64_t{1} << (i % word_bits);
+    }
+
+    /// @brief Bits >= first % 64 of the word of first
+    [[nodiscard]] static constexpr uint64_t _head_mask(size_t first) noexcept {
+        return ~uint64_t{0} << (first % word_bits);
+    }
+
+    /// @brief Bits <= (last - 1) % 64 of the word of last - 1
+    [[nodiscard]] static constexpr uint64_t _tail_mask(size_t last) noexcept {
+        return ~uint64_t{0} >> (word_bits - 1 - (last - 1) % word_bits);
+    }
+
+    [[nodiscard]] constexpr uint64_t* _words() noexcept {
+        if (std::is_constant_evaluated() || words_span.data() == nullptr)
+            return words_span.data();
+        return std::assume_aligned<line_align>(words_span.data());
+    }
+
+    [[nodiscard]] constexpr uint64_t const* _words() const noexcept {
+        return const_cast<BitSet*>(this)->_words();
+    }
+
+    constexpr void _clear_tail() noexcept {
+        if (nbits % word_bits != 0)
+            _words()[n_words() - 1] &= _tail_mask(nbits);
+    }
+
+    template <typename OpT>
+    constexpr void _combine(BitSet const& other, size_t first, size_t last, OpT op) noexcept {
+        last = min(last, nbits);
+        assert(other.size() >= last);
+        if (first >= last)
+            return;
+
+        uint64_t*       dst   = _words();
+        uint64_t const* src   = other._words();
+        auto            blend = [&](size_t w, uint64_t mask) {
+            dst[w] = (dst[w] & ~mask) | (op(dst[w], src[w]) & mask);
+        };
+        size_t fw = first / word_bits;
+        size_t lw = (last - 1) / word_bits;
+        if (fw == lw) {
+            blend(fw, _head_mask(first) & _tail_mask(last));
+            return;
+        }
+        blend(fw, _head_mask(first));
+        for (size_t w = fw + 1; w < lw; ++w)
+            dst[w] = op(dst[w], src[w]);
+        blend(lw, _tail_mask(last));
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    CAV_BLOCK_PASS({
+        auto bits = BitSet(200);
+        for (size_t i : {3, 64, 65, 130, 199})
+            bits.set(i);
+        assert(bits.count() == 5 && bits.count(4, 131) == 3 && bits.count(65, 66) == 1);
+        assert(bits.find_first() == 3 && bits.find_next(4) == 64 && bits.find_next(131) == 199);
+        size_t sum = 0;
+        for (size_t i : bits.set_bits())
+            sum += i;
+        assert(sum == 3 + 64 + 65 + 130 + 199);
+
+        auto mask = BitSet(200, true);
+        assert(mask.count() == 200);
+        mask.andnot_with(bits, 60, 140);
+        assert(mask.count() == 197 && !mask[64] && mask[3] && mask[199]);
+        bits.and_with(mask);
+        assert(bits.count() == 2 && !bits.test_and_set(0) && bits.test_and_set(0));
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_DATASTRUCT_BITSET_HPP */
@@ -0,0 +1,201 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_DATASTRUCT_INDEXEDHEAP_HPP
+#define CAV_INCLUDE_DATASTRUCT_INDEXEDHEAP_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "../comptime/test.hpp"
+#include "../mish/util_functions.hpp"
+
+namespace cav {
+
+/// @brief D-ary min-heap (by CompT) of integer ids in [0, n) with decrease_key: each id is in
+/// the heap at most once, so there are no stale entries to skip as with a lazy-deletion
+/// std::priority_queue. The heap is a flat array of (key, id) pairs, the D children of a node
+/// are contiguous (a 4-ary heap scans one cache line per level with 8-byte entries), and a
+/// position map id -> heap slot makes contains/key_of/decrease_key O(1) + a sift.
+///
+/// @tparam SzT  Id and position type (as in Sorter<SzT>), its max value is reserved
+template <typename KeyT, int D = 4, typename SzT = uint32_t, typename CompT = std::less<>>
+class IndexedHeap {
+    static_assert(D >= 2, "A heap node needs at least two children");
+
+public:
+    using key_type  = KeyT;
+    using size_type = SzT;
+
+    static constexpr SzT npos = std::numeric_limits<SzT>::max();
+
+    struct entry {
+        KeyT key;
+        SzT  id;
+    };
+
+    /// @brief Room for the ids [0, n_ids), larger ids grow the position map on push
+    explicit constexpr IndexedHeap(size_t n_ids = 0, CompT comparator = {})
+        : pos(n_ids, npos)
+        , comp(std::move(comparator)) {
+    }
+
+    [[nodiscard]] constexpr bool contains(SzT id) const noexcept {
+        return id < pos.size() && pos[id] != npos;
+    }
+
+    [[nodiscard]] constexpr KeyT const& key_of(SzT id) const noexcept {
+        assert(contains(id));
+        return heap[pos[id]].key;
+    }
+
+    constexpr void push(SzT id, KeyT key) {
+        assert(id != npos && !contains(id));
+        if (id >= pos.size())
+            pos.resize(static_cast<size_t>(id) + 1, npos);
+        heap.push_back({std::move(key), id});
+        _sift_up(heap.size() - 1);
+    }
+
+    /// @brief Lower the key of an id in the heap (key must not compare greater than the current)
+    constexpr void decrease_key(SzT id, KeyT key) {
+        assert(contains(id) && !comp(heap[pos[id]].key, key));
+        heap[pos[id]].key = std::move(key);
+        _sift_up(pos[id]);
+    }
+
+    /// @brief Push id or lower its key, returns false (and does nothing) if id already has a key
+    /// that is not greater: the Dijkstra/best-first relaxation step
+    constexpr bool push_or_decrease(SzT id, KeyT key) {
+        if (!contains(id))
+            push(id, std::move(key));
+        else if (comp(key, heap[pos[id]].key))
+            decrease_key(id, std::move(key));
+        else
+            return false;
+        return true;
+    }
+
+    [[nodiscard]] constexpr entry const& top() const noexcept {
+        assert(!heap.empty());
+        return heap[0];
+    }
+
+    constexpr entry pop() {
+        assert(!heap.empty());
+        entry res    = std::move(heap[0]);
+        pos[res.id]  = npos;
+        entry filler = std::move(heap.back());
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = std::move(filler);
+            _sift_down(0);
+        }
+        return res;
+    }
+
+    constexpr void erase(SzT id) {
+        assert(contains(id));
+        size_t slot  = pos[id];
+        pos[id]      = npos;
+        entry filler = std::move(heap.back());
+        heap.pop_back();
+        if (slot < heap.size()) {
+            heap[slot] = std::move(filler);
+            if (slot > 0 && comp(heap[slot].key, heap[(slot - 1) / D].key))
+                _sift_up(slot);
+            else
+                _sift_down(slot);
+        }
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return heap.empty();
+    }
+
+    [[nodiscard]] constexpr size_t size() const noexcept {
+        return heap.size();
+    }
+
+    /// @brief Remove all the entries in O(size()), the position map is kept
+    constexpr void clear() noexcept {
+        for (entry const& e : heap)
+            pos[e.id] = npos;
+        heap.clear();
+    }
+
+private:
+    std::vector<entry>          heap = {};
+    std::vector<SzT>            pos  = {};
+    [[no_unique_address]] CompT comp = {};
+
+    constexpr void _sift_up(size_t slot) {
+        entry moving = std::move(heap[slot]);
+        while (slot > 0) {
+            size_t parent = (slot - 1) / D;
+            if (!comp(moving.key, heap[parent].key))
+                break;
+            heap[slot]         = std::move(heap[parent]);
+            pos[heap[slot].id] = static_cast<SzT>(slot);
+            slot               = parent;
+        }
+        pos[moving.id] = static_cast<SzT>(slot);
+        heap[slot]     = std::move(moving);
+    }
+
+    constexpr void _sift_down(size_t slot) {
+        entry  moving = std::move(heap[slot]);
+        size_t sz     = heap.size();
+        for (;;) {
+            size_t first = slot * D + 1;
+            if (first >= sz)
+                break;
+            size_t best = first;
+            for (size_t c = first + 1; c < min(first + D, sz); ++c)
+                if (comp(heap[c].key, heap[best].key))
+                    best = c;
+            if (!comp(heap[best].key, moving.key))
+                break;
+            heap[slot]         = std::move(heap[best]);
+            pos[heap[slot].id] = static_cast<SzT>(slot);
+            slot               = best;
+        }
+        pos[moving.id] = static_cast<SzT>(slot);
+        heap[slot]     = std::move(moving);
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    CAV_BLOCK_PASS({
+        auto heap = IndexedHeap<int>(4);
+        for (uint32_t id = 0; id < 10; ++id)
+            heap.push(id, static_cast<int>(100 - id));
+        heap.decrease_key(5, 1);
+        assert(!heap.push_or_decrease(5, 50) && heap.push_or_decrease(7, 0));
+        heap.erase(9);
+        assert(heap.pop().id == 7 && heap.pop().id == 5 && heap.top().id == 8);
+        assert(heap.size() == 7 && !heap.contains(9) && heap.key_of(0) == 100);
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_DATASTRUCT_INDEXEDHEAP_HPP */
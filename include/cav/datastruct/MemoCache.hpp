@@ -0,0 +1,268 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_DATASTRUCT_MEMOCACHE_HPP
+#define CAV_INCLUDE_DATASTRUCT_MEMOCACHE_HPP
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../comptime/syntactic_sugars.hpp"
+#include "../comptime/test.hpp"
+#include "../mish/util_functions.hpp"
+
+namespace cav {
+
+/// @brief Fixed-capacity memoization cache for runtime keys (e.g. move or state hashes), the
+/// runtime counterpart of ClassCache: get(key, fallback) returns the cached value or computes it
+/// with fallback() and stores it. The table is set-associative: a key can only live in the Ways
+/// slots of the set selected by its hash, and a full set evicts with CLOCK (second chance). All
+/// the memory is allocated at construction in flat arrays, nothing is allocated per entry.
+///
+/// Returned references stay valid until the next insertion. Not thread-safe: use one cache per
+/// thread (e.g., thread_local) or ShardedMemoCache.
+///
+/// @tparam KeyT  Key type (default constructible, compared with KeyEqT)
+/// @tparam ValT  Value type (default constructible)
+/// @tparam Ways  Slots per set (1 is a direct-mapped cache)
+template <typename KeyT,
+          typename ValT,
+          int Ways     = 4,
+          typename HashT  = std::hash<KeyT>,
+          typename KeyEqT = std::equal_to<>>
+class MemoCache {
+    static_assert(Ways >= 1 && Ways <= 8, "A set uses 8-bit masks");
+
+    struct entry {
+        KeyT key = {};
+        ValT val = {};
+    };
+
+    struct set_meta {
+        uint8_t valid = 0;  // bit w: slot w holds an entry
+        uint8_t refs  = 0;  // bit w: slot w was hit since the clock hand last passed
+        uint8_t hand  = 0;
+    };
+
+public:
+    /// @brief Capacity for at least min_capacity entries (rounded up to whole power-of-two sets)
+    explicit constexpr MemoCache(size_t min_capacity, HashT hasher = {}, KeyEqT key_eq = {})
+        : hash(std::move(hasher))
+        , eq(std::move(key_eq))
+        , set_bits(std::bit_width(std::bit_ceil(max(min_capacity / Ways, size_t{1}))) - 1)
+        , metas(size_t{1} << set_bits)
+        , entries(metas.size() * Ways) {
+    }
+
+    /// @brief Cached value of key, computed with fallback() (and stored) on a miss. fallback can
+    /// use the cache recursively.
+    constexpr ValT& get(KeyT const& key, auto&& fallback) {
+        if (ValT* val = find(key))
+            return *val;
+        return set(key, FWD(fallback)());
+    }
+
+    [[nodiscard]] constexpr ValT* find(KeyT const& key) {
+        size_t    set_idx = _set_of(key);
+        set_meta& meta    = metas[set_idx];
+        entry*    ways    = &entries[set_idx * Ways];
+        unsigned  match   = _match(meta, ways, key);
+        if (match == 0) {
+            ++n_misses;
+            return nullptr;
+        }
+        meta.refs |= static_cast<uint8_t>(match);
+        ++n_hits;
+        return &ways[std::countr_zero(match)].val;
+    }
+
+    [[nodiscard]] constexpr bool has_value(KeyT const& key) const {
+        size_t set_idx = _set_of(key);
+        return _match(metas[set_idx], &entries[set_idx * Ways], key) != 0;
+    }
+
+    /// @brief Store (or overwrite) the value of key, evicting from its set if needed
+    constexpr ValT& set(KeyT const& key, auto&& val) {
+        size_t    set_idx = _set_of(key);
+        set_meta& meta    = metas[set_idx];
+        entry*    ways    = &entries[set_idx * Ways];
+
+        unsigned match = _match(meta, ways, key);
+        int      slot  = match != 0 ? std::countr_zero(match) : _victim(meta);
+
+        ways[slot].key = key;
+        ways[slot].val = FWD(val);
+        meta.valid |= static_cast<uint8_t>(1U << slot);
+        meta.refs &= static_cast<uint8_t>(~(1U << slot));
+        return ways[slot].val;
+    }
+
+    constexpr void clear() {
+        for (set_meta& meta : metas)
+            meta = {};
+        n_hits = n_misses = n_evictions = 0;
+    }
+
+    [[nodiscard]] constexpr size_t capacity() const {
+        return entries.size();
+    }
+
+    [[nodiscard]] constexpr uint64_t hits() const {
+        return n_hits;
+    }
+
+    [[nodiscard]] constexpr uint64_t misses() const {
+        return n_misses;
+    }
+
+    [[nodiscard]] constexpr uint64_t evictions() const {
+        return n_evictions;
+    }
+
+private:
+    [[no_unique_address]] HashT  hash;
+    [[no_unique_address]] KeyEqT eq;
+    int                          set_bits;
+    std::vector<set_meta>        metas;
+    std::vector<entry>           entries;
+    uint64_t                     n_hits      = 0;
+    uint64_t                     n_misses    = 0;
+    uint64_t                     n_evictions = 0;
+
+    /// @brief Fibonacci hashing on the high bits, std::hash of integers is the identity
+    [[nodiscard]] constexpr size_t _set_of(KeyT const& key) const {
+        auto mixed = static_cast<uint64_t>(hash(key)) * 0x9E3779B97F4A7C15ULL;
+        return set_bits == 0 ? 0 : static_cast<size_t>(mixed >> (64 - set_bits));
+    }
+
+    /// @brief Bit mask of the valid slots holding key. All the ways are compared without early
+    /// exits: the hit position is random, a branch per way would mispredict most of the times.
+    [[nodiscard]] constexpr unsigned _match(set_meta const& meta,
+                                            entry const*    ways,
+                                            KeyT const&     key) const {
+        unsigned match = 0;
+        for (int w = 0; w < Ways; ++w)
+            match |= static_cast<unsigned>(eq(ways[w].key, key)) << w;
+        return match & meta.valid;
+    }
+
+    /// @brief A free slot if any, otherwise the first slot from the hand without the ref bit
+    /// (clearing the ref bits it skips)
+    [[nodiscard]] constexpr int _victim(set_meta& meta) {
+        constexpr auto all = static_cast<uint8_t>((1U << Ways) - 1);
+        if (meta.valid != all)
+            return std::countr_one(meta.valid);
+        ++n_evictions;
+        for (;;) {
+            int  w    = meta.hand;
+            auto bit  = static_cast<uint8_t>(1U << w);
+            meta.hand = static_cast<uint8_t>((w + 1) % Ways);
+            if ((meta.refs & bit) == 0)
+                return w;
+            meta.refs &= static_cast<uint8_t>(~bit);
+        }
+    }
+};
+
+/// @brief Concurrent MemoCache split into Shards independently locked caches (the shard is picked
+/// by hash, so different shards see unrelated keys). Values are returned by copy and fallback runs
+/// outside the lock: two threads missing the same key at once may both compute it.
+template <typename KeyT,
+          typename ValT,
+          int Ways        = 4,
+          int Shards      = 16,
+          typename HashT  = std::hash<KeyT>,
+          typename KeyEqT = std::equal_to<>>
+class ShardedMemoCache {
+    using cache_t = MemoCache<KeyT, ValT, Ways, HashT, KeyEqT>;
+
+    struct alignas(64) shard {
+        std::mutex mtx;
+        cache_t    cache;
+
+        explicit shard(cache_t&& c)
+            : cache(std::move(c)) {
+        }
+    };
+
+public:
+    explicit ShardedMemoCache(size_t min_capacity, HashT hasher = {}, KeyEqT key_eq = {})
+        : hash(hasher) {
+        for (auto& shd : shards)
+            shd = std::make_unique<shard>(cache_t(max(min_capacity / Shards, size_t{1}),
+                                                  hasher,
+                                                  key_eq));
+    }
+
+    ValT get(KeyT const& key, auto&& fallback) {
+        shard& shd = _shard_of(key);
+        {
+            auto lock = std::scoped_lock(shd.mtx);
+            if (ValT* val = shd.cache.find(key))
+                return *val;
+        }
+        ValT val  = FWD(fallback)();
+        auto lock = std::scoped_lock(shd.mtx);
+        shd.cache.set(key, val);
+        return val;
+    }
+
+    void clear() {
+        for (auto& shd : shards) {
+            auto lock = std::scoped_lock(shd->mtx);
+            shd->cache.clear();
+        }
+    }
+
+private:
+    [[no_unique_address]] HashT                hash;
+    std::array<std::unique_ptr<shard>, Shards> shards;
+
+    /// @brief Low bits of the mixed hash (the caches use the high ones)
+    [[nodiscard]] shard& _shard_of(KeyT const& key) {
+        auto mixed = static_cast<uint64_t>(hash(key)) * 0x9E3779B97F4A7C15ULL;
+        return *shards[(mixed >> 32) % Shards];
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    CAV_BLOCK_PASS({
+        auto ident = [](uint64_t k) { return k; };  // std::hash is not constexpr
+        auto cache = MemoCache<uint64_t, int, 2, decltype(ident)>(4, ident);  // 2 sets of 2 ways
+        int  calls = 0;
+        auto fib   = [&](auto& self, uint64_t n) -> int {
+            return n < 2 ? static_cast<int>(n) : cache.get(n, [&] {
+                ++calls;
+                return self(self, n - 1) + self(self, n - 2);
+            });
+        };
+        assert(fib(fib, 20) == 6765);
+        assert(cache.capacity() == 4 && cache.evictions() > 0);
+        assert(cache.get(20, [] { return -1; }) == 6765);
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_DATASTRUCT_MEMOCACHE_HPP */
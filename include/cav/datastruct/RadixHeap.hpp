@@ -0,0 +1,145 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_DATASTRUCT_RADIXHEAP_HPP
+#define CAV_INCLUDE_DATASTRUCT_RADIXHEAP_HPP
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "../comptime/test.hpp"
+#include "../numeric/sort.hpp"
+
+namespace cav {
+
+/// @brief Monotone priority queue (e.g., for Dijkstra with non-negative weights): a pushed key
+/// must not be smaller than the last popped one. Keys are mapped to unsigned integers with the
+/// order-preserving conversions of Sorter (any integer, float or double), and an entry lives in
+/// the bucket given by the highest bit in which its key differs from the last popped key. A push
+/// is a bit_width and a push_back, a pop that finds the first bucket empty redistributes the
+/// next non-empty bucket once, so each entry moves at most once per key bit.
+///
+/// Ties are popped in LIFO order.
+template <typename KeyT, typename ValT>
+class RadixHeap {
+    using ukey_t = decltype(Sorter<>::_to_uint(std::declval<KeyT>()));
+
+    static constexpr size_t n_buckets = std::numeric_limits<ukey_t>::digits + 1;
+
+public:
+    using key_type   = KeyT;
+    using value_type = ValT;
+
+    struct entry {
+        KeyT key;
+        ValT val;
+    };
+
+    constexpr RadixHeap() = default;
+
+    constexpr void push(KeyT key, ValT val) {
+        ukey_t ukey = _ukey(key);
+        assert(ukey >= last && "RadixHeap keys must not be smaller than the last popped one");
+        buckets[_bucket_of(ukey)].push_back({key, std::move(val)});
+        ++sz;
+    }
+
+    /// @brief One of the entries with the minimum key (may redistribute a bucket)
+    [[nodiscard]] constexpr entry& top() {
+        _refill();
+        return buckets[0].back();
+    }
+
+    constexpr entry pop() {
+        _refill();
+        entry res = std::move(buckets[0].back());
+        buckets[0].pop_back();
+        --sz;
+        return res;
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return sz == 0;
+    }
+
+    [[nodiscard]] constexpr size_t size() const noexcept {
+        return sz;
+    }
+
+    /// @brief Remove all the entries and forget the last popped key (the bucket memory is kept)
+    constexpr void clear() noexcept {
+        for (auto& bucket : buckets)
+            bucket.clear();
+        last = 0;
+        sz   = 0;
+    }
+
+private:
+    std::array<std::vector<entry>, n_buckets> buckets = {};
+    ukey_t                                    last    = 0;
+    size_t                                    sz      = 0;
+
+    [[nodiscard]] static constexpr ukey_t _ukey(KeyT key) noexcept {
+        return Sorter<>::_to_uint(key);
+    }
+
+    [[nodiscard]] constexpr size_t _bucket_of(ukey_t ukey) const noexcept {
+        return static_cast<size_t>(std::bit_width(static_cast<ukey_t>(ukey ^ last)));
+    }
+
+    /// @brief Make bucket 0 non-empty: the smallest key of the first non-empty bucket becomes the
+    /// new last key, and that bucket entries all fall in the lower buckets
+    constexpr void _refill() {
+        assert(sz > 0 && "RadixHeap is empty");
+        if (!buckets[0].empty())
+            return;
+
+        size_t b = 1;
+        while (buckets[b].empty())
+            ++b;
+        std::vector<entry>& src = buckets[b];
+        last                    = _ukey(src[0].key);
+        for (entry const& e : src)
+            last = min(last, _ukey(e.key));
+        for (entry& e : src)
+            buckets[_bucket_of(_ukey(e.key))].push_back(std::move(e));
+        src.clear();
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    CAV_BLOCK_PASS({
+        auto heap = RadixHeap<double, int>();
+        heap.push(3.5, 0);
+        heap.push(-1.0, 1);
+        heap.push(7.0, 2);
+        assert(heap.pop().val == 1 && heap.top().key == 3.5);
+        heap.push(3.5, 3);
+        heap.push(4.0, 4);
+        assert(heap.pop().key == 3.5 && heap.pop().key == 3.5 && heap.pop().val == 4);
+        assert(heap.size() == 1 && heap.pop().key == 7.0 && heap.empty());
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_DATASTRUCT_RADIXHEAP_HPP */
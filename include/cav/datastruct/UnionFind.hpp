@@ -1,8 +1,14 @@
 #ifndef CAV_INCLUDE_UNIONFIND_HPP
 #define CAV_INCLUDE_UNIONFIND_HPP
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <utility>
 #include <vector>
 
 namespace cav {
@@ -28,12 +34,15 @@ public:
         return old_size;
     }
 
+    /// @brief Iterative find with path halving (no recursion, one pass)
     [[nodiscard]] Int find(Int n) {
         assert(static_cast<size_t>(n) < nodes.size());
-        Int& p = nodes[n].parent;
-        if (n != p)
-            p = find(p);
-        return p;
+        while (nodes[n].parent != n) {
+            Int gp          = nodes[nodes[n].parent].parent;
+            nodes[n].parent = gp;
+            n               = gp;
+        }
+        return n;
     }
 
     inline bool link_nodes(Int r1, Int r2) {
@@ -77,6 +86,238 @@ private:
     std::vector<Node> nodes;
     size_t            components_num = 0;
 };
+
+/// @brief UnionFind variant with split parent/rank arrays (SoA) and union by rank, with the rank in
+/// a small integer (ranks are bounded by log2(size)). Fewer bytes per hop than UnionFind, but no
+/// component sizes.
+template <typename Int = size_t, typename RankT = uint8_t>
+class CompactUnionFind {
+public:
+    explicit CompactUnionFind(Int size)
+        : parents(size)
+        , ranks(size, 0)
+        , components_num(size) {
+        std::iota(parents.begin(), parents.end(), Int{0});
+    }
+
+    inline Int make_set() {
+        Int old_size = parents.size();
+        parents.push_back(old_size);
+        ranks.push_back(0);
+        ++components_num;
+        return old_size;
+    }
+
+    /// @brief Iterative find with path halving
+    [[nodiscard]] Int find(Int n) {
+        assert(static_cast<size_t>(n) < parents.size());
+        while (parents[n] != n) {
+            Int gp     = parents[parents[n]];
+            parents[n] = gp;
+            n          = gp;
+        }
+        return n;
+    }
+
+    /// @brief Link two roots, returns true if they were already the same (as UnionFind)
+    inline bool link_nodes(Int r1, Int r2) {
+        assert(static_cast<size_t>(r1) < parents.size());
+        assert(static_cast<size_t>(r2) < parents.size());
+        if (r1 == r2)
+            return true;
+
+        if (ranks[r1] < ranks[r2])
+            std::swap(r1, r2);
+        parents[r2] = r1;
+        if (ranks[r1] == ranks[r2]) {
+            assert(ranks[r1] < std::numeric_limits<RankT>::max());
+            ++ranks[r1];
+        }
+        assert(components_num > 1);
+        --components_num;
+        return false;
+    }
+
+    inline bool union_nodes(Int n1, Int n2) {
+        return link_nodes(find(n1), find(n2));
+    }
+
+    [[nodiscard]] size_t get_components_num() const {
+        return components_num;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return parents.size();
+    }
+
+private:
+    std::vector<Int>   parents;
+    std::vector<RankT> ranks;
+    size_t             components_num = 0;
+};
+
+/// @brief UnionFind variant for backtracking searches: union by size and no path compression (so
+/// find is O(log n) and never writes), every link is pushed on an undo log. rollback(checkpoint())
+/// reverts the unions done in between in O(#unions), instead of copying the nodes. Nodes added by
+/// make_set are not removed by a rollback (they stay singletons).
+template <typename Int = size_t>
+class RollbackUnionFind {
+public:
+    struct Node {
+        Int size, parent;
+    };
+
+    /// @brief A link: child was a root and has been attached to root
+    struct Undo {
+        Int child, root;
+    };
+
+    using checkpoint_t = size_t;
+
+    explicit RollbackUnionFind(Int size)
+        : components_num(size) {
+        nodes.resize(size);
+        for (Int i = 0; i < size; ++i)
+            nodes[i] = {1, i};
+    }
+
+    inline Int make_set() {
+        Int old_size = nodes.size();
+        nodes.push_back({1, old_size});
+        ++components_num;
+        return old_size;
+    }
+
+    [[nodiscard]] Int find(Int n) const {
+        assert(static_cast<size_t>(n) < nodes.size());
+        while (nodes[n].parent != n)
+            n = nodes[n].parent;
+        return n;
+    }
+
+    /// @brief Link two roots, returns true if they were already the same (as UnionFind)
+    inline bool link_nodes(Int r1, Int r2) {
+        assert(static_cast<size_t>(r1) < nodes.size());
+        assert(static_cast<size_t>(r2) < nodes.size());
+        if (r1 == r2)
+            return true;
+
+        if (nodes[r1].size < nodes[r2].size)
+            std::swap(r1, r2);
+        nodes[r2].parent = r1;
+        nodes[r1].size += nodes[r2].size;
+        undo_log.push_back({r2, r1});
+        assert(components_num > 1);
+        --components_num;
+        return false;
+    }
+
+    inline bool union_nodes(Int n1, Int n2) {
+        return link_nodes(find(n1), find(n2));
+    }
+
+    /// @brief Current position in the undo log, to be passed to rollback
+    [[nodiscard]] checkpoint_t checkpoint() const {
+        return undo_log.size();
+    }
+
+    /// @brief Revert (in reverse order) every union done after cp was taken
+    void rollback(checkpoint_t cp) {
+        assert(cp <= undo_log.size());
+        while (undo_log.size() > cp) {
+            auto [child, root] = undo_log.back();
+            undo_log.pop_back();
+            nodes[root].size -= nodes[child].size;
+            nodes[child].parent = child;
+            ++components_num;
+        }
+    }
+
+    [[nodiscard]] Int get_comp_size(Int n) const {
+        return nodes[find(n)].size;
+    }
+
+    [[nodiscard]] size_t get_components_num() const {
+        return components_num;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return nodes.size();
+    }
+
+private:
+    std::vector<Node> nodes;
+    std::vector<Undo> undo_log;
+    size_t            components_num = 0;
+};
+
+/// @brief Lock-free union-find for concurrent unions and finds (e.g., parallel connected
+/// components or the filtering step of a parallel Kruskal). Roots are linked by index (the
+/// larger under the smaller, with a CAS on its parent) and finds do path halving with CAS, so
+/// parents only decrease and no cycle can form. The set of elements is fixed at construction.
+template <typename Int = size_t>
+class ConcurrentUnionFind {
+public:
+    explicit ConcurrentUnionFind(Int size)
+        : parents(std::make_unique<std::atomic<Int>[]>(size))
+        , sz(size)
+        , components_num(size) {
+        for (Int i = 0; i < size; ++i)
+            parents[i].store(i, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] Int find(Int n) {
+        assert(static_cast<size_t>(n) < sz);
+        Int p = parents[n].load(std::memory_order_acquire);
+        while (p != n) {
+            Int gp = parents[p].load(std::memory_order_acquire);
+            if (gp != p)  // halving, a failed CAS means somebody else already moved n up
+                parents[n].compare_exchange_weak(p, gp, std::memory_order_acq_rel);
+            n = gp;
+            p = parents[n].load(std::memory_order_acquire);
+        }
+        return n;
+    }
+
+    /// @brief Returns true if n1 and n2 were already in the same set (as UnionFind)
+    inline bool union_nodes(Int n1, Int n2) {
+        for (;;) {
+            Int r1 = find(n1), r2 = find(n2);
+            if (r1 == r2)
+                return true;
+            if (r1 < r2)
+                std::swap(r1, r2);
+            if (parents[r1].compare_exchange_strong(r1, r2, std::memory_order_acq_rel)) {
+                components_num.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+    }
+
+    /// @brief Linearizable check: retries if a root changed in the meantime
+    [[nodiscard]] bool same_set(Int n1, Int n2) {
+        for (;;) {
+            Int r1 = find(n1), r2 = find(n2);
+            if (r1 == r2)
+                return true;
+            if (parents[r1].load(std::memory_order_acquire) == r1)
+                return false;
+        }
+    }
+
+    [[nodiscard]] size_t get_components_num() const {
+        return components_num.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] size_t size() const {
+        return sz;
+    }
+
+private:
+    std::unique_ptr<std::atomic<Int>[]> parents;
+    size_t                              sz;
+    std::atomic<size_t>                 components_num;
+};
 }  // namespace cav
 
 #endif /* CAV_INCLUDE_UNIONFIND_HPP */
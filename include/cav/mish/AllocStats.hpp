@@ -0,0 +1,392 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_MISH_ALLOCSTATS_HPP
+#define CAV_INCLUDE_MISH_ALLOCSTATS_HPP
+
+/// Allocation accounting of the library containers (OwnSpan, SoAArray, OffsetVec) and of the
+/// Sorter buffers. Each allocation point calls CAV_ALLOC_RECORD(Tag, event, bytes...) with the
+/// container type as tag: allocations, frees, reallocations (buffer growths) and bytes are
+/// accumulated into counters private to the calling thread (one cache line per tag, no atomic
+/// RMW), the live and peak bytes of each tag (and of all of them) in shared relaxed atomics. The
+/// per-tag totals are printed to stderr at exit, sorted by peak bytes.
+///
+/// Compiled in only when CAV_ALLOC_STATS is defined, otherwise CAV_ALLOC_RECORD expands to
+/// nothing. Allocations done during constant evaluation are never recorded. Memory adopted from
+/// outside (e.g., OwnSpan(ptr, size, deleter)) counts as allocated when adopted, since it is
+/// released through the container.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../comptime/macros.hpp"
+
+#ifdef CAV_ALLOC_STATS
+#define CAV_ALLOC_RECORD(TagT, event, ...)                   \
+    do {                                                     \
+        if (!std::is_constant_evaluated())                   \
+            ::cav::AllocStats<TagT>::event(__VA_ARGS__);     \
+    } while (false)
+#else
+#define CAV_ALLOC_RECORD(TagT, event, ...) static_cast<void>(0)
+#endif
+
+namespace cav {
+
+/// @brief Maximum number of distinct allocation tags in a program, the tags past the last but
+/// one share the last slot (reported as "(other tags)")
+inline constexpr int max_alloc_tags = 256;
+
+/// @brief Counters of one tag for one thread. Only the owner thread writes (plain load+store, the
+/// atomics only make the concurrent reads of a report well defined).
+struct alignas(64) AllocCounters {
+    std::atomic<uint64_t> allocs      = 0;
+    std::atomic<uint64_t> frees       = 0;
+    std::atomic<uint64_t> reallocs    = 0;
+    std::atomic<uint64_t> alloc_bytes = 0;
+    std::atomic<uint64_t> freed_bytes = 0;
+
+    CAV_INLINE static void bump(std::atomic<uint64_t>& counter, uint64_t val) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + val, std::memory_order_relaxed);
+    }
+};
+
+/// @brief Shared live bytes of one tag and their high-water mark
+struct alignas(64) AllocLive {
+    std::atomic<int64_t> live = 0;
+    std::atomic<int64_t> peak = 0;
+
+    void add(int64_t delta) noexcept {
+        int64_t now  = live.fetch_add(delta, std::memory_order_relaxed) + delta;
+        int64_t high = peak.load(std::memory_order_relaxed);
+        while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed))
+            ;
+    }
+};
+
+struct alloc_tag_stats {
+    std::string_view name;
+    uint64_t         allocs      = 0;
+    uint64_t         frees       = 0;
+    uint64_t         reallocs    = 0;
+    uint64_t         alloc_bytes = 0;
+    uint64_t         freed_bytes = 0;
+    int64_t          live_bytes  = 0;
+    int64_t          peak_bytes  = 0;
+};
+
+/// @brief Global list of tag names, of the per-thread counter blocks and of the live bytes. It
+/// is never destroyed (containers may be freed by static destructors), the report is printed by
+/// an atexit handler.
+class AllocRegistry {
+public:
+    [[nodiscard]] static AllocRegistry& get() {
+        static AllocRegistry* registry = [] {
+            auto* reg = new AllocRegistry();
+            std::atexit([] {
+                if (get().report_at_exit)
+                    get().report(stderr);
+            });
+            return reg;
+        }();
+        return *registry;
+    }
+
+    AllocRegistry(AllocRegistry const&)            = delete;
+    AllocRegistry& operator=(AllocRegistry const&) = delete;
+
+    [[nodiscard]] int add_tag(std::string_view name) {
+        constexpr auto overflow_id = size_t{max_alloc_tags - 1};
+        auto           lock        = std::scoped_lock(mtx);
+        if (names.size() < overflow_id)
+            names.push_back(name);
+        else if (names.size() == overflow_id)
+            names.emplace_back("(other tags)");
+        return static_cast<int>(std::min(names.size(), overflow_id + 1)) - 1;
+    }
+
+    /// @brief A counters block for a new thread (a block released by an exited thread if any,
+    /// its counts are kept)
+    [[nodiscard]] AllocCounters* acquire_block() {
+        auto lock = std::scoped_lock(mtx);
+        if (!free_blocks.empty()) {
+            AllocCounters* block = free_blocks.back();
+            free_blocks.pop_back();
+            return block;
+        }
+        return blocks.emplace_back(std::make_unique<AllocCounters[]>(max_alloc_tags)).get();
+    }
+
+    void release_block(AllocCounters* block) {
+        auto lock = std::scoped_lock(mtx);
+        free_blocks.push_back(block);
+    }
+
+    /// @brief Counters of the threads whose thread_local storage is already gone (atomic RMW)
+    [[nodiscard]] AllocCounters* orphan_block() noexcept {
+        return orphans.get();
+    }
+
+    [[nodiscard]] AllocLive& live_of(int tag) noexcept {
+        return live[static_cast<size_t>(tag)];
+    }
+
+    [[nodiscard]] AllocLive& total_live() noexcept {
+        return total;
+    }
+
+    /// @brief Totals of all the threads, one entry per tag, by decreasing peak bytes
+    [[nodiscard]] std::vector<alloc_tag_stats> snapshot() const {
+        auto lock  = std::scoped_lock(mtx);
+        auto stats = std::vector<alloc_tag_stats>(names.size());
+        for (size_t t = 0; t < names.size(); ++t) {
+            stats[t].name       = names[t];
+            stats[t].live_bytes = live[t].live.load(std::memory_order_relaxed);
+            stats[t].peak_bytes = live[t].peak.load(std::memory_order_relaxed);
+            _accumulate(orphans[t], stats[t]);
+            for (auto const& block : blocks)
+                _accumulate(block[t], stats[t]);
+        }
+        std::ranges::sort(stats, std::greater<>{}, &alloc_tag_stats::peak_bytes);
+        return stats;
+    }
+
+    /// @brief Peak of the bytes live at the same time, all tags together
+    [[nodiscard]] int64_t total_peak_bytes() const noexcept {
+        return total.peak.load(std::memory_order_relaxed);
+    }
+
+    void report(std::FILE* out) const {
+        auto stats = snapshot();
+        if (stats.empty())
+            return;
+        std::fprintf(out,
+                     "%-40s %10s %10s %10s %12s %12s %12s\n",
+                     "allocation tag",
+                     "allocs",
+                     "frees",
+                     "reallocs",
+                     "total MiB",
+                     "live MiB",
+                     "peak MiB");
+        for (alloc_tag_stats const& st : stats)
+            std::fprintf(out,
+                         "%-40.*s %10llu %10llu %10llu %12.3f %12.3f %12.3f\n",
+                         static_cast<int>(st.name.size()),
+                         st.name.data(),
+                         static_cast<unsigned long long>(st.allocs),
+                         static_cast<unsigned long long>(st.frees),
+                         static_cast<unsigned long long>(st.reallocs),
+                         _mib(static_cast<double>(st.alloc_bytes)),
+                         _mib(static_cast<double>(st.live_bytes)),
+                         _mib(static_cast<double>(st.peak_bytes)));
+        std::fprintf(out, "%-40s %12.3f MiB\n", "peak (all tags)", _mib(total_peak_bytes()));
+    }
+
+    /// @brief Print the report to stderr at exit (default true)
+    void set_report_at_exit(bool enable) {
+        report_at_exit = enable;
+    }
+
+private:
+    mutable std::mutex                            mtx;
+    std::vector<std::string_view>                 names;
+    std::vector<std::unique_ptr<AllocCounters[]>> blocks;
+    std::vector<AllocCounters*>                   free_blocks;
+    std::unique_ptr<AllocCounters[]>              orphans;
+    std::array<AllocLive, max_alloc_tags>         live           = {};
+    AllocLive                                     total          = {};
+    bool                                          report_at_exit = true;
+
+    AllocRegistry()
+        : orphans(std::make_unique<AllocCounters[]>(max_alloc_tags)) {
+    }
+
+    static void _accumulate(AllocCounters const& counters, alloc_tag_stats& st) {
+        st.allocs += counters.allocs.load(std::memory_order_relaxed);
+        st.frees += counters.frees.load(std::memory_order_relaxed);
+        st.reallocs += counters.reallocs.load(std::memory_order_relaxed);
+        st.alloc_bytes += counters.alloc_bytes.load(std::memory_order_relaxed);
+        st.freed_bytes += counters.freed_bytes.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] static double _mib(double bytes) noexcept {
+        return bytes / (1024.0 * 1024.0);
+    }
+};
+
+/// @brief Per-thread counters block, taken from the registry on first use and given back when
+/// the thread exits. Records made after that (by thread_local or static destructors) go to the
+/// shared orphan block.
+class ThreadAllocStats {
+public:
+    [[nodiscard]] static AllocCounters* local() {
+        if (status == state::active) [[likely]]
+            return current;
+        if (status == state::exited)
+            return nullptr;
+        thread_local ThreadAllocStats holder;
+        return current;
+    }
+
+    ThreadAllocStats(ThreadAllocStats const&)            = delete;
+    ThreadAllocStats& operator=(ThreadAllocStats const&) = delete;
+
+    ~ThreadAllocStats() {
+        AllocRegistry::get().release_block(std::exchange(current, nullptr));
+        status = state::exited;
+    }
+
+private:
+    enum class state : uint8_t {
+        fresh,
+        active,
+        exited
+    };
+
+    // Trivially destructible, so still usable after the holder is gone
+    static inline thread_local AllocCounters* current = nullptr;
+    static inline thread_local state          status  = state::fresh;
+
+    ThreadAllocStats() {
+        current = AllocRegistry::get().acquire_block();
+        status  = state::active;
+    }
+};
+
+namespace detail {
+    /// @brief Printable name of TagT, cut from the function signature (type_name.hpp cannot be
+    /// used here: it includes OwnSpan through util_functions)
+    template <typename TagT>
+    [[nodiscard]] std::string_view alloc_tag_name() noexcept {
+        auto   sig = std::string_view(std::source_location::current().function_name());
+        size_t beg = sig.find("TagT = ");
+        if (beg == std::string_view::npos)
+            return sig;
+        beg += 7;
+        size_t end = sig.find(';', beg);
+        end        = end != std::string_view::npos ? end : sig.rfind(']');
+        return sig.substr(beg, end - beg);
+    }
+}  // namespace detail
+
+/// @brief Recording functions of the allocations of a tag (usually the container type)
+template <typename TagT>
+struct AllocStats {
+    [[nodiscard]] static int tag_id() {
+        static int const id = AllocRegistry::get().add_tag(detail::alloc_tag_name<TagT>());
+        return id;
+    }
+
+    static void on_alloc(size_t bytes) {
+        int tag = tag_id();
+        _count(tag, &AllocCounters::allocs, 1);
+        _count(tag, &AllocCounters::alloc_bytes, bytes);
+        _live(tag, static_cast<int64_t>(bytes));
+    }
+
+    static void on_free(size_t bytes) {
+        int tag = tag_id();
+        _count(tag, &AllocCounters::frees, 1);
+        _count(tag, &AllocCounters::freed_bytes, bytes);
+        _live(tag, -static_cast<int64_t>(bytes));
+    }
+
+    /// @brief A buffer growth (the new allocation and the old release are recorded separately)
+    static void on_grow() {
+        _count(tag_id(), &AllocCounters::reallocs, 1);
+    }
+
+private:
+    static void _count(int tag, std::atomic<uint64_t> AllocCounters::*field, uint64_t val) {
+        if (AllocCounters* counters = ThreadAllocStats::local()) [[likely]]
+            AllocCounters::bump(counters[tag].*field, val);
+        else
+            (AllocRegistry::get().orphan_block()[tag].*field).fetch_add(val);
+    }
+
+    static void _live(int tag, int64_t delta) {
+        AllocRegistry& reg = AllocRegistry::get();
+        reg.live_of(tag).add(delta);
+        reg.total_live().add(delta);
+    }
+};
+
+/// @brief Allocator adaptor recording the (de)allocations of AllocT with CAV_ALLOC_RECORD, for
+/// containers whose memory is managed by a std container (e.g., OffsetVec)
+template <typename AllocT, typename TagT>
+struct AllocStatsAllocator : AllocT {
+    using base_traits = std::allocator_traits<AllocT>;
+    using value_type  = typename base_traits::value_type;
+
+    template <typename U>
+    struct rebind {
+        using other = AllocStatsAllocator<typename base_traits::template rebind_alloc<U>, TagT>;
+    };
+
+    constexpr AllocStatsAllocator() = default;
+
+    constexpr AllocStatsAllocator(AllocT const& alc)
+        : AllocT(alc) {
+    }
+
+    template <typename OtherT>
+    constexpr AllocStatsAllocator(AllocStatsAllocator<OtherT, TagT> const& other)
+        : AllocT(static_cast<OtherT const&>(other)) {
+    }
+
+    [[nodiscard]] constexpr value_type* allocate(size_t n) {
+        value_type* ptr = base_traits::allocate(*this, n);
+        CAV_ALLOC_RECORD(TagT, on_alloc, n * sizeof(value_type));
+        return ptr;
+    }
+
+    constexpr void deallocate(value_type* ptr, size_t n) {
+        CAV_ALLOC_RECORD(TagT, on_free, n * sizeof(value_type));
+        base_traits::deallocate(*this, ptr, n);
+    }
+
+    template <typename OtherT>
+    [[nodiscard]] constexpr bool operator==(AllocStatsAllocator<OtherT, TagT> const& other) const {
+        return static_cast<AllocT const&>(*this) == static_cast<OtherT const&>(other);
+    }
+};
+
+#ifdef CAV_ALLOC_STATS
+inline constexpr bool alloc_stats_enabled = true;
+#else
+inline constexpr bool alloc_stats_enabled = false;
+#endif
+
+/// @brief AllocT wrapped in AllocStatsAllocator only when CAV_ALLOC_STATS is defined
+template <typename AllocT, typename TagT>
+using alloc_stats_allocator_t =
+    std::conditional_t<alloc_stats_enabled, AllocStatsAllocator<AllocT, TagT>, AllocT>;
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_MISH_ALLOCSTATS_HPP */
@@ -20,7 +20,14 @@
 #define CAV_INCLUDEs_CHRONO_HPP
 
 #include <chrono>
+#include <cstdint>
+#include <ratio>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "../comptime/macros.hpp"
 #include "../comptime/test.hpp"
 
 namespace cav {
@@ -81,6 +88,101 @@ struct Chrono {
     }
 };
 
+/// @brief Raw cycle counter: the TSC on x86 (invariant on any recent CPU), the virtual counter on
+/// ARM64, steady_clock ticks elsewhere. A few ns to read, not serializing (fine for zones that are
+/// at least some hundred cycles long).
+[[nodiscard]] CAV_INLINE inline uint64_t read_cycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t val = 0;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(val));
+    return val;
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/// @brief Frequency of read_cycles(). On x86 it is calibrated against steady_clock once (busy
+/// waiting ~10ms on the first call), the other counters report it directly.
+[[nodiscard]] inline double cycles_per_sec() noexcept {
+    static double const freq = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        using clock     = std::chrono::steady_clock;
+        auto     t_beg  = clock::now();
+        uint64_t c_beg  = read_cycles();
+        auto     t_end  = t_beg;
+        while ((t_end = clock::now()) - t_beg < std::chrono::milliseconds(10)) {
+        }
+        uint64_t c_end  = read_cycles();
+        double   secs   = std::chrono::duration<double>(t_end - t_beg).count();
+        return static_cast<double>(c_end - c_beg) / secs;
+#elif defined(__aarch64__)
+        uint64_t val = 0;
+        asm volatile("mrs %0, cntfrq_el0" : "=r"(val));
+        return static_cast<double>(val);
+#else
+        using period = std::chrono::steady_clock::period;
+        return static_cast<double>(period::den) / static_cast<double>(period::num);
+#endif
+    }();
+    return freq;
+}
+
+/// @brief Convert a number of read_cycles() ticks into UnitT
+template <typename UnitT = usec>
+[[nodiscard]] inline double cycles_to(uint64_t cycles) noexcept {
+    using period = typename UnitT::period;
+    return static_cast<double>(cycles) * period::den / (period::num * cycles_per_sec());
+}
+
+/// @brief Chrono drop-in for hot loops: it stores raw cycle counts and reads the cycle counter
+/// instead of calling clock::now() (conversion to UnitT happens only when a time is returned).
+template <typename UnitT = usec>
+struct CycleChrono {
+    uint64_t start;
+    uint64_t last;
+
+    CycleChrono()
+        : start(read_cycles())
+        , last(start) {
+    }
+
+    template <typename UnitT2>
+    [[nodiscard]] static constexpr double time_cast(double t) {
+        return Chrono<UnitT>::template time_cast<UnitT2>(t);
+    }
+
+    void restart() {
+        start = last = read_cycles();
+    }
+
+    /// @brief Cycles from the last lap (or restart), without any conversion
+    uint64_t lap_cycles() {
+        uint64_t old_last = last;
+        last              = read_cycles();
+        return last - old_last;
+    }
+
+    uint64_t lap() {
+        return static_cast<uint64_t>(cycles_to<UnitT>(lap_cycles()));
+    }
+
+    [[nodiscard]] uint64_t from_start() const {
+        return static_cast<uint64_t>(cycles_to<UnitT>(read_cycles() - start));
+    }
+
+    template <typename UnitT2>
+    [[nodiscard]] double from_start() const {
+        return cycles_to<UnitT2>(read_cycles() - start);
+    }
+
+    template <typename UnitT2>
+    [[nodiscard]] double lap() {
+        return cycles_to<UnitT2>(lap_cycles());
+    }
+};
+
 #ifdef CAV_COMP_TESTS
 namespace {
     CAV_PASS(Chrono<nsec>::template time_cast<usec>(1) == 1e-3);
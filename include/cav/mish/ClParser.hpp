@@ -22,6 +22,7 @@
 #include "cav/comptime/type_name.hpp"
 #include "cav/mish/errors.hpp"
 #include "cav/mish/util_functions.hpp"
+#include "cav/string/PerfectHash.hpp"
 #include "cav/string/StaticStr.hpp"
 #include "cav/string/string_utils.hpp"
 #include "cav/tuplish/type_map.hpp"
@@ -30,6 +31,21 @@ namespace cav {
 
 static constexpr char spaces[] = " \t\n\v\f\r";
 
+namespace detail {
+    [[nodiscard]] static constexpr std::string_view get_flag_name(auto args_it) {
+        auto   str = std::string_view(*args_it);
+        size_t beg = str.find_first_not_of(SPACES);  // remove heading spaces
+        if (str[beg] != '-')
+            exit_with_message("Error parsing cli arguments: {}", str.substr(beg));
+
+        beg       = str.find_first_not_of('-', beg);         // remove heading '-'s
+        size_t sz = str.find_first_of(SPACES, beg) - beg;  // get first word size
+
+        // check if equal to flag
+        return str.substr(beg, sz);
+    }
+}  // namespace detail
+
 /// @brief A command-line argument parser that uses a type_map to manage values.
 /// It parses command-line arguments into a map of key-value pairs, where the keys are the first
 /// flag of the arguments and the values are the parsed argument values. It supports both positional
@@ -47,11 +63,16 @@ struct ClParser : type_map<ArTs...> {
         parse_cli(args);
     }
 
+    /// @brief Each token flag is looked up once in a compile-time perfect hash of all the flags,
+    /// then only the matching argument parses its value
     template <typename T>
     constexpr void parse_cli(std::span<T> const& args) {
-        for (auto it = args.begin() + 1; it != args.end();)
-            if (!base::for_each([&](auto& arg) { return arg.try_consume(it); }))
+        for (auto it = args.begin() + 1; it != args.end();) {
+            int flag = flag_index.find(detail::get_flag_name(it));
+            if (flag < 0)
                 exit_with_message("Error: unknown argument: {}\n", *it);
+            base::visit_idx(arg_of_flag[flag], [&](auto& arg) { arg.consume(it); });
+        }
     }
 
     template <size_t FlagSz = 0, size_t DescrSz = 24>
@@ -71,6 +92,25 @@ struct ClParser : type_map<ArTs...> {
     }
 
 private:
+    static constexpr size_t n_flags = (ArTs::value_t::flag_names.size() + ... + 0);
+
+    static constexpr auto flag_index = []() consteval {
+        auto names = std::array<std::string_view, n_flags>{};
+        auto it    = names.begin();
+        ((it = std::ranges::copy(ArTs::value_t::flag_names, it).out), ...);
+        return PerfectStrHash(names);
+    }();
+
+    static constexpr auto arg_of_flag = []() consteval {
+        auto   args = std::array<size_t, max(n_flags, size_t{1})>{};
+        size_t flag = 0;
+        size_t arg  = 0;
+        ((std::fill_n(args.begin() + flag, ArTs::value_t::flag_names.size(), arg++),
+          flag += ArTs::value_t::flag_names.size()),
+         ...);
+        return args;
+    }();
+
     template <typename T>
     static constexpr decl_auto _wrap_enum(T&& val) {
         if constexpr (std::is_enum_v<no_cvr<T>>)
@@ -80,21 +120,6 @@ private:
     }
 };
 
-namespace detail {
-    [[nodiscard]] static constexpr std::string_view get_flag_name(auto args_it) {
-        auto   str = std::string_view(*args_it);
-        size_t beg = str.find_first_not_of(SPACES);  // remove heading spaces
-        if (str[beg] != '-')
-            exit_with_message("Error parsing cli arguments: {}", str.substr(beg));
-
-        beg       = str.find_first_not_of('-', beg);              // remove heading '-'s
-        size_t sz = str.find_last_not_of(SPACES, beg) - beg + 1;  // get first word size
-
-        // check if equal to flag
-        return str.substr(beg, sz);
-    }
-}  // namespace detail
-
 /// @brief A command-line argument that can be parsed by ClParser.
 /// @tparam T The type of the argument value.
 /// @tparam D The default value of the argument.
@@ -108,15 +133,21 @@ struct ClArg {
 
     struct value_t {
         T                     value;
-        static constexpr auto flags = ((Fs + "|") + ... + F);
-        static constexpr auto descr = Des + " (" + type_name<T>::local_name + ")";
+        static constexpr auto flags      = ((Fs + "|") + ... + F);
+        static constexpr auto descr      = Des + " (" + type_name<T>::local_name + ")";
+        static constexpr auto flag_names = std::array<std::string_view, 1 + sizeof...(Fs)>{F,
+                                                                                           Fs...};
 
         constexpr bool try_consume(auto& args_it) {
             // check if equal to flag
             if (auto w = detail::get_flag_name(args_it); ((w != F) && ... && (w != Fs)))
                 return false;
+            consume(args_it);
+            return true;
+        }
 
-            // if yes, parse the next word as T
+        /// @brief Parse the word after the flag (already matched) as T
+        constexpr void consume(auto& args_it) {
             ++args_it;
             auto   str = std::string_view(*args_it);
             size_t beg = str.find_first_not_of(spaces);
@@ -124,8 +155,6 @@ struct ClArg {
 
             from_string_view_checked<T>(str.substr(beg, sz), value);
             ++args_it;
-
-            return true;
         }
     } value = {D.value};
 
@@ -144,14 +173,21 @@ struct ClArg<void, D, Des, F, Fs...> {
 
     struct value_t {
         bool                  value;
-        static constexpr auto flags = ((Fs + "|") + ... + F);
-        static constexpr auto descr = Des;
+        static constexpr auto flags      = ((Fs + "|") + ... + F);
+        static constexpr auto descr      = Des;
+        static constexpr auto flag_names = std::array<std::string_view, 1 + sizeof...(Fs)>{F,
+                                                                                           Fs...};
 
         constexpr bool try_consume(auto& args_it) {
             if (auto w = detail::get_flag_name(args_it); ((w != F) && ... && (w != Fs)))
                 return false;
+            consume(args_it);
+            return true;
+        }
+
+        constexpr void consume(auto& args_it) {
             ++args_it;
-            return value = true;
+            value = true;
         }
     } value = {D.value};
 
@@ -0,0 +1,184 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_MISH_LATENCYHISTOGRAM_HPP
+#define CAV_INCLUDE_MISH_LATENCYHISTOGRAM_HPP
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+
+#include "../comptime/test.hpp"
+#include "../numeric/limits.hpp"
+#include "Chrono.hpp"
+#include "util_functions.hpp"
+
+namespace cav {
+
+/// @brief Fixed-size log-linear (HDR-style) histogram of non-negative integer durations, e.g.
+/// Chrono::lap() values. Values below 2^SubBits have their own bucket, above that every power of
+/// two range is split into 2^(SubBits-1) buckets, so the relative error of the reported
+/// percentiles is below 2^(1-SubBits) (~3% with the default) over the whole uint64_t range.
+/// Recording is O(1), never allocates, and histograms of different threads can be merged.
+///
+/// @tparam SubBits Precision of the buckets
+template <int SubBits = 6>
+class LatencyHistogram {
+    static_assert(SubBits >= 1 && SubBits <= 16, "Unreasonable histogram precision");
+
+    static constexpr int      half_bits  = SubBits - 1;
+    static constexpr uint64_t linear_max = uint64_t{1} << SubBits;
+
+public:
+    static constexpr size_t n_buckets = size_t{64 - SubBits + 2} << half_bits;
+
+    /// @brief Bucket of a value: the power of two group selects the shift of the sub-bucket
+    [[nodiscard]] static constexpr size_t bucket_of(uint64_t val) noexcept {
+        int grp = max(0, static_cast<int>(std::bit_width(val)) - SubBits);
+        return (static_cast<size_t>(grp) << half_bits) + static_cast<size_t>(val >> grp);
+    }
+
+    /// @brief Largest value mapped to bucket idx
+    [[nodiscard]] static constexpr uint64_t bucket_upper(size_t idx) noexcept {
+        if (idx < linear_max)
+            return idx;
+        int      grp = static_cast<int>(idx >> half_bits) - 1;
+        uint64_t sub = idx - (static_cast<size_t>(grp) << half_bits);
+        return ((sub + 1) << grp) - 1;
+    }
+
+    constexpr void record(uint64_t val) noexcept {
+        record_n(val, 1);
+    }
+
+    constexpr void record_n(uint64_t val, uint64_t count) noexcept {
+        buckets[bucket_of(val)] += count;
+        total += count;
+        min_val = min(min_val, val);
+        max_val = max(max_val, val);
+    }
+
+    /// @brief Record (and return) the next lap of a Chrono/CycleChrono, in its unit
+    template <typename ChronoT>
+    uint64_t record_lap(ChronoT& chrono) {
+        uint64_t lap = chrono.lap();
+        record(lap);
+        return lap;
+    }
+
+    constexpr void merge(LatencyHistogram const& other) noexcept {
+        for (size_t i = 0; i < n_buckets; ++i)
+            buckets[i] += other.buckets[i];
+        total += other.total;
+        min_val = min(min_val, other.min_val);
+        max_val = max(max_val, other.max_val);
+    }
+
+    constexpr void reset() noexcept {
+        *this = {};
+    }
+
+    [[nodiscard]] constexpr uint64_t count() const noexcept {
+        return total;
+    }
+
+    [[nodiscard]] constexpr uint64_t min_value() const noexcept {
+        return total == 0 ? 0 : min_val;
+    }
+
+    [[nodiscard]] constexpr uint64_t max_value() const noexcept {
+        return max_val;
+    }
+
+    /// @brief Smallest bucket upper bound with at least perc% of the values at or below it
+    /// (clamped to the recorded range), 0 if empty
+    [[nodiscard]] constexpr uint64_t percentile(double perc) const noexcept {
+        assert(perc >= 0.0 && perc <= 100.0);
+        if (total == 0)
+            return 0;
+        auto rank = static_cast<uint64_t>(perc / 100.0 * static_cast<double>(total) + 0.5);
+        rank      = max(rank, uint64_t{1});
+        uint64_t seen = 0;
+        for (size_t i = 0; i < n_buckets; ++i) {
+            seen += buckets[i];
+            if (seen >= rank)
+                return max(min_val, min(bucket_upper(i), max_val));
+        }
+        return max_val;
+    }
+
+    [[nodiscard]] constexpr uint64_t p50() const noexcept {
+        return percentile(50.0);
+    }
+
+    [[nodiscard]] constexpr uint64_t p99() const noexcept {
+        return percentile(99.0);
+    }
+
+    [[nodiscard]] constexpr uint64_t p999() const noexcept {
+        return percentile(99.9);
+    }
+
+    /// @brief Mean estimated from the bucket midpoints
+    [[nodiscard]] constexpr double mean() const noexcept {
+        if (total == 0)
+            return 0.0;
+        double sum = 0.0;
+        for (size_t i = 0; i < n_buckets; ++i) {
+            if (buckets[i] == 0)
+                continue;
+            uint64_t low = i == 0 ? 0 : bucket_upper(i - 1) + 1;
+            double   mid = 0.5 * (static_cast<double>(low) + static_cast<double>(bucket_upper(i)));
+            sum += mid * static_cast<double>(buckets[i]);
+        }
+        return sum / static_cast<double>(total);
+    }
+
+private:
+    std::array<uint64_t, n_buckets> buckets = {};
+    uint64_t                        total   = 0;
+    uint64_t                        min_val = type_max<uint64_t>;
+    uint64_t                        max_val = 0;
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    using hist_t = LatencyHistogram<4>;
+    CAV_PASS(hist_t::bucket_of(15) == 15 && hist_t::bucket_of(16) == 16);
+    CAV_PASS(hist_t::bucket_of(17) == 16 && hist_t::bucket_of(18) == 17);
+    CAV_PASS(hist_t::bucket_upper(16) == 17 && hist_t::bucket_upper(23) == 31);
+    CAV_PASS(hist_t::bucket_of(type_max<uint64_t>) == hist_t::n_buckets - 1);
+    CAV_PASS(hist_t::bucket_upper(hist_t::n_buckets - 1) == type_max<uint64_t>);
+
+    CAV_BLOCK_PASS({
+        auto hist = LatencyHistogram<>();
+        for (uint64_t i = 1; i <= 1000; ++i)
+            hist.record(i);
+        assert(hist.count() == 1000 && hist.max_value() == 1000 && hist.min_value() == 1);
+        assert(hist.p50() >= 500 && hist.p50() <= 500 + 500 / 32);
+        assert(hist.p99() >= 990 && hist.p999() == 1000);
+
+        auto other = LatencyHistogram<>();
+        other.record_n(1'000'000, 10);
+        hist.merge(other);
+        assert(hist.max_value() == 1'000'000 && hist.percentile(100.0) == 1'000'000);
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_MISH_LATENCYHISTOGRAM_HPP */
@@ -0,0 +1,231 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_MISH_PROFILER_HPP
+#define CAV_INCLUDE_MISH_PROFILER_HPP
+
+/// Scoped-zone profiler for hot paths. CAV_PROFILE_SCOPE("name") times the rest of the enclosing
+/// scope with read_cycles() and accumulates calls and cycles into counters private to the calling
+/// thread (one cache line per zone, no atomic RMW, no locks after the first call). The totals of
+/// all the threads are printed to stderr at exit. Nested zones measure inclusive times.
+///
+/// Zones are compiled in only when CAV_PROFILE is defined, otherwise the macro expands to nothing.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "../comptime/macros.hpp"
+#include "Chrono.hpp"
+
+#ifdef CAV_PROFILE
+#define CAV_PROFILE_SCOPE(name)                                              \
+    static ::cav::ProfileSite const CAV_CONCAT(cav_prof_site_, __LINE__){name}; \
+    ::cav::ProfileZone const CAV_CONCAT(cav_prof_zone_, __LINE__) {            \
+        CAV_CONCAT(cav_prof_site_, __LINE__)                                   \
+    }
+#else
+#define CAV_PROFILE_SCOPE(name) static_cast<void>(0)
+#endif
+
+namespace cav {
+
+/// @brief Maximum number of CAV_PROFILE_SCOPE sites in a program, the sites past the last but
+/// one share the last zone (reported as "(other zones)")
+inline constexpr int max_profile_zones = 256;
+
+/// @brief Counters of one zone for one thread. Only the owner thread writes (plain load+store,
+/// the atomics only make the concurrent reads of a report well defined).
+struct alignas(64) ZoneCounters {
+    std::atomic<uint64_t> calls  = 0;
+    std::atomic<uint64_t> cycles = 0;
+
+    CAV_INLINE void add(uint64_t cyc) noexcept {
+        calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        cycles.store(cycles.load(std::memory_order_relaxed) + cyc, std::memory_order_relaxed);
+    }
+};
+
+struct zone_stats {
+    std::string_view name;
+    uint64_t         calls  = 0;
+    uint64_t         cycles = 0;
+};
+
+/// @brief Global list of zone names and of the live threads counters, it reports at exit
+class ProfileRegistry {
+public:
+    [[nodiscard]] static ProfileRegistry& get() {
+        static ProfileRegistry registry;
+        return registry;
+    }
+
+    ProfileRegistry(ProfileRegistry const&)            = delete;
+    ProfileRegistry& operator=(ProfileRegistry const&) = delete;
+
+    ~ProfileRegistry() {
+        if (report_at_exit)
+            report(stderr);
+    }
+
+    [[nodiscard]] int add_site(std::string_view name) {
+        constexpr auto overflow_id = size_t{max_profile_zones - 1};
+        auto           lock        = std::scoped_lock(mtx);
+        if (names.size() < overflow_id)
+            names.push_back(name);
+        else if (names.size() == overflow_id)
+            names.emplace_back("(other zones)");
+        return static_cast<int>(std::min(names.size(), overflow_id + 1)) - 1;
+    }
+
+    void attach(ZoneCounters const* zones) {
+        auto lock = std::scoped_lock(mtx);
+        threads.push_back(zones);
+    }
+
+    /// @brief Fold the counters of an exiting thread into the totals
+    void detach(ZoneCounters const* zones) {
+        auto lock = std::scoped_lock(mtx);
+        _accumulate(zones, retired);
+        std::erase(threads, zones);
+    }
+
+    /// @brief Totals of all the threads, one entry per zone name, by decreasing time
+    [[nodiscard]] std::vector<zone_stats> snapshot() const {
+        auto lock   = std::scoped_lock(mtx);
+        auto totals = retired;
+        for (ZoneCounters const* zones : threads)
+            _accumulate(zones, totals);
+
+        auto stats = std::vector<zone_stats>();
+        for (size_t z = 0; z < names.size(); ++z) {
+            auto it = std::ranges::find(stats, names[z], &zone_stats::name);
+            if (it == stats.end())
+                it = stats.insert(it, {names[z]});
+            it->calls += totals[z].calls;
+            it->cycles += totals[z].cycles;
+        }
+        std::ranges::sort(stats, std::greater<>{}, &zone_stats::cycles);
+        return stats;
+    }
+
+    void report(std::FILE* out) const {
+        auto stats = snapshot();
+        if (stats.empty())
+            return;
+        std::fprintf(out, "%-32s %12s %12s %12s\n", "zone", "calls", "total ms", "avg ns");
+        for (zone_stats const& st : stats) {
+            double tot_ns = cycles_to<nsec>(st.cycles);
+            std::fprintf(out,
+                         "%-32.*s %12llu %12.3f %12.1f\n",
+                         static_cast<int>(st.name.size()),
+                         st.name.data(),
+                         static_cast<unsigned long long>(st.calls),
+                         tot_ns * 1e-6,
+                         st.calls == 0 ? 0.0 : tot_ns / static_cast<double>(st.calls));
+        }
+    }
+
+    /// @brief Print the report to stderr at exit (default true)
+    void set_report_at_exit(bool enable) {
+        report_at_exit = enable;
+    }
+
+private:
+    struct totals_t {
+        uint64_t calls  = 0;
+        uint64_t cycles = 0;
+    };
+
+    using totals_array = std::array<totals_t, max_profile_zones>;
+
+    mutable std::mutex               mtx;
+    std::vector<std::string_view>    names;
+    std::vector<ZoneCounters const*> threads;
+    totals_array                     retired        = {};
+    bool                             report_at_exit = true;
+
+    ProfileRegistry() = default;
+
+    static void _accumulate(ZoneCounters const* zones, totals_array& totals) {
+        for (int z = 0; z < max_profile_zones; ++z) {
+            totals[z].calls += zones[z].calls.load(std::memory_order_relaxed);
+            totals[z].cycles += zones[z].cycles.load(std::memory_order_relaxed);
+        }
+    }
+};
+
+/// @brief Per-thread block of counters, registered on first use and folded into the registry
+/// totals when the thread exits
+class ThreadProfile {
+public:
+    [[nodiscard]] static ZoneCounters* local() {
+        thread_local ThreadProfile profile;
+        return profile.zones.get();
+    }
+
+    ThreadProfile(ThreadProfile const&)            = delete;
+    ThreadProfile& operator=(ThreadProfile const&) = delete;
+
+    ~ThreadProfile() {
+        ProfileRegistry::get().detach(zones.get());
+    }
+
+private:
+    std::unique_ptr<ZoneCounters[]> zones = std::make_unique<ZoneCounters[]>(max_profile_zones);
+
+    ThreadProfile() {
+        ProfileRegistry::get().attach(zones.get());
+    }
+};
+
+/// @brief A CAV_PROFILE_SCOPE call site (a function-local static)
+struct ProfileSite {
+    int id;
+
+    explicit ProfileSite(std::string_view name)
+        : id(ProfileRegistry::get().add_site(name)) {
+    }
+};
+
+/// @brief RAII timer of a zone
+class ProfileZone {
+public:
+    CAV_INLINE explicit ProfileZone(ProfileSite const& site)
+        : counters(ThreadProfile::local() + site.id)
+        , beg(read_cycles()) {
+    }
+
+    ProfileZone(ProfileZone const&)            = delete;
+    ProfileZone& operator=(ProfileZone const&) = delete;
+
+    CAV_INLINE ~ProfileZone() {
+        counters->add(read_cycles() - beg);
+    }
+
+private:
+    ZoneCounters* counters;
+    uint64_t      beg;
+};
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_MISH_PROFILER_HPP */
@@ -0,0 +1,590 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_MISH_THREADPOOL_HPP
+#define CAV_INCLUDE_MISH_THREADPOOL_HPP
+
+/// Work-stealing fork-join pool. parallel_for/parallel_reduce split the range in halves (at
+/// multiples of the grain): the right half is pushed on the Chase-Lev deque of the worker and
+/// the left one is processed in place, so idle workers steal the largest pending pieces. Tasks
+/// live on the stack of the thread that forks them, nothing is allocated per task. Idle workers
+/// park on an atomic wait. Calls from outside the pool hand the whole range to a worker and
+/// block until it completes; nested calls from inside a worker fork in place.
+///
+/// The functors must not throw. They are called either per index, fn(i), or per chunk,
+/// fn(beg, end), whichever they accept (the chunk form is preferred).
+///
+/// The members of a type_map/tuple can also be visited concurrently, one task per member (e.g.,
+/// resetting a state made of independent buffers). A member declares its relative cost with a
+/// `static constexpr int task_cost` in its key type (type_map) or value type, and the members
+/// are started from the most expensive one.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "../comptime/syntactic_sugars.hpp"
+#include "../comptime/test.hpp"
+#include "../tuplish/tuple.hpp"
+#include "../vectors/IndexProxyIter.hpp"
+#include "util_functions.hpp"
+
+namespace cav {
+
+inline constexpr size_t cache_line_size = 64;
+
+namespace detail {
+    struct PoolTask {
+        void (*exec)(PoolTask*) = nullptr;
+        std::atomic<bool> done  = false;
+    };
+
+    /// @brief Chase-Lev work-stealing deque of task pointers (Le et al. 2013 formulation).
+    /// The owner pushes and pops at the bottom, thieves steal from the top. Fixed capacity: a
+    /// failed push means the owner runs the task itself.
+    class TaskDeque {
+    public:
+        static constexpr int64_t capacity = int64_t{1} << 12;
+
+        TaskDeque()
+            : buffer(std::make_unique<std::atomic<PoolTask*>[]>(capacity)) {
+        }
+
+        bool push(PoolTask* task) noexcept {
+            int64_t btm = bottom.load(std::memory_order_relaxed);
+            if (btm - top.load(std::memory_order_acquire) >= capacity)
+                return false;
+            buffer[btm & mask].store(task, std::memory_order_relaxed);
+            bottom.store(btm + 1, std::memory_order_release);
+            return true;
+        }
+
+        PoolTask* pop() noexcept {
+            int64_t btm = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(btm, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t tp = top.load(std::memory_order_relaxed);
+            if (tp > btm) {  // empty
+                bottom.store(btm + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            PoolTask* task = buffer[btm & mask].load(std::memory_order_relaxed);
+            if (tp == btm) {  // last one, race against the thieves
+                if (!top.compare_exchange_strong(
+                        tp, tp + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    task = nullptr;
+                bottom.store(btm + 1, std::memory_order_relaxed);
+            }
+            return task;
+        }
+
+        PoolTask* steal() noexcept {
+            int64_t tp = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t btm = bottom.load(std::memory_order_acquire);
+            if (tp >= btm)
+                return nullptr;
+            PoolTask* task = buffer[tp & mask].load(std::memory_order_relaxed);
+            if (!top.compare_exchange_strong(
+                    tp, tp + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+            return task;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return top.load(std::memory_order_acquire) >= bottom.load(std::memory_order_acquire);
+        }
+
+    private:
+        static constexpr int64_t mask = capacity - 1;
+
+        alignas(cache_line_size) std::atomic<int64_t> top    = 0;
+        alignas(cache_line_size) std::atomic<int64_t> bottom = 0;
+        std::unique_ptr<std::atomic<PoolTask*>[]>     buffer;
+    };
+
+    template <typename T>
+    struct line_multiple_of : ct<cache_line_size / std::gcd(cache_line_size, sizeof(T))> {};
+
+    template <typename... Ts>
+    struct line_multiple_of<tuple<Ts...>>
+        : ct<std::max({size_t{1}, line_multiple_of<Ts>::value...})> {};
+
+    template <typename FnT, typename I>
+    CAV_INLINE inline void run_chunk(FnT& fn, I beg, I end) {
+        if constexpr (std::invocable<FnT&, I, I>)
+            fn(beg, end);
+        else
+            for (I i = beg; i < end; ++i)
+                fn(i);
+    }
+}  // namespace detail
+
+/// @brief type_map, tuple and derived classes
+template <typename T>
+concept member_visitable = requires { typename no_cvr<T>::elems_t; };
+
+namespace detail {
+    template <typename ElemT>
+    consteval int member_cost() {
+        if constexpr (requires { ElemT::key_t::task_cost; })
+            return ElemT::key_t::task_cost;
+        else if constexpr (requires { ElemT::value_t::task_cost; })
+            return ElemT::value_t::task_cost;
+        else
+            return 1;
+    }
+
+    /// @brief Member indexes by decreasing cost (declaration order among equal costs)
+    template <typename... Es>
+    consteval auto cost_order(pack<Es...> /*p*/) {
+        constexpr auto costs = std::array<int, sizeof...(Es)>{member_cost<Es>()...};
+        auto           order = std::array<size_t, sizeof...(Es)>{};
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::ranges::sort(order, [&](size_t a, size_t b) {
+            return costs[a] != costs[b] ? costs[a] > costs[b] : a < b;
+        });
+        return order;
+    }
+}  // namespace detail
+
+/// @brief Smallest element count multiple whose chunks of a cont (SoA columns included, or
+/// MatrixKD rows) start and end on cache line boundaries (with line-aligned storage)
+template <typename ContT>
+[[nodiscard]] constexpr size_t line_multiple(ContT const& cont) {
+    using value_t = typename ContT::value_type;
+    if constexpr (requires { cont.stride(); }) {  // one unit is a row of stride elements
+        auto row_bytes = static_cast<size_t>(cont.stride()) * sizeof(value_t);
+        return row_bytes == 0 ? 1 : cache_line_size / std::gcd(cache_line_size, row_bytes);
+    } else
+        return detail::line_multiple_of<value_t>::value;
+}
+
+/// @brief grain rounded up to a multiple of line_multiple(cont)
+template <typename ContT>
+[[nodiscard]] constexpr size_t line_grain(ContT const& cont, size_t grain) {
+    size_t mult = line_multiple(cont);
+    return (max(grain, size_t{1}) + mult - 1) / mult * mult;
+}
+
+class ThreadPool;
+
+namespace detail {
+    /// @brief Pool (and worker id) the current thread works for
+    struct worker_slot {
+        ThreadPool const* pool = nullptr;
+        unsigned          id   = ~0U;
+    };
+
+    inline worker_slot& this_worker() noexcept {
+        thread_local worker_slot slot;
+        return slot;
+    }
+}  // namespace detail
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned n_workers = std::thread::hardware_concurrency())
+        : deques(max(n_workers, 1U)) {
+        workers.reserve(deques.size());
+        for (unsigned id = 0; id < deques.size(); ++id)
+            workers.emplace_back([this, id] { _worker_loop(id); });
+    }
+
+    ThreadPool(ThreadPool const&)            = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    ~ThreadPool() {
+        stopping.store(true);
+        signal.fetch_add(1);
+        signal.notify_all();
+        workers.clear();  // join
+    }
+
+    /// @brief Process-wide pool with one worker per hardware thread
+    [[nodiscard]] static ThreadPool& global() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    [[nodiscard]] unsigned size() const noexcept {
+        return static_cast<unsigned>(deques.size());
+    }
+
+    /// @brief Default grain: about 8 chunks per worker, so that stealing can balance the load
+    [[nodiscard]] size_t auto_grain(size_t n) const noexcept {
+        return max(n / (size_t{8} * size()), size_t{1});
+    }
+
+    /// @brief fn over [begin, end), in chunks of at least grain indices (0 for auto_grain)
+    template <std::integral I, typename FnT>
+    void parallel_for(I begin, I end, size_t grain, FnT&& fn) {
+        if (end <= begin)
+            return;
+        auto n = static_cast<size_t>(end - begin);
+        grain  = grain == 0 ? auto_grain(n) : grain;
+        auto body = [&](size_t beg, size_t stop) {
+            detail::run_chunk(fn, static_cast<I>(begin + beg), static_cast<I>(begin + stop));
+        };
+        _enter([&](unsigned id) { _for_range(0, n, grain, body, id); });
+    }
+
+    /// @brief fn(*it) over an IndexProxyIter range (SoAArray/SoAVector rows, ...)
+    template <typename ContT, typename FnT>
+    void parallel_for(IndexProxyIter<ContT> begin,
+                      IndexProxyIter<ContT> end,
+                      size_t                grain,
+                      FnT&&                 fn) {
+        ContT* cont = begin.container;
+        parallel_for(begin.idx, end.idx, grain, [&](size_t beg, size_t stop) {
+            for (size_t i = beg; i < stop; ++i)
+                fn((*cont)[i]);
+        });
+    }
+
+    /// @brief fn(cont[i]) for each element of an indexable container (MatrixKD rows, SoA rows,
+    /// OwnSpan, ...), with the grain rounded to whole cache lines
+    template <indexable ContT, typename FnT>
+    void parallel_for_each(ContT&& cont, FnT&& fn, size_t grain = 0) {
+        auto n = static_cast<size_t>(cont.size());
+        grain  = line_grain(cont, grain == 0 ? auto_grain(n) : grain);
+        parallel_for(size_t{0}, n, grain, [&](size_t beg, size_t stop) {
+            for (size_t i = beg; i < stop; ++i)
+                fn(cont[i]);
+        });
+    }
+
+    /// @brief fn(member) for each member of a type_map/tuple, each member a task. The most
+    /// expensive members (task_cost) are claimed first, so the long ones do not end up last.
+    template <member_visitable TMapT, typename FnT>
+    void parallel_for_each(TMapT&& tmap, FnT&& fn) {
+        static constexpr auto order = detail::cost_order(typename no_cvr<TMapT>::elems_t{});
+        _for_members(order.size(), [&](size_t k) { tmap.visit_idx(order[k], fn); });
+    }
+
+    /// @brief comb(...comb(comb(init, map(m0)), map(m1))..., map(mN)) over the members of a
+    /// type_map/tuple: the maps run concurrently, the partial results are combined in member
+    /// order (the result does not depend on the scheduling).
+    template <member_visitable TMapT, typename T, typename MapT, typename CombT>
+    [[nodiscard]] T parallel_reduce(TMapT&& tmap, T init, MapT&& map, CombT&& comb) {
+        static constexpr auto order = detail::cost_order(typename no_cvr<TMapT>::elems_t{});
+        auto                  parts = std::vector<T>(order.size(), init);
+        _for_members(order.size(), [&](size_t k) {
+            tmap.visit_idx(order[k], [&](auto&& member) { parts[order[k]] = map(member); });
+        });
+        for (T& part : parts)
+            init = comb(std::move(init), std::move(part));
+        return init;
+    }
+
+    /// @brief combine of map over [begin, end) starting from init (combine must be associative,
+    /// init its identity). map is called per index or per chunk like parallel_for's fn.
+    template <std::integral I, typename T, typename MapT, typename CombT>
+    [[nodiscard]] T parallel_reduce(
+        I begin, I end, size_t grain, T init, MapT&& map, CombT&& comb) {
+        if (end <= begin)
+            return init;
+        auto n = static_cast<size_t>(end - begin);
+        grain  = grain == 0 ? auto_grain(n) : grain;
+        auto body = [&](size_t beg, size_t stop) -> T {
+            auto lo = static_cast<I>(begin + beg);
+            auto hi = static_cast<I>(begin + stop);
+            if constexpr (std::invocable<MapT&, I, I>)
+                return map(lo, hi);
+            else {
+                T acc = init;
+                for (I i = lo; i < hi; ++i)
+                    acc = comb(std::move(acc), map(i));
+                return acc;
+            }
+        };
+        T res = init;
+        _enter([&](unsigned id) { res = _reduce_range<T>(0, n, grain, body, comb, id); });
+        return res;
+    }
+
+private:
+    static constexpr unsigned no_worker = ~0U;
+
+    struct alignas(cache_line_size) padded_deque : detail::TaskDeque {};
+
+    std::vector<padded_deque>      deques;
+    std::vector<std::jthread>      workers;
+    std::mutex                     inject_mtx;
+    std::vector<detail::PoolTask*> injected;
+    alignas(cache_line_size) std::atomic<size_t> n_injected = 0;
+    alignas(cache_line_size) std::atomic<uint32_t> signal   = 0;
+    std::atomic<int>  n_sleeping                           = 0;
+    std::atomic<bool> stopping                             = false;
+
+    /// @brief visit(k) for k in [0, n): up to size() claimers take the next k from a shared
+    /// counter, which is an LPT list schedule when the ks are sorted by decreasing cost
+    template <typename VisitT>
+    void _for_members(size_t n, VisitT&& visit) {
+        auto next = std::atomic<size_t>(0);
+        parallel_for(size_t{0}, min(size_t{size()}, n), 1, [&](size_t /*c*/) {
+            for (size_t k = next++; k < n; k = next++)
+                visit(k);
+        });
+    }
+
+    /// @brief Run job(worker_id) on a worker of this pool: in place if already on one, otherwise
+    /// as an injected task while the caller blocks
+    template <typename JobT>
+    void _enter(JobT&& job) {
+        if (unsigned id = _my_id(); id != no_worker) {
+            job(id);
+            return;
+        }
+
+        struct external_task : detail::PoolTask {
+            ThreadPool*             pool;
+            JobT*                   job;
+            std::mutex              mtx;
+            std::condition_variable cv;
+            bool                    finished = false;
+        };
+
+        auto task  = external_task{};
+        task.pool  = this;
+        task.job   = &job;
+        task.exec  = [](detail::PoolTask* base) {
+            auto* self = static_cast<external_task*>(base);
+            (*self->job)(self->pool->_my_id());
+            auto lock      = std::scoped_lock(self->mtx);
+            self->finished = true;
+            self->cv.notify_one();  // under the lock: the waiter cannot return before we are done
+        };
+        {
+            auto lock = std::scoped_lock(inject_mtx);
+            injected.push_back(&task);
+            n_injected.fetch_add(1);
+        }
+        _wake();
+        auto lock = std::unique_lock(task.mtx);
+        task.cv.wait(lock, [&] { return task.finished; });
+    }
+
+    template <typename BodyT>
+    struct for_task : detail::PoolTask {
+        ThreadPool* pool;
+        size_t      beg, end, grain;
+        BodyT*      body;
+
+        for_task(ThreadPool* p, size_t b, size_t e, size_t g, BodyT* bd)
+            : pool(p)
+            , beg(b)
+            , end(e)
+            , grain(g)
+            , body(bd) {
+            exec = [](detail::PoolTask* base) {
+                auto* self = static_cast<for_task*>(base);
+                self->pool->_for_range(self->beg, self->end, self->grain, *self->body, _id());
+                self->done.store(true, std::memory_order_release);
+            };
+        }
+    };
+
+    template <typename T, typename BodyT, typename CombT>
+    struct reduce_task : detail::PoolTask {
+        ThreadPool* pool;
+        size_t      beg, end, grain;
+        BodyT*      body;
+        CombT*      comb;
+        T           result = {};
+
+        reduce_task(ThreadPool* p, size_t b, size_t e, size_t g, BodyT* bd, CombT* cb)
+            : pool(p)
+            , beg(b)
+            , end(e)
+            , grain(g)
+            , body(bd)
+            , comb(cb) {
+            exec = [](detail::PoolTask* base) {
+                auto* self = static_cast<reduce_task*>(base);
+                self->result = self->pool->template _reduce_range<T>(
+                    self->beg, self->end, self->grain, *self->body, *self->comb, _id());
+                self->done.store(true, std::memory_order_release);
+            };
+        }
+    };
+
+    /// @brief Worker id of the calling thread in this pool, no_worker for other threads
+    [[nodiscard]] unsigned _my_id() const noexcept {
+        detail::worker_slot const& slot = detail::this_worker();
+        return slot.pool == this ? slot.id : no_worker;
+    }
+
+    /// @brief Worker id of the calling thread, which is running a task of this pool
+    [[nodiscard]] static unsigned _id() noexcept {
+        return detail::this_worker().id;
+    }
+
+    /// @brief Split point: half of the grain units, so every chunk but the last is grain-aligned
+    [[nodiscard]] static size_t _mid(size_t beg, size_t end, size_t grain) {
+        size_t units = (end - beg + grain - 1) / grain;
+        return beg + units / 2 * grain;
+    }
+
+    template <typename BodyT>
+    void _for_range(size_t beg, size_t end, size_t grain, BodyT& body, unsigned id) {
+        if (end - beg <= grain) {
+            body(beg, end);
+            return;
+        }
+        auto right = for_task<BodyT>(this, _mid(beg, end, grain), end, grain, &body);
+        if (!_fork(right, id)) {
+            body(beg, end);
+            return;
+        }
+        _for_range(beg, right.beg, grain, body, id);
+        _join(right, id);
+    }
+
+    template <typename T, typename BodyT, typename CombT>
+    T _reduce_range(size_t beg, size_t end, size_t grain, BodyT& body, CombT& comb, unsigned id) {
+        if (end - beg <= grain)
+            return body(beg, end);
+        using task_t = reduce_task<T, BodyT, CombT>;
+        auto right   = task_t(this, _mid(beg, end, grain), end, grain, &body, &comb);
+        if (!_fork(right, id))
+            return body(beg, end);
+        T left = _reduce_range<T>(beg, right.beg, grain, body, comb, id);
+        _join(right, id);
+        return comb(std::move(left), std::move(right.result));
+    }
+
+    bool _fork(detail::PoolTask& task, unsigned id) {
+        if (!deques[id].push(&task))
+            return false;
+        _wake();
+        return true;
+    }
+
+    /// @brief Wait for task helping: run our own pending tasks first (if task was not stolen it is
+    /// the first one), then steal
+    void _join(detail::PoolTask& task, unsigned id) {
+        while (!task.done.load(std::memory_order_acquire)) {
+            detail::PoolTask* other = deques[id].pop();
+            if (other == nullptr)
+                other = _steal(id);
+            if (other != nullptr)
+                other->exec(other);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    [[nodiscard]] detail::PoolTask* _steal(unsigned id) {
+        auto n = static_cast<unsigned>(deques.size());
+        for (unsigned k = 1; k < n; ++k)
+            if (detail::PoolTask* task = deques[(id + k) % n].steal())
+                return task;
+        return nullptr;
+    }
+
+    [[nodiscard]] detail::PoolTask* _take_injected() {
+        if (n_injected.load() == 0)
+            return nullptr;
+        auto lock = std::scoped_lock(inject_mtx);
+        if (injected.empty())
+            return nullptr;
+        detail::PoolTask* task = injected.back();
+        injected.pop_back();
+        n_injected.fetch_sub(1);
+        return task;
+    }
+
+    [[nodiscard]] bool _has_work() const {
+        return n_injected.load() > 0 ||
+               std::ranges::any_of(deques, [](padded_deque const& dq) { return !dq.empty(); });
+    }
+
+    /// @brief Wake a parked worker, if any (the fence pairs with the n_sleeping increment)
+    void _wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (n_sleeping.load() > 0) {
+            signal.fetch_add(1);
+            signal.notify_one();
+        }
+    }
+
+    void _park() {
+        n_sleeping.fetch_add(1);
+        uint32_t seen = signal.load();
+        if (!_has_work() && !stopping.load())
+            signal.wait(seen);
+        n_sleeping.fetch_sub(1);
+    }
+
+    void _worker_loop(unsigned id) {
+        detail::this_worker() = {this, id};
+        while (!stopping.load()) {
+            detail::PoolTask* task = deques[id].pop();
+            if (task == nullptr)
+                task = _take_injected();
+            if (task == nullptr)
+                task = _steal(id);
+            if (task != nullptr)
+                task->exec(task);
+            else
+                _park();
+        }
+    }
+};
+
+/// @brief ThreadPool::parallel_for on the global pool
+template <typename... Args>
+void parallel_for(Args&&... args) {
+    ThreadPool::global().parallel_for(FWD(args)...);
+}
+
+/// @brief ThreadPool::parallel_for_each on the global pool
+template <typename... Args>
+void parallel_for_each(Args&&... args) {
+    ThreadPool::global().parallel_for_each(FWD(args)...);
+}
+
+/// @brief ThreadPool::parallel_reduce on the global pool
+template <typename... Args>
+[[nodiscard]] auto parallel_reduce(Args&&... args) {
+    return ThreadPool::global().parallel_reduce(FWD(args)...);
+}
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    struct TP_Heavy {
+        static constexpr int task_cost = 4;
+    };
+
+    using tp_state_t = type_map<map_elem<int, int>, map_elem<TP_Heavy, int>, map_elem<float, int>>;
+    CAV_PASS(detail::cost_order(tp_state_t::elems_t{}) == std::array<size_t, 3>{1, 0, 2});
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_MISH_THREADPOOL_HPP */
@@ -28,7 +28,9 @@
 #pragma once
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <limits>
+#include <span>
 #include <type_traits>
 #if __has_cpp_attribute(nodiscard) >= 201907L
 #define XOSHIROCPP_NODISCARD_CXX20 [[nodiscard]]
@@ -555,6 +557,81 @@ public:
 private:
     state_type m_state;
 };
+
+// xoshiro256++ x Lanes
+// Output: Lanes x 64 bits per step
+// Period: 2^256 - 1 per lane
+// Footprint: Lanes x 32 bytes
+// Lanes interleaved independent xoshiro256++ states, lane i is lane 0 after i jump() calls
+// (i.e., 2^128 steps apart). The state is kept lane-wise so the bulk fill functions break the
+// single-state dependency chain and can be kept in vector registers (AVX2 for 4 lanes,
+// AVX-512 for 8 lanes).
+template <std::size_t Lanes = 8>
+class Xoshiro256PlusPlusLanes {
+public:
+    using state_type  = std::array<std::array<std::uint64_t, Lanes>, 4>;
+    using result_type = std::uint64_t;
+    using block_type  = std::array<result_type, Lanes>;
+
+    static constexpr std::size_t lanes = Lanes;
+
+    XOSHIROCPP_NODISCARD_CXX20
+    explicit constexpr Xoshiro256PlusPlusLanes(std::uint64_t seed = DefaultSeed) noexcept;
+
+    XOSHIROCPP_NODISCARD_CXX20
+    explicit constexpr Xoshiro256PlusPlusLanes(Xoshiro256PlusPlus first_lane) noexcept;
+
+    // One step of every lane, block[i] is the output of lane i
+    constexpr block_type operator()() noexcept;
+
+    // Fill `out` with random values, lane outputs interleaved. The last partial block
+    // (out.size() % Lanes) consumes a whole step.
+    constexpr void fill(std::span<result_type> out) noexcept;
+
+    // Fill `out` with random doubles in [0.0, 1.0), see DoubleFromBits
+    constexpr void fillDoubles(std::span<double> out) noexcept;
+
+    // Equivalent to jump() on every lane (2^128 steps of each lane)
+    constexpr void jump() noexcept;
+
+    // Equivalent to longJump() on every lane (2^192 steps of each lane)
+    constexpr void longJump() noexcept;
+
+    // Scalar generator with the current state of a lane
+    [[nodiscard]] constexpr Xoshiro256PlusPlus lane(std::size_t i) const noexcept;
+
+    [[nodiscard]] static constexpr result_type min() noexcept;
+
+    [[nodiscard]] static constexpr result_type max() noexcept;
+
+    [[nodiscard]] constexpr state_type serialize() const noexcept;
+
+    constexpr void deserialize(state_type state) noexcept;
+
+    [[nodiscard]] friend bool operator==(Xoshiro256PlusPlusLanes const& lhs,
+                                         Xoshiro256PlusPlusLanes const& rhs) noexcept {
+        return (lhs.m_state == rhs.m_state);
+    }
+
+    [[nodiscard]] friend bool operator!=(Xoshiro256PlusPlusLanes const& lhs,
+                                         Xoshiro256PlusPlusLanes const& rhs) noexcept {
+        return (lhs.m_state != rhs.m_state);
+    }
+
+private:
+    alignas(64) state_type m_state;
+
+    template <class T>
+    constexpr void fillImpl(std::span<T> out) noexcept;
+
+#if defined(__GNUC__)
+    template <class T>
+    void fillVec(std::span<T> out) noexcept;
+#endif
+
+    template <class JumpFn>
+    constexpr void perLane(JumpFn jump_fn) noexcept;
+};
 }
 
 ////////////////////////////////////////////////////////////////
@@ -578,6 +655,11 @@ namespace detail {
     [[nodiscard]] static constexpr std::uint32_t RotL(const std::uint32_t x, int const s) noexcept {
         return (x << s) | (x >> (32 - s));
     }
+
+#if defined(__GNUC__)
+    template <class E, std::size_t N>
+    using Vec [[gnu::vector_size(N * sizeof(E))]] = E;
+#endif
 }
 
 ////////////////////////////////////////////////////////////////
@@ -1436,4 +1518,200 @@ constexpr inline Xoshiro128StarStar::state_type Xoshiro128StarStar::serialize()
 constexpr inline void Xoshiro128StarStar::deserialize(const state_type state) noexcept {
     m_state = state;
 }
+
+////////////////////////////////////////////////////////////////
+//
+//	xoshiro256++ x Lanes
+//
+template <std::size_t Lanes>
+constexpr inline Xoshiro256PlusPlusLanes<Lanes>::Xoshiro256PlusPlusLanes(
+    const std::uint64_t seed) noexcept
+    : Xoshiro256PlusPlusLanes(Xoshiro256PlusPlus{seed}) {
+}
+
+template <std::size_t Lanes>
+constexpr inline Xoshiro256PlusPlusLanes<Lanes>::Xoshiro256PlusPlusLanes(
+    Xoshiro256PlusPlus first_lane) noexcept
+    : m_state() {
+    for (std::size_t l = 0; l < Lanes; ++l) {
+        const auto lane_state = first_lane.serialize();
+        for (std::size_t k = 0; k < 4; ++k)
+            m_state[k][l] = lane_state[k];
+        first_lane.jump();
+    }
+}
+
+template <std::size_t Lanes>
+constexpr inline typename Xoshiro256PlusPlusLanes<Lanes>::block_type
+Xoshiro256PlusPlusLanes<Lanes>::operator()() noexcept {
+    block_type block = {};
+    fillImpl(std::span<result_type>(block));
+    return block;
+}
+
+template <std::size_t Lanes>
+constexpr inline void Xoshiro256PlusPlusLanes<Lanes>::fill(std::span<result_type> out) noexcept {
+    fillImpl(out);
+}
+
+template <std::size_t Lanes>
+constexpr inline void Xoshiro256PlusPlusLanes<Lanes>::fillDoubles(std::span<double> out) noexcept {
+    fillImpl(out);
+}
+
+template <std::size_t Lanes>
+template <class T>
+constexpr inline void Xoshiro256PlusPlusLanes<Lanes>::fillImpl(std::span<T> out) noexcept {
+#if defined(__GNUC__)
+    if constexpr ((Lanes & (Lanes - 1)) == 0)
+        if (!std::is_constant_evaluated())
+            return fillVec(out);
+#endif
+
+    // Local copies so that the state lives in registers for the whole loop
+    std::uint64_t s0[Lanes], s1[Lanes], s2[Lanes], s3[Lanes];
+    for (std::size_t l = 0; l < Lanes; ++l) {
+        s0[l] = m_state[0][l];
+        s1[l] = m_state[1][l];
+        s2[l] = m_state[2][l];
+        s3[l] = m_state[3][l];
+    }
+
+    auto step = [&](T* block) {
+        for (std::size_t l = 0; l < Lanes; ++l) {
+            const std::uint64_t r = detail::RotL(s0[l] + s3[l], 23) + s0[l];
+            const std::uint64_t t = s1[l] << 17;
+            if constexpr (std::is_same_v<T, double>)
+                block[l] = DoubleFromBits(r);
+            else
+                block[l] = r;
+            s2[l] ^= s0[l];
+            s3[l] ^= s1[l];
+            s1[l] ^= s2[l];
+            s0[l] ^= s3[l];
+            s2[l] ^= t;
+            s3[l] = detail::RotL(s3[l], 45);
+        }
+    };
+
+    const std::size_t n_full = out.size() / Lanes * Lanes;
+    for (std::size_t i = 0; i < n_full; i += Lanes)
+        step(out.data() + i);
+    if (n_full < out.size()) {
+        T tail[Lanes];
+        step(tail);
+        for (std::size_t i = n_full; i < out.size(); ++i)
+            out[i] = tail[i - n_full];
+    }
+
+    for (std::size_t l = 0; l < Lanes; ++l) {
+        m_state[0][l] = s0[l];
+        m_state[1][l] = s1[l];
+        m_state[2][l] = s2[l];
+        m_state[3][l] = s3[l];
+    }
+}
+
+#if defined(__GNUC__)
+// Same as the scalar loop of fillImpl on GCC/Clang vector extensions: the autovectorizer does not
+// reliably keep the lane loop in vector registers (GCC -O3 scalarizes part of it).
+template <std::size_t Lanes>
+template <class T>
+inline void Xoshiro256PlusPlusLanes<Lanes>::fillVec(std::span<T> out) noexcept {
+    constexpr std::size_t bytes = Lanes * sizeof(std::uint64_t);
+    using uvec_t                = detail::Vec<std::uint64_t, Lanes>;
+    using dvec_t                = detail::Vec<double, Lanes>;
+
+    uvec_t s0, s1, s2, s3;
+    std::memcpy(&s0, m_state[0].data(), bytes);
+    std::memcpy(&s1, m_state[1].data(), bytes);
+    std::memcpy(&s2, m_state[2].data(), bytes);
+    std::memcpy(&s3, m_state[3].data(), bytes);
+
+    auto step = [&](T* block) {
+        const uvec_t sum = s0 + s3;
+        const uvec_t r   = ((sum << 23) | (sum >> 41)) + s0;
+        const uvec_t t   = s1 << 17;
+        if constexpr (std::is_same_v<T, double>) {
+            const uvec_t mantissa = r >> 11;
+            const dvec_t d        = __builtin_convertvector(mantissa, dvec_t) * 0x1.0p-53;
+            std::memcpy(block, &d, bytes);
+        } else {
+            std::memcpy(block, &r, bytes);
+        }
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = (s3 << 45) | (s3 >> 19);
+    };
+
+    const std::size_t n_full = out.size() / Lanes * Lanes;
+    for (std::size_t i = 0; i < n_full; i += Lanes)
+        step(out.data() + i);
+    if (n_full < out.size()) {
+        T tail[Lanes];
+        step(tail);
+        std::memcpy(out.data() + n_full, tail, (out.size() - n_full) * sizeof(T));
+    }
+
+    std::memcpy(m_state[0].data(), &s0, bytes);
+    std::memcpy(m_state[1].data(), &s1, bytes);
+    std::memcpy(m_state[2].data(), &s2, bytes);
+    std::memcpy(m_state[3].data(), &s3, bytes);
+}
+#endif
+
+template <std::size_t Lanes>
+template <class JumpFn>
+constexpr inline void Xoshiro256PlusPlusLanes<Lanes>::perLane(JumpFn jump_fn) noexcept {
+    for (std::size_t l = 0; l < Lanes; ++l) {
+        auto lane_gen = lane(l);
+        jump_fn(lane_gen);
+        const auto lane_state = lane_gen.serialize();
+        for (std::size_t k = 0; k < 4; ++k)
+            m_state[k][l] = lane_state[k];
+    }
+}
+
+template <std::size_t Lanes>
+constexpr inline void Xoshiro256PlusPlusLanes<Lanes>::jump() noexcept {
+    perLane([](Xoshiro256PlusPlus& gen) { gen.jump(); });
+}
+
+template <std::size_t Lanes>
+constexpr inline void Xoshiro256PlusPlusLanes<Lanes>::longJump() noexcept {
+    perLane([](Xoshiro256PlusPlus& gen) { gen.longJump(); });
+}
+
+template <std::size_t Lanes>
+constexpr inline Xoshiro256PlusPlus Xoshiro256PlusPlusLanes<Lanes>::lane(
+    const std::size_t i) const noexcept {
+    return Xoshiro256PlusPlus{
+        Xoshiro256PlusPlus::state_type{m_state[0][i], m_state[1][i], m_state[2][i], m_state[3][i]}};
+}
+
+template <std::size_t Lanes>
+constexpr inline typename Xoshiro256PlusPlusLanes<Lanes>::result_type
+Xoshiro256PlusPlusLanes<Lanes>::min() noexcept {
+    return std::numeric_limits<result_type>::lowest();
+}
+
+template <std::size_t Lanes>
+constexpr inline typename Xoshiro256PlusPlusLanes<Lanes>::result_type
+Xoshiro256PlusPlusLanes<Lanes>::max() noexcept {
+    return std::numeric_limits<result_type>::max();
+}
+
+template <std::size_t Lanes>
+constexpr inline typename Xoshiro256PlusPlusLanes<Lanes>::state_type
+Xoshiro256PlusPlusLanes<Lanes>::serialize() const noexcept {
+    return m_state;
+}
+
+template <std::size_t Lanes>
+constexpr inline void Xoshiro256PlusPlusLanes<Lanes>::deserialize(const state_type state) noexcept {
+    m_state = state;
+}
 }
@@ -16,12 +16,21 @@
 #ifndef CAV_INCLUDE_RANDOM_HPP
 #define CAV_INCLUDE_RANDOM_HPP
 
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "../comptime/macros.hpp"
 #include "../comptime/mp_base.hpp"
+#include "../comptime/syntactic_sugars.hpp"
 #include "../mish/util_functions.hpp"
 #include "../numeric/XoshiroCpp.hpp"
 
@@ -34,6 +43,71 @@ using prng_double_t = XoshiroCpp::Xoshiro256Plus;      // specialized for real d
 
 using prng_t = prng_int64_t;  // default
 
+/// @brief Generator of the idx-th independent stream derived from a master seed: the seeded
+/// generator advanced by idx jump() calls (2^128 steps each for the 256-bit generators), so
+/// streams never overlap in practice.
+template <typename PrngT = prng_t>
+[[nodiscard]] constexpr PrngT make_stream(uint64_t seed, size_t idx) noexcept {
+    auto gen = PrngT(seed);
+    for (size_t i = 0; i < idx; ++i)
+        gen.jump();
+    return gen;
+}
+
+/// @brief Pool of non-overlapping generators derived from a master seed, one per worker.
+/// Each generator sits on its own cache line so the workers do not false-share state. Stream i is
+/// make_stream(seed, i), so results only depend on the seed and on the worker index.
+template <typename PrngT = prng_t>
+class PrngStreams {
+    struct alignas(64) Slot {
+        PrngT gen;
+    };
+
+public:
+    PrngStreams(size_t n_streams, uint64_t seed)
+        : slots() {
+        slots.reserve(n_streams);
+        auto gen = PrngT(seed);
+        for (size_t i = 0; i < n_streams; ++i, gen.jump())
+            slots.push_back({gen});
+    }
+
+    [[nodiscard]] PrngT& operator[](size_t i) noexcept {
+        assert(i < slots.size());
+        return slots[i].gen;
+    }
+
+    [[nodiscard]] PrngT const& operator[](size_t i) const noexcept {
+        assert(i < slots.size());
+        return slots[i].gen;
+    }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return slots.size();
+    }
+
+private:
+    std::vector<Slot> slots;
+};
+
+namespace detail {
+    inline std::atomic<size_t> thread_stream_counter = 0;
+}  // namespace detail
+
+/// @brief Calling thread generator. Unless reseeded with seed_thread_prng, each thread gets the
+/// next make_stream(XoshiroCpp::DefaultSeed, k) in order of first use (not reproducible when
+/// threads race, prefer seed_thread_prng in workers).
+[[nodiscard]] inline prng_t& thread_prng() noexcept {
+    alignas(64) thread_local prng_t gen = make_stream(XoshiroCpp::DefaultSeed,
+                                                      detail::thread_stream_counter++);
+    return gen;
+}
+
+/// @brief Reset the calling thread generator to make_stream(seed, stream_idx)
+inline void seed_thread_prng(uint64_t seed, size_t stream_idx) noexcept {
+    thread_prng() = make_stream(seed, stream_idx);
+}
+
 template <typename TpT = ct<0.5>>
 [[nodiscard]] CAV_NOINLINE inline bool coin_flip(prng_t& rnd, auto true_prob = {}) noexcept {
     assert(0 <= true_prob && true_prob <= 1);
@@ -81,19 +155,179 @@ template <typename TpT = ct<0.5>>
     return {rnd_val <= end1, beg2 <= rnd_val && rnd_val <= end2};
 }
 
+/// @brief Unbiased uniform integer in [0, range) with Lemire's multiply-shift method: one 64x64
+/// multiplication per draw, the (rare) rejection step is the only division.
+[[nodiscard]] inline uint64_t bounded_rnd(prng_t& rnd, uint64_t range) noexcept {
+    assert(range > 0);
+    __extension__ using uint128_t = unsigned __int128;
+
+    auto mul = static_cast<uint128_t>(rnd()) * range;
+    auto low = static_cast<uint64_t>(mul);
+    if (low < range) {
+        uint64_t treshold = (0 - range) % range;
+        while (low < treshold) {
+            mul = static_cast<uint128_t>(rnd()) * range;
+            low = static_cast<uint64_t>(mul);
+        }
+    }
+    return static_cast<uint64_t>(mul >> 64U);
+}
+
+/// @brief Uniform double in [0, 1) from the 53 high bits of one draw
+[[nodiscard]] inline double rnd_unit(prng_t& rnd) noexcept {
+    return XoshiroCpp::DoubleFromBits(rnd());
+}
+
+/// @brief Uniform double in [min, max)
 [[nodiscard]] inline double rnd_real(prng_t& rnd, auto min, auto max) noexcept {
-    static constexpr double rnd_range = static_cast<double>(prng_t::max() - prng_t::min());
-    double                  scale     = (max - min) / rnd_range;
-    return min + scale * static_cast<double>(rnd());
+    double dmin = static_cast<double>(min);
+    return dmin + (static_cast<double>(max) - dmin) * rnd_unit(rnd);
 }
 
+/// @brief Uniform (unbiased) integer in [min, max]
 [[nodiscard]] inline int roll_dice(prng_t& rnd, auto min, auto max) noexcept {
     assert(max - min >= 0);
-    int result = min + static_cast<int>(rnd() % (max - min + 1));
+    auto range  = static_cast<uint64_t>(max - min) + 1;
+    int  result = min + static_cast<int>(bounded_rnd(rnd, range));
     assert(min <= result && result <= max);
     return result;
 }
 
+/// @brief Fill out with roll_dice(rnd, min, max) draws
+inline void roll_dice_n(prng_t& rnd, auto min, auto max, std::span<int> out) noexcept {
+    assert(max - min >= 0);
+    auto range = static_cast<uint64_t>(max - min) + 1;
+    for (int& val : out)
+        val = min + static_cast<int>(bounded_rnd(rnd, range));
+}
+
+/// @brief Fill out with rnd_real(rnd, min, max) draws
+inline void rnd_real_n(prng_t& rnd, auto min, auto max, std::span<double> out) noexcept {
+    double dmin  = static_cast<double>(min);
+    double width = static_cast<double>(max) - dmin;
+    for (double& val : out)
+        val = dmin + width * rnd_unit(rnd);
+}
+
+/// @brief Fisher-Yates shuffle with bounded_rnd
+template <typename T>
+void shuffle(prng_t& rnd, std::span<T> elems) noexcept(std::is_nothrow_swappable_v<T>) {
+    for (size_t i = elems.size(); i > 1; --i) {
+        using std::swap;
+        swap(elems[i - 1], elems[bounded_rnd(rnd, i)]);
+    }
+}
+
+/// @brief k distinct uniform indices in [0, n), by a partial Fisher-Yates shuffle on a buffer
+/// reused across calls (no allocation once it reached size n). The returned span points into buff.
+template <typename IntT>
+[[nodiscard]] std::span<IntT> sample_indices(prng_t&            rnd,
+                                             size_t             n,
+                                             size_t             k,
+                                             std::vector<IntT>& buff) {
+    assert(k <= n);
+    buff.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        buff[i] = static_cast<IntT>(i);
+    for (size_t i = 0; i < k; ++i)
+        std::swap(buff[i], buff[i + bounded_rnd(rnd, n - i)]);
+    return {buff.data(), k};
+}
+
+/// @brief Uniform sample of out.size() elements of a range of unknown length (reservoir sampling,
+/// algorithm R). Returns the number of sampled elements (less than out.size() only if the range
+/// is shorter).
+template <std::ranges::input_range R, typename T>
+size_t reservoir_sample(prng_t& rnd, R&& range, std::span<T> out) {
+    size_t seen = 0;
+    for (auto&& elem : range) {
+        if (seen < out.size())
+            out[seen] = FWD(elem);
+        else if (size_t j = bounded_rnd(rnd, seen + 1); j < out.size())
+            out[j] = FWD(elem);
+        ++seen;
+    }
+    return min(seen, out.size());
+}
+
+/// @brief Walker/Vose alias table: O(n) construction, O(1) weighted sampling with a single draw
+/// (the high bits pick the column, the low bits decide between it and its alias).
+class AliasTable {
+    struct Column {
+        uint64_t treshold;  // keep the column if the low bits are below
+        uint32_t alias;
+    };
+
+public:
+    AliasTable() = default;
+
+    /// @param weights Non-negative weights, not all zero
+    explicit AliasTable(std::span<double const> weights)
+        : cols(weights.size()) {
+        assert(!weights.empty() && weights.size() <= std::numeric_limits<uint32_t>::max());
+        size_t n   = weights.size();
+        double sum = 0.0;
+        for (double w : weights) {
+            assert(w >= 0.0);
+            sum += w;
+        }
+        assert(sum > 0.0);
+
+        auto scaled = std::vector<double>(n);
+        auto small  = std::vector<uint32_t>();
+        auto large  = std::vector<uint32_t>();
+        for (size_t i = 0; i < n; ++i) {
+            scaled[i] = weights[i] * static_cast<double>(n) / sum;
+            (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+        }
+
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back();
+            uint32_t l = large.back();
+            small.pop_back();
+            cols[s] = {_treshold(scaled[s]), l};
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        for (uint32_t i : large)  // leftovers are 1 up to rounding
+            cols[i] = {std::numeric_limits<uint64_t>::max(), i};
+        for (uint32_t i : small)
+            cols[i] = {std::numeric_limits<uint64_t>::max(), i};
+    }
+
+    [[nodiscard]] size_t operator()(prng_t& rnd) const noexcept {
+        assert(!cols.empty());
+        __extension__ using uint128_t = unsigned __int128;
+
+        auto          mul = static_cast<uint128_t>(rnd()) * cols.size();
+        auto          idx = static_cast<size_t>(mul >> 64U);
+        Column const& col = cols[idx];
+        return static_cast<uint64_t>(mul) < col.treshold ? idx : col.alias;
+    }
+
+    /// @brief Fill out with weighted draws
+    void sample_n(prng_t& rnd, std::span<size_t> out) const noexcept {
+        for (size_t& idx : out)
+            idx = (*this)(rnd);
+    }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return cols.size();
+    }
+
+private:
+    std::vector<Column> cols;
+
+    [[nodiscard]] static uint64_t _treshold(double prob) noexcept {
+        if (prob >= 1.0)
+            return std::numeric_limits<uint64_t>::max();
+        return static_cast<uint64_t>(prob * 0x1.0p64);
+    }
+};
+
 }  // namespace cav
 
 #endif /* CAV_INCLUDE_RANDOM_HPP */
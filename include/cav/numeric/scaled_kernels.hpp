@@ -0,0 +1,318 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_NUMERIC_SCALED_KERNELS_HPP
+#define CAV_INCLUDE_NUMERIC_SCALED_KERNELS_HPP
+
+/// Bulk ScaledInt operations over contiguous ranges (std::span, OwnSpan, SoA columns, ...). The
+/// loops are branchless on the raw int_type values so that compilers can vectorize them: overflow
+/// is not checked element by element but detected once per call from running min/max (or
+/// sign-bit) accumulators, and reported in the return value. On overflow the output content is
+/// unspecified (wrapped around).
+
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+#include "../mish/util_functions.hpp"
+#include "ScaledInt.hpp"
+
+namespace cav {
+
+namespace detail {
+    template <int8_t E, int64_t B, std::integral BT, rounding_tag RT>
+    RT default_round_of(ScaledInt<E, B, BT, RT> /*s*/);
+
+    template <typename T>
+    struct is_scaled_int : std::false_type {};
+
+    template <int8_t E, int64_t B, std::integral BT, rounding_tag RT>
+    struct is_scaled_int<ScaledInt<E, B, BT, RT>> : std::true_type {};
+}  // namespace detail
+
+template <typename R>
+concept scaled_int_range = std::ranges::contiguous_range<R> && std::ranges::sized_range<R> &&
+                           detail::is_scaled_int<std::ranges::range_value_t<R>>::value;
+
+template <scaled_int_range R>
+using scaled_elem_t = std::ranges::range_value_t<R>;
+
+/// @brief Default rounding tag of the ScaledInt elements of R
+template <scaled_int_range R>
+using default_round_t = decltype(detail::default_round_of(scaled_elem_t<R>{}));
+
+/// @brief Kernel result with its overflow flag
+template <typename T>
+struct checked {
+    T    value;
+    bool overflow;
+};
+
+namespace detail {
+    /// @brief Branchless integer division with the ScaledInt rounding modes (d > 0)
+    template <rounding_tag TagT, std::integral T>
+    [[nodiscard]] constexpr T div_round(T n, T d) noexcept {
+        T quot = n / d;
+        T rem  = n - quot * d;
+        if constexpr (std::same_as<TagT, round_tag>) {  // half away from zero, no n + d / 2
+            T abs_rem = rem < 0 ? static_cast<T>(-rem) : rem;
+            T away    = static_cast<T>(abs_rem >= d - abs_rem);
+            return quot + (n < 0 ? static_cast<T>(-away) : away);
+        } else {
+            if constexpr (std::same_as<TagT, floor_tag>)
+                return quot - static_cast<T>(rem < 0);
+            else if constexpr (std::same_as<TagT, ceil_tag>)
+                return quot + static_cast<T>(rem > 0);
+            else
+                return quot;
+        }
+    }
+
+    /// @brief Branchless floating to integer conversion with the ScaledInt rounding modes
+    template <rounding_tag TagT, std::floating_point F>
+    [[nodiscard]] constexpr F float_round(F f) noexcept {
+        if constexpr (std::same_as<TagT, round_tag>)
+            return std::trunc(f + (f >= F{0} ? F{0.5} : F{-0.5}));
+        else if constexpr (std::same_as<TagT, floor_tag>)
+            return std::floor(f);
+        else if constexpr (std::same_as<TagT, ceil_tag>)
+            return std::ceil(f);
+        else
+            return std::trunc(f);
+    }
+
+    /// @brief Wrapping addition, sets the sign bit of ovf_bits if it overflows
+    template <std::signed_integral T>
+    [[nodiscard]] constexpr T wrap_add(T a, T b, T& ovf_bits) noexcept {
+        using U = std::make_unsigned_t<T>;
+        auto res = static_cast<T>(static_cast<U>(a) + static_cast<U>(b));
+        ovf_bits |= (a ^ res) & (b ^ res);
+        return res;
+    }
+
+    /// @brief Unsigned type of T, at least unsigned int (narrower types would be promoted to int,
+    /// where the products can overflow)
+    template <std::integral T>
+    using mul_uint_t = std::common_type_t<std::make_unsigned_t<T>, unsigned>;
+
+    /// @brief |v| as the unsigned type of T (exact for type_min<T> too)
+    template <std::signed_integral T>
+    [[nodiscard]] constexpr std::make_unsigned_t<T> magnitude(T v) noexcept {
+        using U = std::make_unsigned_t<T>;
+        return v < 0 ? static_cast<U>(U{0} - static_cast<U>(v)) : static_cast<U>(v);
+    }
+
+    /// @brief Wrapping multiplication (the caller detects the overflow)
+    template <std::signed_integral T>
+    [[nodiscard]] constexpr T wrap_mul(T a, T b) noexcept {
+        using U = mul_uint_t<T>;
+        return static_cast<T>(static_cast<U>(a) * static_cast<U>(b));
+    }
+}  // namespace detail
+
+/// @brief dst[i] = src[i] converted to the exponent of dst (same base), rounding with TagT when
+/// the precision decreases
+/// @return True if any value did not fit
+template <scaled_int_range SrcR, scaled_int_range DstR, rounding_tag TagT = default_round_t<DstR>>
+[[nodiscard]] constexpr bool rescale(SrcR const& src, DstR&& dst, TagT&& /*unused*/ = {}) noexcept {
+    using src_t     = scaled_elem_t<SrcR>;
+    using dst_t     = scaled_elem_t<DstR>;
+    using src_int_t = typename src_t::int_type;
+    using int_t     = typename dst_t::int_type;
+    using wide_t    = std::conditional_t<(sizeof(src_int_t) >= sizeof(int_t)), src_int_t, int_t>;
+    static_assert(src_t::base_val == dst_t::base_val, "rescale needs the same base");
+    assert(std::ranges::size(src) <= std::ranges::size(dst));
+
+    constexpr int  shift  = dst_t::exp_val - src_t::exp_val;
+    constexpr auto pw_val = Pow<static_cast<int8_t>(abs(shift)),
+                                static_cast<uint64_t>(dst_t::base_val)>::val;
+
+    auto const* in  = std::ranges::data(src);
+    auto*       out = std::ranges::data(dst);
+    size_t      n   = std::ranges::size(src);
+
+    if constexpr (shift >= 0) {  // more precision: multiply, only the extremes can overflow
+        // If the power does not fit int_t, any non-zero value overflows
+        constexpr bool pw_fits = std::in_range<int_t>(pw_val);
+        constexpr auto pw      = pw_fits ? static_cast<int_t>(pw_val) : int_t{0};
+        src_int_t      lo      = 0;
+        src_int_t      hi      = 0;
+        for (size_t i = 0; i < n; ++i) {
+            auto val     = in[i].value;
+            lo           = min(lo, val);
+            hi           = max(hi, val);
+            out[i].value = detail::wrap_mul(static_cast<int_t>(val), pw);
+        }
+        if constexpr (!pw_fits)
+            return lo != 0 || hi != 0;
+        else
+            return !std::in_range<int_t>(lo) || !std::in_range<int_t>(hi) ||
+                   static_cast<int_t>(hi) > type_max<int_t> / pw ||
+                   static_cast<int_t>(lo) < type_min<int_t> / pw;
+    } else {  // less precision: divide, it can only overflow when narrowing the type
+        static_assert(std::in_range<wide_t>(pw_val),
+                      "rescale divisor does not fit the source or destination int type");
+        constexpr auto pw = static_cast<wide_t>(pw_val);
+        wide_t         lo = 0;
+        wide_t         hi = 0;
+        for (size_t i = 0; i < n; ++i) {
+            auto val     = detail::div_round<TagT>(static_cast<wide_t>(in[i].value), pw);
+            lo           = min(lo, val);
+            hi           = max(hi, val);
+            out[i].value = static_cast<int_t>(val);
+        }
+        return !std::in_range<int_t>(lo) || !std::in_range<int_t>(hi);
+    }
+}
+
+/// @brief s[i] *= factor in place, integral factors are exact, floating ones are rounded with TagT
+/// @return True if any product did not fit
+template <scaled_int_range R, typename FactorT, rounding_tag TagT = default_round_t<R>>
+requires std::integral<FactorT> || std::floating_point<FactorT>
+[[nodiscard]] constexpr bool scale_mul(R&& s, FactorT factor, TagT&& /*unused*/ = {}) noexcept {
+    using int_t = typename scaled_elem_t<R>::int_type;
+    auto*  ptr  = std::ranges::data(s);
+    size_t n    = std::ranges::size(s);
+
+    if constexpr (std::integral<FactorT>) {
+        if (factor == 0 || n == 0) {
+            for (size_t i = 0; i < n; ++i)
+                ptr[i].value = 0;
+            return false;
+        }
+        if (!std::in_range<int_t>(factor))
+            return true;
+        int_t lo = 0;
+        int_t hi = 0;
+        auto  f  = static_cast<int_t>(factor);
+        for (size_t i = 0; i < n; ++i) {
+            lo           = min(lo, ptr[i].value);
+            hi           = max(hi, ptr[i].value);
+            ptr[i].value = detail::wrap_mul(ptr[i].value, f);
+        }
+        if (f > 0)
+            return hi > type_max<int_t> / f || lo < type_min<int_t> / f;
+        if (f == -1)
+            return lo == type_min<int_t>;
+        return hi > type_min<int_t> / f || lo < type_max<int_t> / f;
+    } else {
+        using F = std::conditional_t<(sizeof(FactorT) > sizeof(double)), FactorT, double>;
+        // type_max + 1 is a power of two, exact as floating point (type_max may not be)
+        constexpr auto lim_lo = static_cast<F>(type_min<int_t>);
+        constexpr auto lim_hi = static_cast<F>(type_max<int_t>) + F{1};
+        bool           bad    = false;
+        for (size_t i = 0; i < n; ++i) {
+            F    prod    = detail::float_round<TagT>(static_cast<F>(ptr[i].value) * factor);
+            bool fits    = prod >= lim_lo && prod < lim_hi;  // false for NaN too
+            bad         |= !fits;
+            ptr[i].value = fits ? static_cast<int_t>(prod) : int_t{0};
+        }
+        return bad;
+    }
+}
+
+/// @brief In place inclusive prefix sum
+/// @return True if any partial sum overflowed
+template <scaled_int_range R>
+[[nodiscard]] constexpr bool prefix_sum(R&& s) noexcept {
+    using int_t    = typename scaled_elem_t<R>::int_type;
+    auto*  ptr     = std::ranges::data(s);
+    size_t n       = std::ranges::size(s);
+    int_t  acc     = 0;
+    int_t  ovf_bit = 0;
+    for (size_t i = 0; i < n; ++i)
+        ptr[i].value = acc = detail::wrap_add(acc, ptr[i].value, ovf_bit);
+    return ovf_bit < 0;
+}
+
+/// @brief Sum of the elements
+template <scaled_int_range R>
+[[nodiscard]] constexpr auto sum(R const& s) noexcept {
+    using elem_t    = scaled_elem_t<R>;
+    using int_t     = typename elem_t::int_type;
+    auto const* ptr = std::ranges::data(s);
+    size_t      n   = std::ranges::size(s);
+    int_t       acc = 0;
+    int_t       ovf = 0;
+    for (size_t i = 0; i < n; ++i)
+        acc = detail::wrap_add(acc, ptr[i].value, ovf);
+    auto res  = elem_t{};
+    res.value = acc;
+    return checked<elem_t>{res, ovf < 0};
+}
+
+/// @brief Dot product. The raw values multiply, so the result has exponent E1 + E2 (an exact
+/// value, rescale it as needed). The vectorizable loop wraps around, a conservative bound from
+/// the largest magnitudes decides if an exact checked pass is needed to tell real overflows.
+template <scaled_int_range R1, scaled_int_range R2>
+[[nodiscard]] constexpr auto dot(R1 const& a, R2 const& b) noexcept {
+    using elem1_t = scaled_elem_t<R1>;
+    using elem2_t = scaled_elem_t<R2>;
+    using int_t   = std::common_type_t<typename elem1_t::int_type, typename elem2_t::int_type>;
+    using uint_t  = std::make_unsigned_t<int_t>;
+    using res_t   = ScaledInt<static_cast<int8_t>(elem1_t::exp_val + elem2_t::exp_val),
+                            elem1_t::base_val,
+                            int_t>;
+    static_assert(elem1_t::base_val == elem2_t::base_val, "dot needs the same base");
+    assert(std::ranges::size(a) == std::ranges::size(b));
+
+    auto const* pa = std::ranges::data(a);
+    auto const* pb = std::ranges::data(b);
+    size_t      n  = std::ranges::size(a);
+
+    uint_t acc    = 0;
+    uint_t max_ma = 0;
+    uint_t max_mb = 0;
+    for (size_t i = 0; i < n; ++i) {
+        auto va = static_cast<int_t>(pa[i].value);
+        auto vb = static_cast<int_t>(pb[i].value);
+        max_ma  = max(max_ma, detail::magnitude(va));
+        max_mb  = max(max_mb, detail::magnitude(vb));
+        acc += static_cast<uint_t>(static_cast<detail::mul_uint_t<int_t>>(va) *
+                                   static_cast<detail::mul_uint_t<int_t>>(vb));
+    }
+
+    auto res  = res_t{};
+    res.value = static_cast<int_t>(acc);
+
+    constexpr auto bound = static_cast<uint_t>(type_max<int_t>);
+    bool safe = n == 0 || max_ma == 0 || max_mb == 0 ||
+                (max_ma <= bound / max_mb && max_ma * max_mb <= bound / n);
+    if (safe)
+        return checked<res_t>{res, false};
+
+    // Exact pass: int128 products are exact, the sum wraps counting the turns, so only the final
+    // value decides (partial sums may leave the int_t range and come back)
+    __extension__ using int128_t = __int128;
+    int128_t exact = 0;
+    int64_t  turns = 0;
+    for (size_t i = 0; i < n; ++i) {
+        auto prod = static_cast<int128_t>(pa[i].value) * static_cast<int128_t>(pb[i].value);
+        if (__builtin_add_overflow(exact, prod, &exact))
+            turns += prod > 0 ? 1 : -1;
+    }
+    bool ovf = turns != 0 || exact < type_min<int_t> || exact > type_max<int_t>;
+    return checked<res_t>{res, ovf};
+}
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_NUMERIC_SCALED_KERNELS_HPP */
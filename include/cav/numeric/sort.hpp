@@ -17,10 +17,19 @@
 #define CAV_INCLUDE_RADIX_STUFF_HPP
 
 #include <algorithm>
+#include <barrier>
+#include <bit>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
+#include <memory>
+#include <memory_resource>
 #include <span>
+#include <thread>
+#include <utility>
+#include <vector>
 
+#include "../mish/AllocStats.hpp"
 #include "../mish/util_functions.hpp"
 #include "sorting_networks.hpp"
 
@@ -29,6 +38,25 @@ namespace cav {
 template <typename T>
 using Span = std::span<T>;
 
+template <std::contiguous_iterator ItT>
+[[nodiscard]] constexpr auto make_span(ItT beg, size_t sz) noexcept {
+    return Span<std::remove_reference_t<std::iter_reference_t<ItT>>>{beg, sz};
+}
+
+/// @brief Size crossovers used by Sorter::sort and Sorter::nth_element. The per-key-size tables are
+/// indexed by log2(sizeof(key)) (1, 2, 4 and 8 bytes), the defaults are sizeof(key) * 24 for
+/// net_sort vs radix_sort, sizeof(key) * 12 for insertion_sort vs radix_sort, 48 for nth_element.
+/// Sorter::calibrate measures them on the current machine.
+struct SortThresholds {
+    size_t net_sort[4]  = {24U, 48U, 96U, 192U};  // below: net_sort (identity keys)
+    size_t insertion[4] = {12U, 24U, 48U, 96U};   // below: insertion_sort (other keys)
+    size_t nth_sort     = 48U;                    // below: nth_element just sorts
+
+    [[nodiscard]] static constexpr size_t key_idx(size_t key_size) noexcept {
+        return min(static_cast<size_t>(std::bit_width(key_size)) - 1U, size_t{3});
+    }
+};
+
 /// @brief A class to sort and find the nth element of a container, keeping a buffer for performance
 /// and working with key instead of compartors.
 template <typename SzT = uint32_t, typename AlcT = std::allocator<char>>
@@ -36,19 +64,101 @@ struct Sorter : AlcT {
     using size_type  = SzT;
     using alloc_type = AlcT;
 
-    char*  cache_buff = nullptr;
-    size_t buff_size  = 0;
+    char*          cache_buff = nullptr;
+    size_t         buff_size  = 0;
+    SortThresholds thresholds = {};
 
     Sorter() = default;
 
+    explicit Sorter(AlcT const& alc)
+        : AlcT(alc) {
+    }
+
+    /// @brief Scratch memory from a memory resource (e.g. a thread-local monotonic arena)
+    explicit Sorter(std::pmr::memory_resource* resource)
+    requires std::is_constructible_v<AlcT, std::pmr::memory_resource*>
+        : AlcT(resource) {
+    }
+
+    /// @brief Adopt a working buffer previously obtained with release() from a Sorter with an
+    /// equal allocator.
     Sorter(char* buff, size_t sz, AlcT const& alc = {})
         : AlcT(alc)
         , cache_buff(buff)
         , buff_size(sz) {
+        if (buff != nullptr)
+            CAV_ALLOC_RECORD(Sorter, on_alloc, sz);
+    }
+
+    /// @brief Copies get their own (initially empty) working buffer
+    Sorter(Sorter const& other)
+        : AlcT(std::allocator_traits<AlcT>::select_on_container_copy_construction(other))
+        , thresholds(other.thresholds) {
+    }
+
+    Sorter(Sorter&& other) noexcept
+        : AlcT(std::move(static_cast<AlcT&>(other)))
+        , cache_buff(std::exchange(other.cache_buff, nullptr))
+        , buff_size(std::exchange(other.buff_size, 0))
+        , thresholds(other.thresholds) {
+    }
+
+    Sorter& operator=(Sorter const& other) {
+        if (this == &other)
+            return *this;
+        thresholds = other.thresholds;
+        if constexpr (std::allocator_traits<AlcT>::propagate_on_container_copy_assignment::value)
+            if (!(get_allocator() == other.get_allocator())) {  // our buffer belongs to ours
+                _deallocate();
+                static_cast<AlcT&>(*this) = static_cast<AlcT const&>(other);
+            }
+        return *this;
+    }
+
+    Sorter& operator=(Sorter&& other) noexcept {
+        if (this == &other)
+            return *this;
+        thresholds = other.thresholds;
+        if constexpr (std::allocator_traits<AlcT>::propagate_on_container_move_assignment::value) {
+            _deallocate();
+            static_cast<AlcT&>(*this) = std::move(static_cast<AlcT&>(other));
+        } else if (!(get_allocator() == other.get_allocator())) {
+            return *this;  // different arenas, keep our own buffer
+        } else {
+            _deallocate();
+        }
+        cache_buff = std::exchange(other.cache_buff, nullptr);
+        buff_size  = std::exchange(other.buff_size, 0);
+        return *this;
     }
 
     ~Sorter() {
-        delete[] cache_buff;
+        _deallocate();
+    }
+
+    [[nodiscard]] alloc_type get_allocator() const noexcept {
+        return static_cast<AlcT const&>(*this);
+    }
+
+    /// @brief Grow the working buffer to at least `bytes` bytes
+    void reserve(size_t bytes) {
+        if (bytes > buff_size)
+            _allocate(bytes);
+    }
+
+    /// @brief Reduce the working buffer to `bytes` bytes (freeing it for 0)
+    void shrink(size_t bytes = 0) {
+        if (bytes == 0)
+            _deallocate();
+        else if (bytes < buff_size)
+            _allocate(bytes);
+    }
+
+    /// @brief Hand over the working buffer (e.g. to another Sorter constructor), leaving this empty
+    [[nodiscard]] std::pair<char*, size_t> release() noexcept {
+        if (cache_buff != nullptr)
+            CAV_ALLOC_RECORD(Sorter, on_free, buff_size);
+        return {std::exchange(cache_buff, nullptr), std::exchange(buff_size, 0)};
     }
 
     template <typename C>
@@ -62,7 +172,7 @@ private:
     requires(!std::is_trivially_copyable_v<D>)
     void _move_uninit(D& dest, S&& src) {
         new (std::addressof(dest)) D(std::forward<S>(src));
-        src.~S();
+        std::destroy_at(std::addressof(src));
     }
 
     template <typename D, typename S>
@@ -72,73 +182,111 @@ private:
         std::memcpy(std::addressof(dest), std::addressof(src), sizeof(D));
     }
 
+    /// @brief Unit of the working buffer allocations, cache-line sized and aligned
+    struct alignas(64) buff_block {
+        char bytes[64];
+    };
+
+    using block_alloc = typename std::allocator_traits<AlcT>::template rebind_alloc<buff_block>;
+
+    static constexpr size_t _n_blocks(size_t bytes) noexcept {
+        return (bytes + sizeof(buff_block) - 1) / sizeof(buff_block);
+    }
+
+    void _deallocate() noexcept {
+        if (cache_buff != nullptr) {
+            CAV_ALLOC_RECORD(Sorter, on_free, buff_size);
+            auto alc = block_alloc(get_allocator());
+            alc.deallocate(reinterpret_cast<buff_block*>(cache_buff), _n_blocks(buff_size));
+        }
+        cache_buff = nullptr;
+        buff_size  = 0;
+    }
+
+    void _allocate(size_t bytes) {
+        if (cache_buff != nullptr)
+            CAV_ALLOC_RECORD(Sorter, on_grow);
+        _deallocate();
+        auto   alc      = block_alloc(get_allocator());
+        size_t n_blocks = _n_blocks(bytes);
+        cache_buff      = reinterpret_cast<char*>(alc.allocate(n_blocks));
+        buff_size       = n_blocks * sizeof(buff_block);
+        CAV_ALLOC_RECORD(Sorter, on_alloc, buff_size);
+    }
+
     /// @brief Provide a working buffer maintained between calls to avoid reallocations
     template <typename T>
-    Span<T*> _get_span(size_t sz) {
+    Span<T> _get_span(size_t sz) {
         size_t char_sz = sz * sizeof(T);
-        if (char_sz > buff_size) {
-            alloc_type::deallocate(cache_buff, buff_size);
-            cache_buff = alloc_type::allocate(char_sz);
-            buff_size  = char_sz;
-        }
+        if (char_sz > buff_size)
+            _allocate(char_sz);
         return make_span(reinterpret_cast<T*>(cache_buff), sz);
     }
 
+public:
     /////////////////////////// KEYS CONVERSION ///////////////////////////
 
-    static uint8_t _to_uint(uint8_t k) noexcept {
+    // Order-preserving maps of the keys to unsigned integers (public, used by RadixHeap too)
+
+    static constexpr uint8_t _to_uint(uint8_t k) noexcept {
 
         return k;
     }
 
-    static uint16_t _to_uint(uint16_t k) noexcept {
+    static constexpr uint16_t _to_uint(uint16_t k) noexcept {
         return k;
     }
 
-    static uint32_t _to_uint(uint32_t k) noexcept {
+    static constexpr uint32_t _to_uint(uint32_t k) noexcept {
         return k;
     }
 
-    static uint64_t _to_uint(uint64_t k) noexcept {
+    static constexpr uint64_t _to_uint(uint64_t k) noexcept {
         return k;
     }
 
-    static uint8_t _to_uint(int8_t k) noexcept {
+    static constexpr uint8_t _to_uint(int8_t k) noexcept {
         return static_cast<uint8_t>(k) + static_cast<uint8_t>(1U << 7U);
     }
 
-    static uint16_t _to_uint(int16_t k) noexcept {
+    static constexpr uint16_t _to_uint(int16_t k) noexcept {
         return static_cast<uint16_t>(k) + static_cast<uint16_t>(1U << 15U);
     }
 
-    static uint32_t _to_uint(int32_t k) noexcept {
+    static constexpr uint32_t _to_uint(int32_t k) noexcept {
         return static_cast<uint32_t>(k) + (1U << 31U);
     }
 
-    static uint64_t _to_uint(int64_t k) noexcept {
+    static constexpr uint64_t _to_uint(int64_t k) noexcept {
         return static_cast<uint64_t>(k) + (1ULL << 63U);
     }
 
-    static uint32_t _to_uint(float f) noexcept {
+    static constexpr uint32_t _to_uint(float f) noexcept {
         auto unsgn     = std::bit_cast<uint32_t>(f);
         auto sign_mask = static_cast<uint32_t>(-static_cast<int32_t>(unsgn >> 31U));
         return unsgn ^ (sign_mask | (1U << 31U));
     }
 
-    static uint64_t _to_uint(double d) noexcept {
+    static constexpr uint64_t _to_uint(double d) noexcept {
         auto unsgn     = std::bit_cast<uint64_t>(d);
         auto sign_mask = static_cast<uint64_t>(-static_cast<int64_t>(unsgn >> 63U));
         return unsgn ^ (sign_mask | (1ULL << 63U));
     }
 
+private:
     ////////////////////////////////////////////////////////////////////////////
     //////////////////////////////// RADIX SORT ////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////
 
     template <typename C1, typename C2, typename K>
-    void _byte_sort(C1& cont1, C2& cont2, K&& key, size_t b, uint32_t (&counters)[2][256]) {
-        bool     active_c = b & 1U;
-        uint32_t tot      = 0;
+    void _byte_sort(C1&    cont1,
+                    C2&    cont2,
+                    K&&    key,
+                    size_t b,
+                    size_t next_b,
+                    bool   active_c,
+                    uint32_t (&counters)[2][256]) {
+        uint32_t tot = 0;
         for (size_t i = 0; i < 256; ++i) {
             uint32_t old_count     = counters[active_c][i];
             counters[active_c][i]  = tot;
@@ -147,32 +295,310 @@ private:
         }
 
         for (auto& elem : cont1) {
-            auto k = _to_uint(key(elem)) >> (b * 8U);
-            assert(counters[active_c][static_cast<uint8_t>(k)] < size(cont2));
-            _move_uninit(cont2[counters[active_c][static_cast<uint8_t>(k)]], elem);
-            ++counters[active_c][static_cast<uint8_t>(k)];
-            ++counters[!active_c][static_cast<uint8_t>(k >> 8U)];
+            auto k = _to_uint(key(elem));
+            auto d = static_cast<uint8_t>(k >> (b * 8U));
+            assert(counters[active_c][d] < size(cont2));
+            _move_uninit(cont2[counters[active_c][d]], elem);
+            ++counters[active_c][d];
+            ++counters[!active_c][static_cast<uint8_t>(k >> (next_b * 8U))];
+        }
+    }
+
+    /// @brief LSD radix passes of container using buffer (same size) as scatter destination. The
+    /// first histogram pass also collects which key bytes differ across the elements, bytes that
+    /// are constant for all the keys are skipped entirely (no scatter), so small-range keys only
+    /// pay for the bytes they actually use. Returns true if the sorted sequence ended in buffer.
+    template <typename C, typename B, typename K>
+    bool _lsd_sort(C& container, B& buffer, K&& key) {
+        using ukey_type          = no_cvr<decltype(_to_uint(std::declval<key_t<C, K>>()))>;
+        constexpr size_t n_bytes = sizeof(key_t<C, K>);
+
+        size_t csize = size(container);
+        if (csize < 2)
+            return false;
+
+        uint32_t  counters[2][256] = {};  // counters are computed later to reduce stack usage
+        ukey_type first_k          = _to_uint(key(container[0]));
+        ukey_type diff_bits        = 0;
+        for (auto const& elem : container) {
+            ukey_type k = _to_uint(key(elem));
+            diff_bits |= k ^ first_k;
+            ++counters[0][static_cast<uint8_t>(k)];
+        }
+
+        auto next_byte = [&](size_t b) {
+            while (b < n_bytes && static_cast<uint8_t>(diff_bits >> (b * 8U)) == 0)
+                ++b;
+            return b;
+        };
+
+        size_t b = next_byte(0);
+        if (b == n_bytes)  // all keys are equal
+            return false;
+        if (b > 0) {  // first byte was constant, count the first one that is not
+            std::fill(std::begin(counters[0]), std::end(counters[0]), 0U);
+            for (auto const& elem : container)
+                ++counters[0][static_cast<uint8_t>(_to_uint(key(elem)) >> (b * 8U))];
+        }
+
+        bool active_c = false, in_buff = false;
+        while (b < n_bytes) {
+            size_t next_b  = next_byte(b + 1);
+            size_t count_b = min(next_b, n_bytes - 1);
+            if (in_buff)
+                _byte_sort(buffer, container, key, b, count_b, active_c, counters);
+            else
+                _byte_sort(container, buffer, key, b, count_b, active_c, counters);
+            in_buff  = !in_buff;
+            active_c = !active_c;
+            b        = next_b;
         }
+        return in_buff;
+    }
+
+    /// @brief Element of the argsort buffers: the converted key and the original position
+    template <typename UK>
+    struct key_idx {
+        UK        key;
+        size_type idx;
+    };
+
+    /// @brief Two spans carved from the same working buffer, the second one properly aligned
+    template <typename T1, typename T2>
+    std::pair<Span<T1>, Span<T2>> _get_spans(size_t sz1, size_t sz2) {
+        size_t off   = (sz1 * sizeof(T1) + alignof(T2) - 1) / alignof(T2) * alignof(T2);
+        auto   chars = _get_span<char>(off + sz2 * sizeof(T2));
+        return {make_span(reinterpret_cast<T1*>(chars.data()), sz1),
+                make_span(reinterpret_cast<T2*>(chars.data() + off), sz2)};
+    }
+
+    /// @brief Radix sort (key, index) pairs of container inside pairs (2 * size(container) long).
+    /// Returns the half of pairs holding the sorted sequence.
+    template <typename C, typename P, typename K>
+    auto _argsort_pairs(C const& container, P pairs, K&& key) {
+        size_t csize = size(container);
+        auto   lo    = pairs.first(csize);
+        auto   hi    = pairs.last(csize);
+        for (size_t i = 0; i < csize; ++i) {
+            lo[i].key = _to_uint(key(container[i]));
+            lo[i].idx = static_cast<size_type>(i);
+        }
+        return _lsd_sort(lo, hi, [](auto const& p) { return p.key; }) ? hi : lo;
     }
 
 public:
+    /// @brief LSD radix sort, see _lsd_sort.
     template <typename C, typename K = IdentityFtor>
     void radix_sort(C& container, K&& key = {}) {
-        constexpr size_t n_bytes = sizeof(key_t<C, K>);
+        size_t csize = size(container);
+        if (csize < 2)
+            return;
 
-        uint32_t counters[2][256] = {};  // counters are computed later to reduce stack usage
-        for (auto const& elem : container)
-            ++counters[0][static_cast<uint8_t>(_to_uint(key(elem)))];
+        auto val_buff = _get_span<value_t<C>>(csize);
+        if (_lsd_sort(container, val_buff, key))
+            for (size_t i = 0; i < csize; ++i)
+                _move_uninit(container[i], val_buff[i]);
+    }
 
-        auto val_buff = _get_span<value_t<C>>(size(container));
-        for (uint32_t b = 0; b < n_bytes; ++b) {
-            _byte_sort(container, val_buff, key, b, counters);
-            if (++b == n_bytes) {
-                std::move(std::begin(val_buff), std::end(val_buff), std::begin(container));
-                return;
+    /////////////////////////// ARGSORT RADIX SORT /////////////////////////////
+
+    /// @brief Stable argsort: perm[i] becomes the position in container of the i-th smallest
+    /// element. Only (key, size_type index) pairs are moved during the radix passes.
+    template <typename C, typename P, typename K = IdentityFtor>
+    void radix_argsort(C const& container, P& perm, K&& key = {}) {
+        using ukey_type = no_cvr<decltype(_to_uint(std::declval<key_t<C, K>>()))>;
+        size_t csize    = size(container);
+        assert(size(perm) == csize);
+
+        auto sorted = _argsort_pairs(container, _get_span<key_idx<ukey_type>>(csize * 2), key);
+        for (size_t i = 0; i < csize; ++i)
+            perm[i] = sorted[i].idx;
+    }
+
+    /// @brief Reorder container so that its i-th element becomes the old container[perm[i]]
+    template <typename C, typename P>
+    void apply_permutation(C& container, P const& perm) {
+        size_t csize = size(container);
+        assert(size(perm) == csize);
+
+        auto val_buff = _get_span<value_t<C>>(csize);
+        for (size_t i = 0; i < csize; ++i)
+            _move_uninit(val_buff[i], container[perm[i]]);
+        for (size_t i = 0; i < csize; ++i)
+            _move_uninit(container[i], val_buff[i]);
+    }
+
+    /// @brief Stable radix sort for fat elements: the passes move only (key, index) pairs and each
+    /// element is moved once at the end (twice counting the move back from the buffer).
+    template <typename C, typename K = IdentityFtor>
+    void key_radix_sort(C& container, K&& key = {}) {
+        using ukey_type = no_cvr<decltype(_to_uint(std::declval<key_t<C, K>>()))>;
+        size_t csize    = size(container);
+        if (csize < 2)
+            return;
+
+        auto [pairs, val_buff] = _get_spans<key_idx<ukey_type>, value_t<C>>(csize * 2, csize);
+        auto sorted            = _argsort_pairs(container, pairs, key);
+        for (size_t i = 0; i < csize; ++i)
+            _move_uninit(val_buff[i], container[sorted[i].idx]);
+        for (size_t i = 0; i < csize; ++i)
+            _move_uninit(container[i], val_buff[i]);
+    }
+
+    /////////////////////////// SOA COLUMNS SORT ///////////////////////////////
+private:
+    static constexpr size_t gather_prefetch = 16U;  // rows ahead prefetched by the column gathers
+
+    /// @brief Gather each column of soa (see SoAColumns) at the positions src(i) through col_buff,
+    /// one streaming pass per column plus the move back.
+    template <typename S, typename F>
+    void _gather_columns(S& soa, Span<buff_block> col_buff, F&& src) {
+        soa.for_each_column([&]<typename T>(T* col, size_t csize) {
+            static_assert(alignof(T) <= alignof(buff_block), "Over-aligned column type");
+            auto tmp = make_span(reinterpret_cast<T*>(col_buff.data()), csize);
+            for (size_t i = 0; i < csize; ++i) {
+                if (i + gather_prefetch < csize)
+                    __builtin_prefetch(col + src(i + gather_prefetch));
+                _move_uninit(tmp[i], col[src(i)]);
             }
-            _byte_sort(val_buff, container, key, b, counters);
+            for (size_t i = 0; i < csize; ++i)
+                _move_uninit(col[i], tmp[i]);
+        });
+    }
+
+    template <typename S>
+    static constexpr size_t _max_col_bytes(S& soa) {
+        size_t bytes = 0;
+        soa.for_each_column([&]<typename T>(T*, size_t n) { bytes = max(bytes, n * sizeof(T)); });
+        return bytes;
+    }
+
+public:
+    /// @brief Stable radix sort of a SoA container (SoAArray<soa_tag, ...>, SoAVector) by the
+    /// column KeyCol: only the key column is radix sorted (as (key, index) pairs), then every
+    /// column is gathered once, without going through the tuple proxies.
+    template <size_t KeyCol, typename S, typename K = IdentityFtor>
+    requires requires(S& soa) { soa.template column<KeyCol>(); }
+    void column_radix_sort(S& soa, K&& key = {}) {
+        auto keys       = soa.template column<KeyCol>();
+        using ukey_type = no_cvr<decltype(_to_uint(std::declval<key_t<decltype(keys), K>>()))>;
+        size_t csize    = keys.size();
+        if (csize < 2)
+            return;
+
+        auto [pairs, col_buff] = _get_spans<key_idx<ukey_type>, buff_block>(
+            csize * 2, _n_blocks(_max_col_bytes(soa)));
+        auto sorted = _argsort_pairs(keys, pairs, key);
+        _gather_columns(soa, col_buff, [&](size_t i) { return sorted[i].idx; });
+    }
+
+    /// @brief Column-wise apply_permutation for SoA containers: the i-th row becomes the old
+    /// perm[i]-th one.
+    template <typename S, typename P>
+    requires requires(S& soa) { soa.template column<0>(); }
+    void permute_columns(S& soa, P const& perm) {
+        assert(size(perm) == soa.size());
+        auto col_buff = _get_span<buff_block>(_n_blocks(_max_col_bytes(soa)));
+        _gather_columns(soa, col_buff, [&](size_t i) { return perm[i]; });
+    }
+
+    /////////////////////////// PARALLEL RADIX SORT ////////////////////////////
+private:
+    /// @brief Per-thread byte histogram, padded to avoid false sharing between workers
+    struct alignas(64) thread_counters {
+        size_type counts[256];
+    };
+
+    /// @brief Below this number of elements per thread, spawning threads costs more than sorting
+    static constexpr size_t par_min_chunk = 1U << 16U;
+
+    /// @brief Returns false if the pass has been skipped (all the keys share the same digit)
+    template <typename C1, typename C2, typename K>
+    bool _par_byte_sort(C1&                        cont1,
+                        C2&                        cont2,
+                        K&&                        key,
+                        size_t                     b,
+                        size_t                     t,
+                        std::span<thread_counters> counters,
+                        bool&                      skip_pass,
+                        std::barrier<>&            sync) {
+        size_t n_thr = size(counters);
+        size_t beg   = t * size(cont1) / n_thr;
+        size_t end   = (t + 1) * size(cont1) / n_thr;
+
+        size_type(&counts)[256] = counters[t].counts;
+        std::fill(std::begin(counts), std::end(counts), size_type{});
+        for (size_t i = beg; i < end; ++i)
+            ++counts[static_cast<uint8_t>(_to_uint(key(cont1[i])) >> (b * 8U))];
+        sync.arrive_and_wait();
+
+        if (t == 0) {  // Global offsets: bucket-major, thread-minor to preserve stability
+            size_type tot = 0;
+            skip_pass     = false;
+            for (size_t i = 0; i < 256; ++i) {
+                size_type bucket_beg = tot;
+                for (auto& thr_c : counters) {
+                    size_type old_count = thr_c.counts[i];
+                    thr_c.counts[i]     = tot;
+                    tot += old_count;
+                }
+                skip_pass |= (tot - bucket_beg == size(cont1));
+            }
+        }
+        sync.arrive_and_wait();
+        if (skip_pass)  // same value for all workers, no one waits on the last barrier
+            return false;
+
+        for (size_t i = beg; i < end; ++i) {
+            auto k = static_cast<uint8_t>(_to_uint(key(cont1[i])) >> (b * 8U));
+            assert(counts[k] < size(cont2));
+            _move_uninit(cont2[counts[k]++], cont1[i]);
         }
+        sync.arrive_and_wait();
+        return true;
+    }
+
+public:
+    /// @brief LSD radix sort where every pass is split among n_threads workers. Each worker builds
+    /// the histogram of its own chunk, offsets are then prefix-summed across workers and each
+    /// worker scatters its chunk into the shared working buffer. Like in radix_sort, passes over
+    /// digits shared by all the keys are skipped.
+    /// Falls back to the sequential radix_sort when the input is too small to be split.
+    template <typename C, typename K = IdentityFtor>
+    void par_radix_sort(C& container, size_t n_threads, K&& key = {}) {
+        constexpr size_t n_bytes = sizeof(key_t<C, K>);
+
+        size_t csize = size(container);
+        assert(csize <= static_cast<size_t>(type_max<size_type>));
+        n_threads = min(n_threads, csize / par_min_chunk);
+        if (n_threads <= 1)
+            return radix_sort(container, key);
+
+        auto val_buff = _get_span<value_t<C>>(csize);
+        auto counters = std::vector<thread_counters>(n_threads);
+        auto sync     = std::barrier<>(static_cast<ptrdiff_t>(n_threads));
+        bool skip     = false;
+
+        auto worker = [&](size_t t) {
+            bool in_buff = false;
+            for (size_t b = 0; b < n_bytes; ++b)
+                if (in_buff)
+                    in_buff = !_par_byte_sort(val_buff, container, key, b, t, counters, skip, sync);
+                else
+                    in_buff = _par_byte_sort(container, val_buff, key, b, t, counters, skip, sync);
+
+            if (in_buff) {
+                size_t beg = t * csize / n_threads, end = (t + 1) * csize / n_threads;
+                for (size_t i = beg; i < end; ++i)
+                    _move_uninit(container[i], val_buff[i]);
+            }
+        };
+
+        auto threads = std::vector<std::jthread>();
+        threads.reserve(n_threads - 1);
+        for (size_t t = 1; t < n_threads; ++t)
+            threads.emplace_back(worker, t);
+        worker(0);
     }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -422,20 +848,92 @@ public:
     template <typename C, typename K = IdentityFtor>
     void insertion_sort(C& container, K&& key = {}) {
 
-        auto cbeg = std::begin(container);
-        auto buff = _get_span<container_value_type_t<C>>(size(container));
-        auto b    = std::begin(buff);
-        for (auto i = cbeg; i < std::end(container) - 1; ++i) {
-            auto mink = key(*i);
-            auto min  = i;
-            for (auto j = i + 1; j < std::end(container); ++j) {
-                min  = key(*j) < mink ? j : min;
-                mink = key(*j) < mink ? key(*j) : mink;
-            }
-            _move_uninit(*b, *min);
-            ++b;
+        size_t csize = size(container);
+        for (size_t i = 1; i < csize; ++i) {
+            auto k = key(container[i]);
+            if (!(k < key(container[i - 1])))
+                continue;
+
+            auto   tmp = std::move(container[i]);
+            size_t j   = i;
+            for (; j > 0 && k < key(container[j - 1]); --j)
+                container[j] = std::move(container[j - 1]);
+            container[j] = std::move(tmp);
         }
-        std::move(std::begin(buff), std::end(buff), std::begin(container));
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////// MSD RADIX SORT /////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////
+private:
+    /// @brief Buckets up to this size are handed to net_sort instead of being radix-sorted
+    static constexpr size_t msd_net_size = NET_SIZE * 4U;
+
+    template <typename C, typename K>
+    void _msd_sort(C container, K&& key, size_t b) {
+        using ukey_type = no_cvr<decltype(_to_uint(std::declval<key_t<C, K>>()))>;
+
+        size_t csize = size(container);
+        if (csize <= NET_SIZE)
+            return _net_dispatch(container, key);
+        if (csize <= msd_net_size)
+            return net_sort(container, key);
+
+        size_type counts[256] = {};
+        ukey_type first_k     = _to_uint(key(container[0]));
+        ukey_type diff_bits   = 0;
+        for (auto const& elem : container) {
+            ukey_type k = _to_uint(key(elem));
+            diff_bits |= k ^ first_k;
+            ++counts[static_cast<uint8_t>(k >> (b * 8U))];
+        }
+        if (diff_bits == 0)  // All keys are equal
+            return;
+
+        // Skip all the constant digits at once, the most significant varying one is the next
+        size_t top_b = (std::bit_width(diff_bits) - 1U) / 8U;
+        assert(top_b <= b);
+        if (top_b < b) {
+            b = top_b;
+            std::fill(std::begin(counts), std::end(counts), size_type{});
+            for (auto const& elem : container)
+                ++counts[static_cast<uint8_t>(_to_uint(key(elem)) >> (b * 8U))];
+        }
+
+        // American flag permutation: each element is swapped directly into its bucket
+        size_type heads[256], tails[256];
+        size_type tot = 0;
+        for (size_t i = 0; i < 256; ++i) {
+            heads[i] = tot;
+            tot += counts[i];
+            tails[i] = tot;
+        }
+        for (size_t i = 0; i < 256; ++i)
+            while (heads[i] < tails[i]) {
+                auto d = static_cast<uint8_t>(_to_uint(key(container[heads[i]])) >> (b * 8U));
+                if (d == i)
+                    ++heads[i];
+                else
+                    std::swap(container[heads[i]], container[heads[d]++]);
+            }
+
+        if (b == 0)
+            return;
+        for (size_t i = 0, beg = 0; i < 256; beg += counts[i], ++i)
+            if (counts[i] > 1)
+                _msd_sort(make_span(std::begin(container) + beg, counts[i]), key, b - 1);
+    }
+
+public:
+    /// @brief MSD (American flag) radix sort. Digits that are constant across a bucket are skipped
+    /// after the first histogram pass, so wide keys with low entropy (e.g., timestamps or ids
+    /// sharing the top bytes) cost far fewer memory passes than the LSD radix_sort.
+    /// Buckets are refined recursively and small ones are sorted with the sorting networks.
+    /// In-place (no buffer for the radix part) but not stable.
+    template <typename C, typename K = IdentityFtor>
+    void msd_radix_sort(C& container, K&& key = {}) {
+        assert(size(container) <= static_cast<size_t>(type_max<size_type>));
+        _msd_sort(make_span(std::begin(container), size(container)), key, sizeof(key_t<C, K>) - 1);
     }
 
     //////////////////////////////////////////////////////////////////////////////////////
@@ -444,62 +942,71 @@ public:
 
     /////////////////////////// DUTCH FLAG NTH ELEMENT ///////////////////////////////////
 private:
+    /// @brief In-place three-way partition of container around the converted key kth: two
+    /// branchless Lomuto passes, for the keys less than kth and then for the ones equal to it.
     template <typename C, typename V, typename K>
-    void _three_partition(C& container, V mid, size_t mid_start, K&& key) {
-        auto   key_buff = _get_span<value_t<C>>(size(container));
-        size_t front = 0, back = size(container) - 1;
-        for (auto& elem : container) {
-            auto   k   = _to_uint(key(elem));
-            size_t idx = k < mid ? front++ : k > mid ? back-- : mid_start++;
-            _move_uninit(key_buff[idx], elem);
+    void _three_partition(C& container, V kth, K&& key) {
+        size_t csize = size(container);
+        size_t lo    = 0;
+        for (size_t i = 0; i < csize; ++i) {
+            bool less = _to_uint(key(container[i])) < kth;
+            std::swap(container[lo], container[i]);
+            lo += less;
+        }
+        for (size_t i = lo; i < csize; ++i) {
+            bool equal = !(kth < _to_uint(key(container[i])));
+            std::swap(container[lo], container[i]);
+            lo += equal;
         }
-        std::move(std::begin(key_buff), std::end(key_buff), std::begin(container));
     }
 
 public:
+    /// @brief Radix select: the nth key is found narrowing down one byte bucket at a time on a copy
+    /// of the keys (from the most significant byte, the candidates shrink at each step), then the
+    /// elements are three-way partitioned around it in place.
     template <typename C, typename K = IdentityFtor>
     void dutch_nth_elem(C& container, size_t nth, K&& key = {}) {
-        using ukey_type           = no_cvr<decltype(_to_uint(std::declval<key_t<C, K>>()))>;
-        constexpr size_t n_bytes  = sizeof(key_t<C, K>);
-        size_t           nth_copy = nth;
+        using ukey_type          = no_cvr<decltype(_to_uint(std::declval<key_t<C, K>>()))>;
+        constexpr size_t n_bytes = sizeof(key_t<C, K>);
 
+        size_t csize = size(container);
+        assert(nth < csize);
+        if (csize < 2)
+            return;
+
+        auto     key_buff      = _get_span<ukey_type>(csize);
         uint32_t counters[256] = {};
-        auto     key_buff      = _get_span<ukey_type>(size(container));
-        for (size_t i = 0; i < size(container); ++i) {
+        for (size_t i = 0; i < csize; ++i) {
             key_buff[i] = _to_uint(key(container[i]));
             ++counters[static_cast<uint8_t>(key_buff[i] >> (n_bytes - 1U) * 8U)];
         }
 
-        for (uint32_t b = 0; b < n_bytes; ++b) {
-
-            uint8_t median      = 0;
-            size_t  bucket_size = 0;
-            for (size_t i = 0; i < 256; ++i) {
-                if (nth_copy < counters[i]) {
-                    bucket_size = counters[i];
-                    median      = i;
-                    break;
-                }
-                nth_copy -= counters[i];
+        size_t rank = nth;  // rank of the nth element among the current candidates
+        for (size_t b = n_bytes - 1;; --b) {
+            size_t digit = 0;
+            while (rank >= counters[digit])
+                rank -= counters[digit++];
+            size_t bucket_size = counters[digit];
+            if (bucket_size == 1 || b == 0) {  // found, compact only what is needed
+                size_t j = 0;
+                while (static_cast<uint8_t>(key_buff[j] >> (b * 8U)) != digit)
+                    ++j;
+                key_buff[0] = key_buff[j];
+                break;
             }
-            for (auto& c : counters)
-                c = 0;
 
-            size_t   count      = 0;
-            uint32_t shift      = (n_bytes - b - 1U) * 8;
-            uint32_t next_shift = (max(2U, n_bytes - b) - 2U) * 8;
+            std::fill(std::begin(counters), std::end(counters), 0U);
+            size_t count = 0;
             for (size_t j = 0; count < bucket_size; ++j) {
-                uint8_t k       = key_buff[j] >> shift;
-                uint8_t next_k  = key_buff[j] >> next_shift;
-                key_buff[count] = key_buff[j];
-                counters[next_k] += (k == median);
-                count += (k == median);
+                ukey_type k  = key_buff[j];
+                bool      in = static_cast<uint8_t>(k >> (b * 8U)) == digit;
+                key_buff[count] = k;
+                counters[static_cast<uint8_t>(k >> ((b - 1U) * 8U))] += in;
+                count += in;
             }
-            if (count == 1)
-                break;
         }
 
-        _three_partition(container, key_buff[0], nth - nth_copy, key);
+        _three_partition(container, key_buff[0], key);
     }
 
     ////////////////////////////// RADIX NTH ELEMENT /////////////////////////////////////
@@ -587,14 +1094,15 @@ public:
     template <typename C, typename K = IdentityFtor>
     requires std::is_same_v<value_t<C>, key_t<C, K>>
     auto sort(C& container, K&& key = {}) {
+        constexpr size_t key_pos = SortThresholds::key_idx(sizeof(key_t<C, K>));
 
         // Best effort to detect identity key
         if (key(container[0]) < container[0] || key(container[0]) > container[0])
-            if (size(container) < sizeof(key_t<C, K>) * 12)
+            if (size(container) < thresholds.insertion[key_pos])
                 insertion_sort(container, key);
             else
                 radix_sort(container, key);
-        else if (size(container) < sizeof(key_t<C, K>) * 24)
+        else if (size(container) < thresholds.net_sort[key_pos])
             net_sort(container, key);
         else
             radix_sort(container, key);
@@ -608,8 +1116,9 @@ public:
     template <typename C, typename K = IdentityFtor>
     requires(!std::is_same_v<value_t<C>, key_t<C, K>>)
     auto sort(C& container, K&& key = {}) {
+        constexpr size_t key_pos = SortThresholds::key_idx(sizeof(key_t<C, K>));
 
-        if (size(container) < sizeof(key_t<C, K>) * 12)
+        if (size(container) < thresholds.insertion[key_pos])
             insertion_sort(container, key);
         else
             radix_sort(container, key);
@@ -620,12 +1129,15 @@ public:
             [&](value_t<C> const& a, value_t<C> const& b) { return key(a) < key(b); }));
     }
 
+    /// @brief partial_sort selects with a bounded heap when size >= k * top_k_heap_ratio
+    static constexpr size_t top_k_heap_ratio = 128U;
+
     template <typename C, typename K = IdentityFtor>
     void nth_element(C& container, size_t nth, K&& key = {}) {
-        if (size(container) < 48U)
+        if (size(container) < thresholds.nth_sort)
             sort(container, key);
         else
-            radix_nth_elem(container, nth, key);  // Faster for smaller types
+            dutch_nth_elem(container, nth, key);
 
 #ifndef NDEBUG
         for (size_t i = 0; i < nth; ++i)
@@ -634,6 +1146,254 @@ public:
             assert(_to_uint(key(container[i])) >= _to_uint(key(container[nth])));
 #endif
     }
+
+    /// @brief Top-k: the k smallest elements are moved to the front of the container in sorted
+    /// order and returned. For k small w.r.t. the size they are collected in one pass with a
+    /// bounded max-heap, otherwise with a radix select.
+    template <typename C, typename K = IdentityFtor>
+    auto partial_sort(C& container, size_t k, K&& key = {}) {
+        using ukey_type = no_cvr<decltype(_to_uint(std::declval<key_t<C, K>>()))>;
+
+        size_t csize = size(container);
+        k            = min(k, csize);
+        auto top_k   = make_span(std::begin(container), k);
+        if (k == 0)
+            return top_k;
+
+        if (k * top_k_heap_ratio <= csize) {
+            // Bounded max-heap on the first k elements, replacements are rare for random inputs
+            auto cmp = [&](value_t<C> const& a, value_t<C> const& b) {
+                return _to_uint(key(a)) < _to_uint(key(b));
+            };
+            std::make_heap(std::begin(top_k), std::end(top_k), cmp);
+            ukey_type top = _to_uint(key(top_k[0]));
+            for (size_t i = k; i < csize; ++i) {
+                if (_to_uint(key(container[i])) < top) {
+                    std::pop_heap(std::begin(top_k), std::end(top_k), cmp);
+                    std::swap(top_k[k - 1], container[i]);
+                    std::push_heap(std::begin(top_k), std::end(top_k), cmp);
+                    top = _to_uint(key(top_k[0]));
+                }
+            }
+        } else if (k < csize) {
+            nth_element(container, k - 1, key);
+        }
+        sort(top_k, key);
+        return top_k;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////// SEGMENTED SORT /////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////
+private:
+    /// @brief Small segments of arithmetic values are sorted this many at a time, one per lane of
+    /// a 32-byte simd_vec (AVX2 width; split into two registers where narrower).
+    template <typename T>
+    static constexpr size_t seg_lanes = 32U / sizeof(T);
+
+    /// @brief Segments are grouped by size within windows of this many, to keep them in cache
+    static constexpr size_t seg_window = 1024U;
+
+    template <typename T, typename K>
+    static constexpr bool seg_lanes_v = (std::is_integral_v<T> || std::is_floating_point_v<T>) &&
+                                        !eq<T, bool> && sizeof(T) <= 8U &&
+                                        eq<no_cvr<K>, IdentityFtor>;
+
+    /// @brief Same choices done by sort(), with the identity-key detection done once by the caller
+    template <typename C, typename K>
+    void _sort_segment(C segment, K&& key, bool identity) {
+        constexpr size_t key_pos = SortThresholds::key_idx(sizeof(key_t<C, K>));
+        size_t           ssize   = size(segment);
+        if (ssize <= NET_SIZE)
+            _net_dispatch(segment, key);
+        else if (identity && ssize < thresholds.net_sort[key_pos])
+            net_sort(segment, key);
+        else if (!identity && ssize < thresholds.insertion[key_pos])
+            insertion_sort(segment, key);
+        else
+            radix_sort(segment, key);
+    }
+
+    /// @brief Sort groups of seg_lanes same-sized segments transposed into the simd_vec lanes
+    template <typename C, typename O, typename I>
+    void _lanes_sort_segments(C& container, O const& offsets, I seg_idxs, size_t seg_sz) {
+        using T                = value_t<C>;
+        constexpr size_t lanes = seg_lanes<T>;
+        using vec_t            = netsort::simd_vec<T, lanes>;
+
+        T*     data   = std::addressof(container[0]);
+        size_t n_segs = size(seg_idxs);
+        size_t g      = 0;
+        for (; g + lanes <= n_segs; g += lanes) {
+            T* begs[lanes];  // hoisted, container stores may alias offsets
+            for (size_t l = 0; l < lanes; ++l)
+                begs[l] = data + offsets[seg_idxs[g + l]];
+
+            alignas(vec_t) T tr[NET_SIZE * lanes];
+            for (size_t i = 0; i < seg_sz; ++i)
+                for (size_t l = 0; l < lanes; ++l)
+                    tr[i * lanes + l] = begs[l][i];
+            vec_t vecs[NET_SIZE];
+            std::memcpy(vecs, tr, seg_sz * sizeof(vec_t));
+            auto vecs_span = make_span(vecs, seg_sz);
+            _net_dispatch(vecs_span, IdentityFtor{});
+            std::memcpy(tr, vecs, seg_sz * sizeof(vec_t));
+            for (size_t l = 0; l < lanes; ++l)
+                for (size_t i = 0; i < seg_sz; ++i)
+                    begs[l][i] = tr[i * lanes + l];
+        }
+        for (; g < n_segs; ++g) {
+            auto seg = make_span(std::begin(container) + offsets[seg_idxs[g]], seg_sz);
+            _net_dispatch(seg, IdentityFtor{});
+        }
+    }
+
+public:
+    /// @brief Sort independently each segment [offsets[s], offsets[s + 1]) of a flat container
+    /// (e.g., the rows of a CSR matrix). Offsets must be non-decreasing, with size(offsets) equal
+    /// to the number of segments plus one. Key detection and dispatch are resolved once per call;
+    /// small segments of arithmetic values are grouped by size and sorted seg_lanes at a time.
+    template <typename C, typename O, typename K = IdentityFtor>
+    void segmented_sort(C& container, O const& offsets, K&& key = {}) {
+        size_t n_offs = size(offsets);
+        if (n_offs < 2 || size(container) == 0)
+            return;
+
+        size_t n_segs   = n_offs - 1;
+        bool   identity = eq<no_cvr<K>, IdentityFtor>;
+        if constexpr (std::is_same_v<value_t<C>, key_t<C, K>>)
+            identity = !(key(container[0]) < container[0] || key(container[0]) > container[0]);
+
+        constexpr bool use_lanes = seg_lanes_v<value_t<C>, K>;
+        for (size_t w_beg = 0; w_beg < n_segs; w_beg += seg_window) {
+            size_t w_end = min(w_beg + seg_window, n_segs);
+
+            size_type small_counts[NET_SIZE + 2] = {};
+            for (size_t s = w_beg; s < w_end; ++s) {
+                size_t beg = offsets[s];
+                size_t end = offsets[s + 1];
+                assert(beg <= end && end <= size(container));
+                if (end < size(container))
+                    __builtin_prefetch(std::addressof(container[end]));
+
+                size_t ssize = end - beg;
+                if (ssize < 2)
+                    continue;
+                if (use_lanes && ssize <= NET_SIZE)
+                    ++small_counts[ssize + 1];
+                else
+                    _sort_segment(make_span(std::begin(container) + beg, ssize), key, identity);
+            }
+
+            if constexpr (use_lanes) {
+                // Counting sort of the window small segments by size, then one group per size
+                for (size_t i = 1; i < NET_SIZE + 2; ++i)
+                    small_counts[i] += small_counts[i - 1];
+
+                size_type seg_idxs[seg_window];
+                for (size_t s = w_beg; s < w_end; ++s) {
+                    size_t ssize = offsets[s + 1] - offsets[s];
+                    if (2 <= ssize && ssize <= NET_SIZE)
+                        seg_idxs[small_counts[ssize]++] = static_cast<size_type>(s);
+                }
+
+                size_t first = 0;
+                for (size_t sz = 2; sz <= NET_SIZE; ++sz) {
+                    size_t last = small_counts[sz];
+                    if (first < last)
+                        _lanes_sort_segments(
+                            container, offsets, make_span(seg_idxs + first, last - first), sz);
+                    first = last;
+                }
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////// CALIBRATION //////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////
+private:
+    /// @brief Sizes probed by calibrate() and number of elements sorted for each measurement
+    static constexpr size_t calib_sizes[] = {
+        8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512};
+    static constexpr size_t calib_elems   = 1U << 14U;
+
+    /// @brief Nanoseconds to run kernel on all the consecutive chunks of n elements of pool
+    template <typename T, typename F>
+    double _time_kernel(std::vector<T> const& pool, std::vector<T>& work, size_t n, F&& kernel) {
+        double best = 1e300;
+        for (size_t t = 0; t < 3; ++t) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t off = 0; off + n <= size(pool); off += n) {
+                std::copy_n(std::begin(pool) + off, n, std::begin(work));
+                auto chunk = make_span(std::begin(work), n);
+                kernel(chunk);
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            best         = min(best, static_cast<double>(elapsed.count()));
+        }
+        return best;
+    }
+
+    /// @brief First probed size from which big_kernel beats small_kernel (on two sizes in a row,
+    /// to filter out noise)
+    template <typename T, typename F1, typename F2>
+    size_t _crossover(std::vector<T> const& pool,
+                      std::vector<T>&       work,
+                      F1&&                  small_kernel,
+                      F2&&                  big_kernel) {
+        constexpr size_t n_sizes = std::size(calib_sizes);
+
+        bool prev_won = false;
+        for (size_t i = 0; i < n_sizes; ++i) {
+            size_t n   = calib_sizes[i];
+            bool   won = _time_kernel(pool, work, n, big_kernel) <
+                       _time_kernel(pool, work, n, small_kernel);
+            if (won && prev_won)
+                return calib_sizes[i - 1];
+            prev_won = won;
+        }
+        return calib_sizes[n_sizes - 1];
+    }
+
+    template <typename T>
+    void _calibrate_key() {
+        constexpr size_t idx = SortThresholds::key_idx(sizeof(T));
+
+        std::vector<T> pool(calib_elems), work(calib_sizes[std::size(calib_sizes) - 1]);
+        uint64_t       state = 0x9E3779B97F4A7C15ULL;
+        for (auto& k : pool) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            k     = static_cast<T>(state ^ (state >> 29U));
+        }
+
+        auto other_key = [](T k) { return k; };  // not an IdentityFtor
+        thresholds.net_sort[idx] = _crossover(
+            pool, work, [&](auto& c) { net_sort(c); }, [&](auto& c) { radix_sort(c); });
+        thresholds.insertion[idx] = _crossover(
+            pool,
+            work,
+            [&](auto& c) { insertion_sort(c, other_key); },
+            [&](auto& c) { radix_sort(c, other_key); });
+        if constexpr (sizeof(T) == 4)
+            thresholds.nth_sort = _crossover(
+                pool,
+                work,
+                [&](auto& c) { sort(c); },
+                [&](auto& c) { dutch_nth_elem(c, size(c) / 2); });
+    }
+
+public:
+    /// @brief Time the kernels once on random keys of 1, 2, 4 and 8 bytes and store the measured
+    /// crossovers in thresholds (takes ~0.1-0.2 seconds, meaningful with NDEBUG only).
+    /// The returned table can be copied to other Sorters.
+    SortThresholds const& calibrate() {
+        _calibrate_key<uint8_t>();
+        _calibrate_key<uint16_t>();
+        _calibrate_key<uint32_t>();
+        _calibrate_key<uint64_t>();
+        return thresholds;
+    }
 };
 
 template <typename SzT = uint32_t, typename AlcT = std::allocator<char>>
@@ -641,6 +1401,52 @@ inline Sorter<SzT, AlcT> make_sorter() {
     return Sorter<SzT, AlcT>{};
 }
 
+/// @brief Sorter taking its working buffer from a std::pmr::memory_resource
+template <typename SzT = uint32_t>
+using PmrSorter = Sorter<SzT, std::pmr::polymorphic_allocator<char>>;
+
+#ifdef CAV_COMP_TESTS
+// Sorter works on a raw byte buffer and cannot be constant evaluated: these checks run once at
+// startup (debug builds only, as every CAV_COMP_TESTS block).
+namespace {
+    [[maybe_unused]] inline bool const sorter_select_tests = [] {
+        auto lcg = [x = 12345U]() mutable { return (x = x * 1664525U + 1013904223U) >> 8U; };
+        auto dup = std::vector<uint32_t>(300);  // few distinct keys: long runs of duplicates
+        for (uint32_t& v : dup)
+            v = lcg() % 17U;
+        auto wide = std::vector<uint32_t>(300);
+        for (uint32_t& v : wide)
+            v = lcg();
+
+        auto sorter = Sorter<>();
+        for (auto const& input : {dup, wide}) {
+            auto sorted = input;
+            std::sort(sorted.begin(), sorted.end());
+            for (size_t nth : {size_t{0}, input.size() / 3, input.size() - 1}) {
+                auto v1 = input;
+                sorter.dutch_nth_elem(v1, nth);
+                assert(v1[nth] == sorted[nth]);
+                auto mid = v1.begin() + static_cast<ptrdiff_t>(nth);
+                assert(std::all_of(v1.begin(), mid, [&](auto x) { return x <= *mid; }));
+                assert(std::all_of(mid, v1.end(), [&](auto x) { return x >= *mid; }));
+
+                auto v2 = input;
+                sorter.radix_nth_elem(v2, nth);
+                assert(v2[nth] == sorted[nth]);
+            }
+
+            // k = 0, heap path (k * top_k_heap_ratio <= size), radix select path, k >= size
+            for (size_t k : {size_t{0}, size_t{2}, size_t{150}, input.size()}) {
+                auto v   = input;
+                auto top = sorter.partial_sort(v, k);
+                assert(top.size() == k && std::equal(top.begin(), top.end(), sorted.begin()));
+            }
+        }
+        return true;
+    }();
+}  // namespace
+#endif
+
 }  // namespace cav
 
 #endif /* CAV_INCLUDE_RADIX_STUFF_HPP */
@@ -21,7 +21,7 @@
 /// Notice that including all networks increase substantially the size of the binary,
 /// so consider what kind of small-sorting you **really** need.
 ///
-/// Some tests on a AMD Ryzen 9 5950X.
+/// Some tests on a AMD Ryzen 9 5950X (rerun the sweep on your hardware with the cav_bench target).
 ///
 /// Full 32 cases tried with vector of increasing size.
 /// The numbers are milliseconds (to keep the duration similar, bigger the vectors, lesser they are
@@ -103,6 +103,10 @@
 ///    3: Std::sort: 4925, jump sort: 529, switch sort: 885
 ///    4: Std::sort: 5446, jump sort: 507, switch sort: 722
 ///    5: Std::sort: 5960, jump sort: 496, switch sort: 668
+///
+/// Arithmetic values sorted by IdentityFtor use a branchless min/max compare-exchange. With a
+/// simd_vec value type every lane is an independent network: sorting a std::array<simd_vec<int,8>,
+/// 16> sorts 8 sequences of 16 ints with the same compare-exchange sequence as a single one.
 
 #ifndef CAV_INCLUDE_UTILS_SORTING_NETWORKS_HPP
 #define CAV_INCLUDE_UTILS_SORTING_NETWORKS_HPP
@@ -111,13 +115,48 @@
 #include <type_traits>
 #include <utility>
 
+#include "../comptime/macros.hpp"
 #include "../comptime/mp_utils.hpp"
+#include "../mish/util_functions.hpp"
 
 namespace cav::netsort {
 
+/// @brief Compiler vector type (gcc/clang extension) with Lanes values of type T. The compiler maps
+/// it to the widest SIMD registers available for the target (SSE/AVX2/AVX-512/NEON). Used as value
+/// type, each network sorts Lanes independent sequences at once, one per lane.
+template <typename T, size_t Lanes>
+struct simd_vec_impl {
+    typedef T type __attribute__((vector_size(sizeof(T) * Lanes)));
+};
+
+template <typename T, size_t Lanes>
+using simd_vec = typename simd_vec_impl<T, Lanes>::type;
+
+template <typename V>
+concept simd_vec_type = requires(V v) {
+    requires std::is_arithmetic_v<no_cvr<decltype(v[0])>>;
+    requires eq<V, simd_vec<no_cvr<decltype(v[0])>, sizeof(V) / sizeof(v[0])>>;
+};
+
+/// @brief Values whose compare-exchange can be a branchless min/max pair: arithmetic values sorted
+/// by themselves and compiler vector types (where min/max are computed lane-wise).
+template <typename C, typename Key>
+concept minmax_sortable = (std::is_arithmetic_v<container_value_type_t<C>> ||
+                           simd_vec_type<container_value_type_t<C>>) &&
+                          eq<no_cvr<Key>, IdentityFtor>;
+
+template <typename C, typename Key>
+requires minmax_sortable<C, Key>
+CAV_INLINE inline void cmp_swap(C& c, Key&& /*key*/, size_t i1, size_t i2) {
+    auto v1 = c[i1];
+    auto v2 = c[i2];
+    c[i1]   = v2 < v1 ? v2 : v1;
+    c[i2]   = v2 < v1 ? v1 : v2;
+}
+
 template <typename C, typename Key>
-requires(std::is_fundamental_v<container_value_type_t<C>> ||
-         !std::is_trivially_copyable_v<container_value_type_t<C>>)
+requires(!minmax_sortable<C, Key> && (std::is_fundamental_v<container_value_type_t<C>> ||
+                                      !std::is_trivially_copyable_v<container_value_type_t<C>>))
 void cmp_swap(C& c, Key&& key, size_t i1, size_t i2) {
     auto k1  = key(c[i1]);
     auto k2  = key(c[i2]);
@@ -127,7 +166,7 @@ void cmp_swap(C& c, Key&& key, size_t i1, size_t i2) {
 }
 
 template <typename C, typename Key>
-requires(!std::is_fundamental_v<container_value_type_t<C>> &&
+requires(!minmax_sortable<C, Key> && !std::is_fundamental_v<container_value_type_t<C>> &&
          std::is_trivially_copyable_v<container_value_type_t<C>>)
 void cmp_swap(C& c, Key&& key, size_t i1, size_t i2) {
     if (key(c[i1]) > key(c[i2])) {
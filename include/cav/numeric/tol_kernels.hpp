@@ -0,0 +1,263 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_NUMERIC_TOL_KERNELS_HPP
+#define CAV_INCLUDE_NUMERIC_TOL_KERNELS_HPP
+
+/// Bulk TolFloat selections over contiguous ranges (std::span, OwnSpan, SoA columns, ...). A
+/// tolerant "best" element is not well defined by a scan that keeps the first strictly better
+/// one (the tolerance is not transitive, so the result depends on the order). These kernels
+/// first reduce the exact extreme value a SIMD register at a time (compiler vector types, packed
+/// min/max), then select against it with the same expressions as the TolFloat operators, testing
+/// a whole vector of values before branching. NaN values are never selected.
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+#include "../comptime/macros.hpp"
+#include "../comptime/test.hpp"
+#include "TolFloat.hpp"
+#include "sorting_networks.hpp"
+
+namespace cav {
+
+namespace detail {
+    template <typename T>
+    struct is_tol_float : std::false_type {};
+
+    template <int E, int64_t B, std::floating_point BT>
+    struct is_tol_float<TolFloat<E, B, BT>> : std::true_type {};
+
+    /// @brief Width of the widest enabled SIMD registers: wider vector types are split by gcc into
+    /// scalar operations
+#if defined(__AVX512F__)
+    inline constexpr size_t tol_vec_bytes = 64;
+#elif defined(__AVX__)
+    inline constexpr size_t tol_vec_bytes = 32;
+#else
+    inline constexpr size_t tol_vec_bytes = 16;
+#endif
+
+    /// @brief Values processed per step
+    template <typename BT>
+    inline constexpr size_t tol_lanes = tol_vec_bytes / sizeof(BT);
+
+    template <typename BT>
+    using tol_vec = netsort::simd_vec<BT, tol_lanes<BT>>;
+
+    /// @brief Load tol_lanes values (the caller checks the bounds). Vectors are passed by reference
+    /// here and in the predicates: by value they have a target-dependent ABI (-Wpsabi).
+    template <typename TF, typename VecT>
+    CAV_INLINE inline void tol_load(TF const* ptr, VecT& vec) noexcept {
+        static_assert(sizeof(TF) == sizeof(ptr->value), "TolFloat must be layout-compatible");
+        std::memcpy(&vec, ptr, sizeof(vec));
+    }
+
+    template <typename MaskT>
+    [[nodiscard]] CAV_INLINE inline bool tol_any(MaskT const& mask) noexcept {
+        bool any = false;
+        for (size_t l = 0; l < sizeof(MaskT) / sizeof(mask[0]); ++l)
+            any |= mask[l] != 0;
+        return any;
+    }
+
+    /// @brief Exact min (or max) of the values, +inf (-inf) when empty or all NaN
+    template <bool Max, typename TF>
+    [[nodiscard]] constexpr auto tol_extreme(TF const* ptr, size_t n) noexcept {
+        using base_t      = decltype(ptr->value);
+        constexpr auto lm = Max ? -std::numeric_limits<base_t>::infinity()
+                                : std::numeric_limits<base_t>::infinity();
+
+        base_t res = lm;
+        size_t i   = 0;
+        if (!std::is_constant_evaluated()) {
+            auto acc = tol_vec<base_t>{} + lm;
+            auto vec = tol_vec<base_t>{};
+            for (; n - i >= tol_lanes<base_t>; i += tol_lanes<base_t>) {
+                tol_load(ptr + i, vec);
+                if constexpr (Max)
+                    acc = acc < vec ? vec : acc;
+                else
+                    acc = vec < acc ? vec : acc;
+            }
+            for (size_t l = 0; l < tol_lanes<base_t>; ++l)
+                res = (Max ? res < acc[l] : acc[l] < res) ? acc[l] : res;
+        }
+        for (TF const* it = ptr + i; it != ptr + n; ++it)
+            res = (Max ? res < it->value : it->value < res) ? it->value : res;
+        return res;
+    }
+
+    /// @brief Index of the first element whose value satisfies pred, n if none. The predicate
+    /// pred(v, sel) sets sel for a single value and a lane mask for a tol_vec of values.
+    template <typename TF, typename PredT>
+    [[nodiscard]] constexpr size_t tol_find_first(TF const* ptr, size_t n, PredT pred) noexcept {
+        using base_t = decltype(ptr->value);
+        size_t i     = 0;
+        if (!std::is_constant_evaluated()) {
+            auto vec  = tol_vec<base_t>{};
+            auto mask = decltype(vec < vec){};
+            for (; n - i >= tol_lanes<base_t>; i += tol_lanes<base_t>) {
+                tol_load(ptr + i, vec);
+                pred(vec, mask);
+                if (tol_any(mask))
+                    break;
+            }
+        }
+        for (bool sel = false; i < n; ++i) {
+            pred(ptr[i].value, sel);
+            if (sel)
+                return i;
+        }
+        return n;
+    }
+
+    /// @brief Branchless compaction of the indices whose value satisfies pred (as above), steps
+    /// without any match are skipped after a single vector test
+    template <typename TF, typename IdxT, typename PredT>
+    constexpr size_t tol_filter(TF const* ptr, size_t n, IdxT* dst, PredT pred) noexcept {
+        using base_t = decltype(ptr->value);
+        size_t k     = 0;
+        size_t i     = 0;
+        auto   keep  = [&](size_t end) {
+            for (bool sel = false; i < end; ++i) {
+                pred(ptr[i].value, sel);
+                dst[k] = static_cast<IdxT>(i);  // always written, kept only if selected
+                k += static_cast<size_t>(sel);
+            }
+        };
+        if (!std::is_constant_evaluated()) {
+            auto vec  = tol_vec<base_t>{};
+            auto mask = decltype(vec < vec){};
+            while (n - i >= tol_lanes<base_t>) {
+                tol_load(ptr + i, vec);
+                pred(vec, mask);
+                if (tol_any(mask))
+                    keep(i + tol_lanes<base_t>);
+                else
+                    i += tol_lanes<base_t>;
+            }
+        }
+        keep(n);
+        return k;
+    }
+}  // namespace detail
+
+template <typename R>
+concept tol_float_range = std::ranges::contiguous_range<R> && std::ranges::sized_range<R> &&
+                          detail::is_tol_float<std::ranges::range_value_t<R>>::value;
+
+template <tol_float_range R>
+using tol_elem_t = std::ranges::range_value_t<R>;
+
+/// @brief Exact minimum (+inf if empty)
+template <tol_float_range R>
+[[nodiscard]] constexpr tol_elem_t<R> tol_min(R const& r) noexcept {
+    return {detail::tol_extreme<false>(std::ranges::data(r), std::ranges::size(r))};
+}
+
+/// @brief Exact maximum (-inf if empty)
+template <tol_float_range R>
+[[nodiscard]] constexpr tol_elem_t<R> tol_max(R const& r) noexcept {
+    return {detail::tol_extreme<true>(std::ranges::data(r), std::ranges::size(r))};
+}
+
+/// @brief Smallest index i such that no element is (tolerantly) less than r[i], that is r[i] <=
+/// tol_min(r): the minimum within tolerance, ties broken by index. Returns size(r) if empty.
+template <tol_float_range R>
+[[nodiscard]] constexpr size_t tol_argmin(R const& r) noexcept {
+    auto const* ptr = std::ranges::data(r);
+    size_t      n   = std::ranges::size(r);
+    auto        thr = detail::tol_extreme<false>(ptr, n) + tol_elem_t<R>::tol;
+    return detail::tol_find_first(ptr, n, [thr](auto const& v, auto& sel) {
+        sel = v < thr;  // as operator<=
+    });
+}
+
+/// @brief Smallest index i such that no element is (tolerantly) greater than r[i], that is r[i]
+/// >= tol_max(r): the maximum within tolerance, ties broken by index. Returns size(r) if empty.
+template <tol_float_range R>
+[[nodiscard]] constexpr size_t tol_argmax(R const& r) noexcept {
+    auto const* ptr = std::ranges::data(r);
+    size_t      n   = std::ranges::size(r);
+    auto        thr = detail::tol_extreme<true>(ptr, n) - tol_elem_t<R>::tol;
+    return detail::tol_find_first(ptr, n, [thr](auto const& v, auto& sel) {
+        sel = v > thr;  // as operator>=
+    });
+}
+
+/// @brief Write in out, in increasing order, the indices i such that r[i] == x (within the
+/// tolerance), out must be at least as long as r. With x = tol_min(r) (or tol_max(r)) these are
+/// all the tolerant minima (maxima).
+/// @return The number of indices written
+template <tol_float_range R, std::ranges::contiguous_range IdxR>
+requires std::integral<std::ranges::range_value_t<IdxR>>
+constexpr size_t tol_filter_equal(R const& r, tol_elem_t<R> x, IdxR&& out) noexcept {
+    assert(std::ranges::size(out) >= std::ranges::size(r));
+    return detail::tol_filter(std::ranges::data(r),
+                              std::ranges::size(r),
+                              std::ranges::data(out),
+                              [xv = x.value, tol = x.tol](auto const& v, auto& sel) {
+                                  auto diff = v - xv;
+                                  sel       = (diff < tol) & (-diff < tol);  // as operator==
+                              });
+}
+
+/// @brief Sorter key of TolFloat elements: the value rounded down to a multiple of the
+/// tolerance. Since the rounding is monotone, the stable radix sort of Sorter orders tolerantly
+/// smaller elements first and keeps the original (index) order inside each tolerance-wide bucket,
+/// whose elements are all equal within the tolerance. Desc sorts from the largest bucket.
+template <bool Desc = false>
+struct TolKeyFtor {
+    template <int E, int64_t B, std::floating_point BT>
+    [[nodiscard]] constexpr BT operator()(TolFloat<E, B, BT> t) const noexcept {
+        constexpr BT scale = BT{1} / TolFloat<E, B, BT>::tol;
+        BT           key   = std::floor(t.value * scale);
+        return Desc ? -key : key;
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    CAV_BLOCK_PASS({
+        using tf = TolFloat<2, 10, double>;
+        tf vals[100];
+        for (int i = 0; i < 100; ++i)
+            vals[i] = tf{(i % 7) * 1.0};
+        vals[70] = tf{-2.0};
+        vals[80] = tf{-2.009};
+        vals[90] = tf{-2.005};
+        vals[95] = tf{-1.99};
+        vals[97] = tf{6.009};
+        assert(tol_argmin(vals) == 70 && tol_min(vals).value == -2.009);
+        assert(tol_argmax(vals) == 6 && tol_max(vals).value == 6.009);
+
+        size_t idx[100] = {};
+        assert(tol_filter_equal(vals, tol_min(vals), idx) == 3);
+        assert(idx[0] == 70 && idx[1] == 80 && idx[2] == 90);
+        assert(tol_argmin(std::span<tf>()) == 0);
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_NUMERIC_TOL_KERNELS_HPP */
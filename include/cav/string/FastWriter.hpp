@@ -0,0 +1,324 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_STRING_FASTWRITER_HPP
+#define CAV_INCLUDE_STRING_FASTWRITER_HPP
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../comptime/macros.hpp"
+#include "../comptime/test.hpp"
+#include "../mish/util_functions.hpp"
+#include "../numeric/ScaledInt.hpp"
+#include "../numeric/TolFloat.hpp"
+#include "StaticStr.hpp"
+
+/// Buffered writer of text lines with a compile-time layout: "{}" marks a field, everything else
+/// is copied verbatim. The layout is split at compile time into literal pieces, so writing a line
+/// is a single capacity check followed by fixed-size copies and field conversions, with no format
+/// parsing or locale. Integers and base-10 ScaledInts are converted 8 digits at a time with SWAR
+/// arithmetic (each conversion may scribble up to 8 bytes past the written field, the capacity
+/// check accounts for it). Assumes a little-endian target, like charconv.hpp.
+
+namespace cav {
+
+namespace detail {
+    inline constexpr uint64_t ascii_zeros = 0x3030303030303030ULL;
+
+    /// @brief The 8 decimal digits (zero padded) of v < 10^8 as byte values, most significant
+    /// first in memory order
+    [[nodiscard]] CAV_INLINE inline uint64_t swar_digits8(uint64_t v) noexcept {
+        uint64_t pairs4 = (v / 10000) | ((v % 10000) << 32);                 // 2 x 4 digits
+        uint64_t hi2    = ((pairs4 * 10486) >> 20) & 0x0000007F0000007FULL;  // x / 100
+        uint64_t pairs2 = hi2 | ((pairs4 - 100 * hi2) << 16);                // 4 x 2 digits
+        uint64_t hi1    = ((pairs2 * 103) >> 10) & 0x000F000F000F000FULL;    // x / 10
+        return hi1 | ((pairs2 - 10 * hi1) << 8);                             // 8 x 1 digit
+    }
+
+    /// @brief Exactly n <= 8 digits of v (zero padded), v < 10^n
+    CAV_INLINE inline char* write_digits8(char* out, uint64_t v, int n) noexcept {
+        uint64_t ascii = (swar_digits8(v) + ascii_zeros) >> (8 * (8 - n));
+        std::memcpy(out, &ascii, sizeof(ascii));
+        return out + n;
+    }
+
+    /// @brief Exactly n <= 19 digits of v (zero padded), v < 10^n
+    CAV_INLINE inline char* write_fixed_digits(char* out, uint64_t v, int n) noexcept {
+        if (n > 16) {
+            out = write_digits8(out, v / 10'000'000'000'000'000ULL, n - 16);
+            v %= 10'000'000'000'000'000ULL;
+            n = 16;
+        }
+        if (n > 8) {
+            out = write_digits8(out, v / 100'000'000, n - 8);
+            v %= 100'000'000;
+            n = 8;
+        }
+        return write_digits8(out, v, n);
+    }
+
+    /// @brief Shortest decimal representation of v < 10^8 (the leading zero digits are counted,
+    /// not branched on)
+    CAV_INLINE inline char* write_upto8(char* out, uint64_t v) noexcept {
+        uint64_t digits = swar_digits8(v);
+        int      lead   = min(std::countr_zero(digits) / 8, 7);
+        uint64_t ascii  = (digits + ascii_zeros) >> (8 * lead);
+        std::memcpy(out, &ascii, sizeof(ascii));
+        return out + (8 - lead);
+    }
+
+    CAV_INLINE inline char* write_uint(char* out, uint64_t v) noexcept {
+        if (v < 100'000'000)
+            return write_upto8(out, v);
+        if (v < 10'000'000'000'000'000ULL) {
+            out = write_upto8(out, v / 100'000'000);
+            return write_digits8(out, v % 100'000'000, 8);
+        }
+        out = write_upto8(out, v / 10'000'000'000'000'000ULL);
+        return write_fixed_digits(out, v % 10'000'000'000'000'000ULL, 16);
+    }
+
+    /// @brief Sign written unconditionally and kept only for negative values
+    template <std::integral T>
+    CAV_INLINE inline char* write_int(char* out, T v) noexcept {
+        auto magn = static_cast<uint64_t>(v);
+        if constexpr (std::signed_integral<T>) {
+            *out = '-';
+            out += v < 0;
+            magn = v < 0 ? 0 - magn : magn;
+        }
+        return write_uint(out, magn);
+    }
+
+    template <typename T>
+    struct field_traits {
+        static_assert(!eq<T, T>, "Unsupported FastWriter field type");
+    };
+
+    template <>
+    struct field_traits<char> {
+        static constexpr size_t max_chars = 1;
+
+        CAV_INLINE static char* write(char* out, char c) noexcept {
+            *out = c;
+            return out + 1;
+        }
+    };
+
+    template <std::integral T>
+    struct field_traits<T> {
+        static constexpr size_t max_chars = 20 + std::signed_integral<T>;
+
+        CAV_INLINE static char* write(char* out, T v) noexcept {
+            return write_int(out, v);
+        }
+    };
+
+    template <std::floating_point T>
+    struct field_traits<T> {
+        static constexpr size_t max_chars = 32;  // shortest round-trip representation
+
+        static char* write(char* out, T v) noexcept {
+            return std::to_chars(out, out + max_chars, v).ptr;
+        }
+    };
+
+    template <int E, int64_t B, std::floating_point BT>
+    struct field_traits<TolFloat<E, B, BT>> : field_traits<BT> {
+        static char* write(char* out, TolFloat<E, B, BT> v) noexcept {
+            return field_traits<BT>::write(out, v.value);
+        }
+    };
+
+    /// @brief Same output as the charconv.hpp to_chars: exactly max(E, 0) decimals
+    template <int8_t E, int64_t B, std::integral BT, rounding_tag RT>
+    struct field_traits<ScaledInt<E, B, BT, RT>> {
+        static constexpr size_t max_chars = B != 10 ? 32 : 21 + (E > 0 ? 1 + E : -E);
+
+        static char* write(char* out, ScaledInt<E, B, BT, RT> v) noexcept {
+            if constexpr (B != 10)
+                return field_traits<double>::write(out, static_cast<double>(v));
+            else {
+                auto     raw  = v.get_base();
+                uint64_t magn = raw < 0 ? 0 - static_cast<uint64_t>(raw)
+                                        : static_cast<uint64_t>(raw);
+                *out = '-';
+                out += raw < 0;
+                if constexpr (E <= 0) {
+                    out = write_uint(out, magn);
+                    if (magn != 0) {
+                        std::memset(out, '0', static_cast<size_t>(-E));
+                        out += -E;
+                    }
+                    return out;
+                } else {
+                    constexpr auto divisor = static_cast<uint64_t>(Pow<E>::val);
+                    out                    = write_uint(out, magn / divisor);
+                    *out++                 = '.';
+                    return write_fixed_digits(out, magn % divisor, E);
+                }
+            }
+        }
+    };
+
+    template <typename T>
+    requires std::convertible_to<T const&, std::string_view>
+    struct field_traits<T> {
+        static constexpr size_t max_chars = 0;  // runtime size, see field_size
+
+        static char* write(char* out, std::string_view str) noexcept {
+            std::memcpy(out, str.data(), str.size());
+            return out + str.size();
+        }
+    };
+
+    template <typename T>
+    [[nodiscard]] CAV_INLINE inline size_t field_size(T const& field) noexcept {
+        if constexpr (std::convertible_to<T const&, std::string_view>)
+            return std::string_view(field).size();
+        else
+            return field_traits<T>::max_chars;
+    }
+
+    /// @brief A FastWriter line layout split at its "{}" fields (scanned char by char, GCC 12
+    /// does not evaluate string_view::find on template parameter objects)
+    template <StaticStr Layout>
+    struct line_layout {
+        static constexpr size_t length = Layout.size() - 1;  // without '\0'
+
+        static constexpr bool is_field(size_t i) {
+            return i + 1 < length && Layout[i] == '{' && Layout[i + 1] == '}';
+        }
+
+        static constexpr size_t n_fields = [] {
+            size_t count = 0;
+            for (size_t i = 0; i < length; ++i)
+                count += is_field(i) ? (++i, 1) : 0;
+            return count;
+        }();
+
+        static constexpr auto pieces = [] {
+            auto   res = std::array<std::string_view, n_fields + 1>{};
+            size_t f   = 0;
+            size_t beg = 0;
+            for (size_t i = 0; i < length; ++i)
+                if (is_field(i)) {
+                    res[f++] = std::string_view(Layout.data() + beg, i - beg);
+                    beg      = ++i + 1;
+                }
+            res[n_fields] = std::string_view(Layout.data() + beg, length - beg);
+            return res;
+        }();
+
+        static constexpr size_t literal_size = length - 2 * n_fields;
+    };
+}  // namespace detail
+
+/// @brief Large-buffer writer of lines with a compile-time layout, flushed in big fwrite calls:
+///
+///     auto out = FastWriter(file);
+///     for (auto const& sol : solutions)
+///         out.write<"{} {} {}\n">(sol.id, sol.cost, sol.name);
+///
+/// Fields can be integers, chars, floating points (std::to_chars), ScaledInt, TolFloat and
+/// anything convertible to std::string_view. Nothing is written to the file until the buffer is
+/// full, flush() is called or the writer is destroyed.
+class FastWriter {
+    static constexpr size_t swar_slack = 8;
+
+public:
+    explicit FastWriter(std::FILE* out_file, size_t buffer_size = size_t{1} << 20)
+        : file(out_file)
+        , buffer(max(buffer_size, size_t{256}))
+        , pos(buffer.data()) {
+    }
+
+    FastWriter(FastWriter const&)            = delete;
+    FastWriter& operator=(FastWriter const&) = delete;
+
+    ~FastWriter() {
+        flush();
+    }
+
+    template <StaticStr Layout, typename... Ts>
+    void write(Ts const&... fields) {
+        using layout = detail::line_layout<Layout>;
+        static_assert(layout::n_fields == sizeof...(Ts), "Layout and fields count mismatch");
+
+        _reserve(layout::literal_size + (detail::field_size(fields) + ... + 0) + swar_slack);
+        char* out = _put(pos, layout::pieces[0]);
+        [&]<size_t... Is>(std::index_sequence<Is...> /*s*/) {
+            ((out = detail::field_traits<Ts>::write(out, fields),
+              out = _put(out, layout::pieces[Is + 1])),
+             ...);
+        }(std::index_sequence_for<Ts...>{});
+        pos = out;
+    }
+
+    /// @brief Write the buffered bytes to the file
+    void flush() {
+        auto size = static_cast<size_t>(pos - buffer.data());
+        if (size != 0 && file != nullptr)
+            std::fwrite(buffer.data(), 1, size, file);
+        pos = buffer.data();
+    }
+
+    [[nodiscard]] std::string_view buffered() const noexcept {
+        return {buffer.data(), static_cast<size_t>(pos - buffer.data())};
+    }
+
+private:
+    std::FILE*        file;
+    std::vector<char> buffer;
+    char*             pos;
+
+    CAV_INLINE void _reserve(size_t n_bytes) {
+        if (static_cast<size_t>(buffer.data() + buffer.size() - pos) >= n_bytes) [[likely]]
+            return;
+        flush();
+        if (buffer.size() < n_bytes) {
+            buffer.resize(n_bytes);
+            pos = buffer.data();
+        }
+    }
+
+    CAV_INLINE static char* _put(char* out, std::string_view piece) noexcept {
+        std::memcpy(out, piece.data(), piece.size());
+        return out + piece.size();
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    using fw_layout_t = detail::line_layout<"id {}: {}\n">;
+    CAV_PASS(fw_layout_t::n_fields == 2 && fw_layout_t::literal_size == 6);
+    CAV_PASS(fw_layout_t::pieces[0] == "id " && fw_layout_t::pieces[1] == ": ");
+    CAV_PASS(fw_layout_t::pieces[2] == "\n");
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_STRING_FASTWRITER_HPP */
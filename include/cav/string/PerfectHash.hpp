@@ -0,0 +1,164 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_STRING_PERFECTHASH_HPP
+#define CAV_INCLUDE_STRING_PERFECTHASH_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "../comptime/test.hpp"
+#include "../mish/util_functions.hpp"
+
+namespace cav {
+
+namespace detail {
+    [[nodiscard]] constexpr uint64_t fnv1a(std::string_view str) noexcept {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for (char c : str)
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+        return hash;
+    }
+
+    /// @brief Seeded finalizer of a string hash (murmur3 fmix64)
+    [[nodiscard]] constexpr uint64_t hash_mix(uint64_t hash, uint32_t seed) noexcept {
+        hash ^= seed * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        return hash ^ (hash >> 33);
+    }
+
+    // Not constexpr: reaching it makes the PerfectStrHash construction ill-formed
+    inline void perfect_hash_duplicate_keys() {
+    }
+}  // namespace detail
+
+/// @brief Compile-time perfect hash of N strings (hash and displace): the key is hashed once,
+/// the hash picks a bucket, and the per-bucket seed picks a slot that no other key uses. A lookup
+/// is one string hash, two table reads and a single string compare, whatever N.
+///
+/// The keys are not copied: they must outlive the table (string literals, StaticStr template
+/// parameters and static members are fine).
+template <size_t N>
+class PerfectStrHash {
+    static constexpr int bucket_bits = static_cast<int>(std::bit_width(max(N / 2, size_t{1}))) - 1;
+    static constexpr size_t n_buckets = size_t{1} << bucket_bits;  // about N / 2
+    static constexpr size_t n_slots   = std::bit_ceil(max(2 * N, size_t{1}));
+
+public:
+    consteval explicit PerfectStrHash(std::array<std::string_view, N> const& key_list)
+        : keys(key_list) {
+        for (size_t i = 0; i < N; ++i)
+            for (size_t j = i + 1; j < N; ++j)
+                if (keys[i] == keys[j])
+                    detail::perfect_hash_duplicate_keys();
+
+        auto hashes  = std::array<uint64_t, N>{};
+        auto buckets = std::array<size_t, N>{};
+        auto sizes   = std::array<size_t, n_buckets>{};
+        for (size_t i = 0; i < N; ++i) {
+            hashes[i]  = detail::fnv1a(keys[i]);
+            buckets[i] = _bucket_of(hashes[i]);
+            ++sizes[buckets[i]];
+        }
+
+        // Larger buckets first, while most of the slots are still free
+        auto order = std::array<size_t, n_buckets>{};
+        for (size_t b = 0; b < n_buckets; ++b)
+            order[b] = b;
+        std::ranges::sort(order, [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+        slots.fill(-1);
+        for (size_t b : order) {
+            if (sizes[b] != 0)
+                seeds[b] = _place_bucket(b, hashes, buckets);
+        }
+    }
+
+    /// @brief Index in the key list of str, -1 if str is not a key
+    [[nodiscard]] constexpr int find(std::string_view str) const noexcept {
+        if constexpr (N == 0)
+            return -1;
+        else {
+            uint64_t hash = detail::fnv1a(str);
+            uint32_t seed = seeds[_bucket_of(hash)];
+            int      idx  = slots[detail::hash_mix(hash, seed) & (n_slots - 1)];
+            return idx >= 0 && keys[static_cast<size_t>(idx)] == str ? idx : -1;
+        }
+    }
+
+    [[nodiscard]] static constexpr size_t size() noexcept {
+        return N;
+    }
+
+private:
+    std::array<std::string_view, N> keys;
+    std::array<uint32_t, n_buckets> seeds = {};
+    std::array<int, n_slots>        slots = {};
+
+    [[nodiscard]] static constexpr size_t _bucket_of(uint64_t hash) noexcept {
+        if constexpr (bucket_bits == 0)
+            return 0;
+        else
+            return static_cast<size_t>(detail::hash_mix(hash, 0) >> (64 - bucket_bits));
+    }
+
+    /// @brief First seed sending all the keys of bucket b to distinct free slots (and take them)
+    consteval uint32_t _place_bucket(size_t                          b,
+                                     std::array<uint64_t, N> const& hashes,
+                                     std::array<size_t, N> const&   buckets) {
+        for (uint32_t seed = 1;; ++seed) {
+            auto   taken   = std::array<size_t, N>{};
+            size_t n_taken = 0;
+            bool   fits    = true;
+            for (size_t i = 0; i < N && fits; ++i) {
+                if (buckets[i] != b)
+                    continue;
+                size_t slot      = detail::hash_mix(hashes[i], seed) & (n_slots - 1);
+                auto   end       = taken.begin() + n_taken;
+                fits             = slots[slot] < 0 && std::find(taken.begin(), end, slot) == end;
+                taken[n_taken++] = slot;
+            }
+            if (!fits)
+                continue;
+            n_taken = 0;
+            for (size_t i = 0; i < N; ++i)
+                if (buckets[i] == b)
+                    slots[taken[n_taken++]] = static_cast<int>(i);
+            return seed;
+        }
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    constexpr auto ph_keys = std::array<std::string_view, 6>{"help", "h", "string", "s", "t", "x"};
+    constexpr auto ph_hash = PerfectStrHash(ph_keys);
+
+    CAV_PASS(ph_hash.find("help") == 0 && ph_hash.find("s") == 3 && ph_hash.find("x") == 5);
+    CAV_PASS(ph_hash.find("") == -1 && ph_hash.find("hel") == -1 && ph_hash.find("tt") == -1);
+    CAV_PASS(PerfectStrHash(std::array<std::string_view, 0>{}).find("a") == -1);
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_STRING_PERFECTHASH_HPP */
@@ -0,0 +1,373 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_UTILS_CHARCONV_HPP
+#define CAV_INCLUDE_UTILS_CHARCONV_HPP
+
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <type_traits>
+
+#include "../mish/util_functions.hpp"
+#include "../numeric/ScaledInt.hpp"
+#include "../numeric/TolFloat.hpp"
+
+/// from_chars/to_chars for ScaledInt and TolFloat, found by ADL (also by the unqualified calls of
+/// file_ingest.hpp). Base-10 ScaledInt values are parsed digit by digit straight into int_type
+/// (8 digits at a time with SWAR arithmetic), with no floating point round-trip: the digits past
+/// the kept precision are only used for rounding, according to the rounding tag.
+
+namespace cav {
+
+namespace detail {
+    inline constexpr uint64_t swar_ones = 0x0101010101010101ULL;
+
+    [[nodiscard]] inline uint64_t swar_load(char const* ptr) noexcept {
+        uint64_t chunk = 0;
+        std::memcpy(&chunk, ptr, sizeof(chunk));
+        return chunk;
+    }
+
+    /// @brief Number of leading ASCII digits in the 8 chars of chunk (little-endian)
+    [[nodiscard]] constexpr int swar_digit_count(uint64_t chunk) noexcept {
+        uint64_t non_digit = ((chunk + 0x46 * swar_ones) | (chunk - 0x30 * swar_ones)) &
+                             (0x80 * swar_ones);
+        return non_digit == 0 ? 8 : std::countr_zero(non_digit) / 8;
+    }
+
+    /// @brief Value of the first n <= 8 digits of chunk (little-endian)
+    [[nodiscard]] constexpr uint64_t swar_digits_value(uint64_t chunk, int n) noexcept {
+        if (n == 0)
+            return 0;
+        chunk -= 0x30 * swar_ones;
+        chunk <<= 8 * (8 - n);  // leading zero digits
+        chunk = chunk * 10 + (chunk >> 8U);
+        return (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32U))) +
+                (((chunk >> 16U) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32U)))) >>
+               32U;
+    }
+
+    /// @brief Digits run starting at first (SWAR at run time, digit by digit when constexpr)
+    [[nodiscard]] constexpr char const* skip_digits(char const* first, char const* last) noexcept {
+        if (std::endian::native == std::endian::little && !std::is_constant_evaluated())
+            while (last - first >= 8) {
+                int n = swar_digit_count(swar_load(first));
+                first += n;
+                if (n < 8)
+                    return first;
+            }
+        while (first != last && static_cast<unsigned>(*first - '0') < 10U)
+            ++first;
+        return first;
+    }
+
+    /// @brief acc * 10^(last - first) + value of the (all digit) range. Reading up to 8 chars
+    /// past it is fine as long as they are before buff_end.
+    [[nodiscard]] constexpr uint64_t accumulate_digits(uint64_t    acc,
+                                                       char const* first,
+                                                       char const* last,
+                                                       char const* buff_end) noexcept {
+        constexpr uint64_t pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000};
+        if (std::endian::native == std::endian::little && !std::is_constant_evaluated()) {
+            for (; last - first >= 8; first += 8)
+                acc = acc * 100000000ULL + swar_digits_value(swar_load(first), 8);
+            if (first != last && buff_end - first >= 8) {
+                auto n = static_cast<int>(last - first);
+                return acc * pow10[n] + swar_digits_value(swar_load(first), n);
+            }
+        }
+        for (; first != last; ++first)
+            acc = acc * 10 + static_cast<uint64_t>(*first - '0');
+        return acc;
+    }
+
+    /// @brief View of the digits of a decimal number as a single integer|fraction stream
+    struct decimal_digits {
+        char const* int_beg;
+        char const* int_end;
+        char const* frac_beg;
+        char const* frac_end;
+        char const* buff_end;
+
+        [[nodiscard]] constexpr size_t int_len() const noexcept {
+            return static_cast<size_t>(int_end - int_beg);
+        }
+
+        [[nodiscard]] constexpr size_t frac_len() const noexcept {
+            return static_cast<size_t>(frac_end - frac_beg);
+        }
+
+        [[nodiscard]] constexpr char const* at(size_t i) const noexcept {
+            return i < int_len() ? int_beg + i : frac_beg + (i - int_len());
+        }
+
+        /// @brief Value of the first k digits of the stream (zero padded) and rounding info on
+        /// the dropped ones: the first dropped digit and if any of the following is not zero
+        struct kept {
+            uint64_t value;
+            int      first_dropped;
+            bool     sticky;
+            bool     overflow;
+        };
+
+        [[nodiscard]] constexpr kept keep(size_t k) const noexcept {
+            size_t total = int_len() + frac_len();
+            auto   res   = kept{0, 0, false, false};
+
+            size_t first_nz = 0;  // at most 19 significant digits fit an uint64
+            while (first_nz < min(k, total) && *at(first_nz) == '0')
+                ++first_nz;
+            if (first_nz < min(k, total) && k - first_nz > 19) {
+                res.overflow = true;
+                return res;
+            }
+
+            size_t from_int = min(k, int_len());
+            res.value       = accumulate_digits(0, int_beg, int_beg + from_int, buff_end);
+            if (k > int_len()) {
+                size_t      from_frac = min(k - int_len(), frac_len());
+                char const* frac_last = frac_beg + from_frac;
+                res.value = accumulate_digits(res.value, frac_beg, frac_last, buff_end);
+                for (size_t i = from_frac; i < k - int_len(); ++i)
+                    res.value *= 10;
+            }
+
+            if (k < total) {
+                res.first_dropped = *at(k) - '0';
+                for (size_t i = k + 1; i < total && !res.sticky; ++i)
+                    res.sticky = *at(i) != '0';
+            }
+            return res;
+        }
+    };
+
+    template <rounding_tag TagT>
+    [[nodiscard]] constexpr uint64_t round_magnitude(uint64_t magn,
+                                                     int      first_dropped,
+                                                     bool     sticky,
+                                                     bool     negative) noexcept {
+        bool inexact = first_dropped != 0 || sticky;
+        if constexpr (std::same_as<TagT, round_tag>)
+            return magn + (first_dropped >= 5 ? 1U : 0U);  // half away from zero
+        else if constexpr (std::same_as<TagT, floor_tag>)
+            return magn + (negative && inexact ? 1U : 0U);
+        else if constexpr (std::same_as<TagT, ceil_tag>)
+            return magn + (!negative && inexact ? 1U : 0U);
+        else
+            return magn;
+    }
+}  // namespace detail
+
+/// @brief Parse a decimal number ([-]digits[.digits], also "1." and ".5") into a ScaledInt of base
+/// 10, rounding the digits past its precision with TagT. Numbers with an exponent and other bases
+/// go through double (those only at run time). Same error reporting as std::from_chars.
+template <int8_t E, int64_t B, std::integral BT, rounding_tag RT, rounding_tag TagT = RT>
+constexpr std::from_chars_result from_chars(char const*              first,
+                                  char const*              last,
+                                  ScaledInt<E, B, BT, RT>& value,
+                                  TagT&& /*unused*/ = {}) noexcept {
+    using scaled_t = ScaledInt<E, B, BT, RT>;
+
+    auto via_double = [&] {
+        double val = 0.0;
+        auto   res = std::from_chars(first, last, val);
+        if (res.ec == std::errc{})
+            value.from_val(val, TagT{});
+        return res;
+    };
+    if constexpr (B != 10)
+        return via_double();
+
+    char const* ptr      = first;
+    bool        negative = ptr != last && *ptr == '-';
+    ptr += negative ? 1 : 0;
+
+    auto digits     = detail::decimal_digits{};
+    digits.buff_end = last;
+    digits.int_beg  = ptr;
+    digits.int_end  = ptr = detail::skip_digits(ptr, last);
+    digits.frac_beg = digits.frac_end = ptr;
+    if (ptr != last && *ptr == '.') {
+        digits.frac_beg = ++ptr;
+        digits.frac_end = ptr = detail::skip_digits(ptr, last);
+    }
+    if (digits.int_len() + digits.frac_len() == 0)
+        return {first, std::errc::invalid_argument};
+    if (ptr != last && (*ptr == 'e' || *ptr == 'E'))
+        return via_double();
+
+    while (digits.int_beg != digits.int_end && *digits.int_beg == '0')
+        ++digits.int_beg;  // leading zeros do not count as precision
+
+    // Keep the digits up to the E-th decimal position (E > 0 are decimals, E < 0 tens)
+    auto k    = static_cast<ptrdiff_t>(digits.int_len()) + E;
+    auto kept = detail::decimal_digits::kept{0, 0, false, false};
+    if (k > 0)
+        kept = digits.keep(static_cast<size_t>(k));
+    else if (digits.int_len() + digits.frac_len() > 0) {  // all the digits are dropped
+        auto const* d0     = k == 0 ? digits.at(0) : nullptr;
+        kept.first_dropped = d0 != nullptr ? *d0 - '0' : 0;
+        for (size_t i = k == 0 ? 1 : 0; i < digits.int_len() + digits.frac_len(); ++i)
+            kept.sticky = kept.sticky || *digits.at(i) != '0';
+    }
+
+    using int_type = typename scaled_t::int_type;
+    auto max_magn  = static_cast<uint64_t>(type_max<int_type>) + (negative ? 1U : 0U);
+    if (kept.overflow || kept.value > max_magn)
+        return {ptr, std::errc::result_out_of_range};
+    uint64_t magn = detail::round_magnitude<TagT>(kept.value,
+                                                  kept.first_dropped,
+                                                  kept.sticky,
+                                                  negative);
+    if (magn > max_magn)
+        return {ptr, std::errc::result_out_of_range};
+
+    auto raw    = negative ? static_cast<int_type>(0 - magn) : static_cast<int_type>(magn);
+    value.value = raw;
+    return {ptr, std::errc{}};
+}
+
+/// @brief Write a base-10 ScaledInt with exactly max(E, 0) decimals (other bases go through
+/// double). Same error reporting as std::to_chars.
+template <int8_t E, int64_t B, std::integral BT, rounding_tag RT>
+std::to_chars_result to_chars(char* first, char* last, ScaledInt<E, B, BT, RT> value) noexcept {
+    if constexpr (B != 10)
+        return std::to_chars(first, last, static_cast<double>(value));
+
+    auto     raw  = value.get_base();
+    uint64_t magn = raw < 0 ? 0 - static_cast<uint64_t>(raw) : static_cast<uint64_t>(raw);
+    if (raw < 0) {
+        if (first == last)
+            return {last, std::errc::value_too_large};
+        *first++ = '-';
+    }
+
+    if constexpr (E <= 0) {
+        auto res = std::to_chars(first, last, magn);
+        if (res.ec != std::errc{} || magn == 0)
+            return res;
+        constexpr auto n_zeros = static_cast<size_t>(-E);
+        if (static_cast<size_t>(last - res.ptr) < n_zeros)
+            return {last, std::errc::value_too_large};
+        std::memset(res.ptr, '0', n_zeros);
+        return {res.ptr + n_zeros, std::errc{}};
+    } else {
+        constexpr auto decimals = static_cast<size_t>(E);
+        constexpr auto divisor  = static_cast<uint64_t>(Pow<E>::val);
+        auto           res      = std::to_chars(first, last, magn / divisor);
+        if (res.ec != std::errc{})
+            return res;
+        if (static_cast<size_t>(last - res.ptr) < decimals + 1)
+            return {last, std::errc::value_too_large};
+
+        *res.ptr     = '.';
+        uint64_t rem = magn % divisor;
+        for (size_t i = decimals; i > 0; --i, rem /= 10)
+            res.ptr[i] = static_cast<char>('0' + rem % 10);
+        return {res.ptr + decimals + 1, std::errc{}};
+    }
+}
+
+/// @brief Parse straight into the TolFloat floating point type
+template <int E, int64_t B, std::floating_point BT>
+std::from_chars_result from_chars(char const*         first,
+                                  char const*         last,
+                                  TolFloat<E, B, BT>& value,
+                                  std::chars_format   fmt = std::chars_format::general) {
+    return std::from_chars(first, last, value.value, fmt);
+}
+
+template <int E, int64_t B, std::floating_point BT>
+std::to_chars_result to_chars(char* first, char* last, TolFloat<E, B, BT> value) noexcept {
+    return std::to_chars(first, last, value.value);
+}
+
+#ifdef CAV_COMP_TESTS
+#include <string_view>
+namespace {
+    struct parsed {
+        int64_t   value;
+        std::errc ec;
+        ptrdiff_t used;
+    };
+
+    template <int8_t E, typename TagT = trunc_tag, typename IntT = int64_t>
+    constexpr parsed parse_scaled(std::string_view str) {
+        auto val = ScaledInt<E, 10, IntT>{};
+        auto res = from_chars(str.data(), str.data() + str.size(), val, TagT{});
+        return {static_cast<int64_t>(val.value), res.ec, res.ptr - str.data()};
+    }
+
+    template <int8_t E, typename TagT = trunc_tag, typename IntT = int64_t>
+    constexpr bool parses_to(std::string_view str, int64_t expected) {
+        auto res = parse_scaled<E, TagT, IntT>(str);
+        return res.ec == std::errc{} && res.value == expected &&
+               res.used == static_cast<ptrdiff_t>(str.size());
+    }
+
+    template <int8_t E, typename TagT = trunc_tag, typename IntT = int64_t>
+    constexpr bool fails_with(std::string_view str, std::errc ec) {
+        return parse_scaled<E, TagT, IntT>(str).ec == ec;
+    }
+
+    // Rounding tags, both signs
+    CAV_PASS(parses_to<2, trunc_tag>("1.239", 123) && parses_to<2, trunc_tag>("-1.239", -123));
+    CAV_PASS(parses_to<2, round_tag>("1.235", 124) && parses_to<2, round_tag>("-1.235", -124));
+    CAV_PASS(parses_to<2, round_tag>("1.2349", 123) && parses_to<2, round_tag>("-1.2349", -123));
+    CAV_PASS(parses_to<2, floor_tag>("1.239", 123) && parses_to<2, floor_tag>("-1.231", -124));
+    CAV_PASS(parses_to<2, floor_tag>("-1.2300", -123));  // exact, no rounding
+    CAV_PASS(parses_to<2, ceil_tag>("1.2301", 124) && parses_to<2, ceil_tag>("-1.239", -123));
+    CAV_PASS(parses_to<2, ceil_tag>("1.2000000000000000000000001", 121));  // sticky digit
+
+    // Precision and shapes
+    CAV_PASS(parses_to<1>("1.", 10) && parses_to<1>(".5", 5) && parses_to<1>("-.5", -5));
+    CAV_PASS(parses_to<1>("000123.4", 1234) && parses_to<3>("7", 7000) && parses_to<0>("0", 0));
+    CAV_PASS(parses_to<2>("0.00000000000000000000000009", 0));
+
+    // Negative E: the kept digits are tens, hundreds, ...
+    CAV_PASS(parses_to<-2, trunc_tag>("12345", 123) && parses_to<-2, round_tag>("12351", 124));
+    CAV_PASS(parses_to<-2, round_tag>("49", 0) && parses_to<-2, round_tag>("50", 1));
+    CAV_PASS(parses_to<-2, floor_tag>("-150", -2) && parses_to<-2, ceil_tag>("1", 1));
+    CAV_PASS(parses_to<-3, ceil_tag>("0.001", 1) && parses_to<-3, floor_tag>("0.001", 0));
+
+    // Overflow
+    CAV_PASS(parses_to<0, trunc_tag, int8_t>("127", 127));
+    CAV_PASS(parses_to<0, trunc_tag, int8_t>("-128", -128));
+    CAV_PASS(fails_with<0, trunc_tag, int8_t>("128", std::errc::result_out_of_range));
+    CAV_PASS(fails_with<0, round_tag, int8_t>("127.5", std::errc::result_out_of_range));
+    CAV_PASS(fails_with<2, trunc_tag, int16_t>("327.68", std::errc::result_out_of_range));
+    CAV_PASS(parses_to<0>("-9223372036854775808", type_min<int64_t>));
+    CAV_PASS(fails_with<0>("9223372036854775808", std::errc::result_out_of_range));
+    CAV_PASS(fails_with<0>("123456789012345678901234", std::errc::result_out_of_range));
+
+    // Malformed input
+    CAV_PASS(fails_with<2>("", std::errc::invalid_argument));
+    CAV_PASS(fails_with<2>("-", std::errc::invalid_argument));
+    CAV_PASS(fails_with<2>(".", std::errc::invalid_argument));
+    CAV_PASS(fails_with<2>("abc", std::errc::invalid_argument));
+    CAV_PASS(fails_with<2>("+1", std::errc::invalid_argument));
+    CAV_PASS(parse_scaled<2>("12x").value == 1200 && parse_scaled<2>("12x").used == 2);
+    CAV_PASS(parse_scaled<2>("1.5.5").value == 150 && parse_scaled<2>("1.5.5").used == 3);
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_UTILS_CHARCONV_HPP */
@@ -0,0 +1,309 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_STRING_FILE_INGEST_HPP
+#define CAV_INCLUDE_STRING_FILE_INGEST_HPP
+
+/// Zero-copy ingestion of text files: iterate the lines of a (typically memory-mapped) buffer as
+/// string_views and parse whole rows of numbers straight into a container, optionally splitting
+/// the buffer at line boundaries across threads. Typical use:
+///
+///     auto text = map_file<char>(path);  // vectors/MmapSpan.hpp
+///     auto view = std::string_view(text.data(), text.size());
+///     auto soa  = SoAArray<soa_aligned_tag<64>, int, double>(count_rows(view));
+///     auto res  = parse_rows(view, soa, n_threads);
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "../comptime/syntactic_sugars.hpp"
+#include "../comptime/test.hpp"
+#include "string_utils.hpp"
+
+namespace cav {
+
+/// @brief Lazy range over the lines of a text, without the '\n' and an optional trailing '\r'.
+/// A final '\n' does not start an additional empty line.
+class LineRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::string_view;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::string_view const*;
+        using reference         = std::string_view const&;
+
+        constexpr iterator() = default;
+
+        constexpr iterator(std::string_view txt)  // NOLINT(*explicit*)
+            : text(txt) {
+            _next(0);
+        }
+
+        [[nodiscard]] constexpr reference operator*() const {
+            return line;
+        }
+
+        [[nodiscard]] constexpr pointer operator->() const {
+            return &line;
+        }
+
+        constexpr iterator& operator++() {
+            _next(next_beg);
+            return *this;
+        }
+
+        constexpr iterator operator++(int) {
+            iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        [[nodiscard]] constexpr bool operator==(iterator const& other) const {
+            return next_beg == other.next_beg;
+        }
+
+        [[nodiscard]] constexpr bool operator==(std::default_sentinel_t /*s*/) const {
+            return next_beg == std::string_view::npos;
+        }
+
+    private:
+        std::string_view text     = {};
+        std::string_view line     = {};
+        size_t           next_beg = std::string_view::npos;
+
+        constexpr void _next(size_t beg) {
+            if (beg >= text.size()) {
+                next_beg = std::string_view::npos;
+                return;
+            }
+            size_t end = text.find('\n', beg);
+            if (end == std::string_view::npos)
+                end = text.size();
+            next_beg = end + 1;
+            if (end > beg && text[end - 1] == '\r')
+                --end;
+            line = text.substr(beg, end - beg);
+        }
+    };
+
+    explicit constexpr LineRange(std::string_view txt)
+        : text(txt) {
+    }
+
+    [[nodiscard]] constexpr iterator begin() const {
+        return {text};
+    }
+
+    [[nodiscard]] constexpr std::default_sentinel_t end() const {
+        return {};
+    }
+
+private:
+    std::string_view text;
+};
+
+[[nodiscard]] constexpr LineRange lines(std::string_view text) {
+    return LineRange(text);
+}
+
+[[nodiscard]] constexpr bool is_blank(std::string_view line) {
+    return line.find_first_not_of(SPACES) == std::string_view::npos;
+}
+
+/// @brief Number of non-blank lines (the rows parse_rows expects)
+[[nodiscard]] constexpr size_t count_rows(std::string_view text) {
+    size_t count = 0;
+    for (std::string_view line : lines(text))
+        count += is_blank(line) ? 0 : 1;
+    return count;
+}
+
+/// @brief Split text into at most n_parts non-empty chunks of roughly the same size, each one
+/// ending right after a '\n' (but the last one)
+[[nodiscard]] constexpr std::vector<std::string_view> split_at_lines(std::string_view text,
+                                                                     size_t           n_parts) {
+    auto parts = std::vector<std::string_view>();
+    n_parts    = std::max<size_t>(n_parts, 1);
+    size_t beg = 0;
+    for (size_t p = 1; p <= n_parts && beg < text.size(); ++p) {
+        size_t end = p == n_parts ? text.size() : std::max(beg, text.size() / n_parts * p);
+        if (end < text.size()) {
+            end = text.find('\n', end);
+            end = end == std::string_view::npos ? text.size() : end + 1;
+        }
+        if (end > beg)
+            parts.push_back(text.substr(beg, end - beg));
+        beg = end;
+    }
+    return parts;
+}
+
+/// @brief Parse a whole token into val with from_chars (found by ADL for non-arithmetic types).
+/// @return True on success, false if the token is malformed, out of range or has trailing chars
+template <typename T>
+[[nodiscard]] bool parse_token(std::string_view tok, T& val) {
+    using std::from_chars;
+    auto res = from_chars(tok.data(), tok.data() + tok.size(), val);
+    return res.ec == std::errc{} && res.ptr == tok.data() + tok.size();
+}
+
+/// @brief Parse the tokens of text into out, in order (e.g., a flat OwnSpan of a matrix)
+/// @return The number of parsed values, it stops at the first malformed token or when out is full
+template <typename T>
+[[nodiscard]] size_t parse_values(std::string_view text,
+                                  std::span<T>     out,
+                                  DelimSet const&  delims = {}) {
+    size_t n = 0;
+    for (std::string_view tok : tokenize(text, delims)) {
+        if (n == out.size() || !parse_token(tok, out[n]))
+            break;
+        ++n;
+    }
+    return n;
+}
+
+struct ingest_result {
+    size_t rows    = 0;                       // rows parsed before bad_row (in file order)
+    size_t bad_row = std::string_view::npos;  // first malformed row (npos if none)
+
+    [[nodiscard]] constexpr bool ok() const {
+        return bad_row == std::string_view::npos;
+    }
+};
+
+namespace detail {
+    /// @brief Parse the fields of one row (tuples and row proxies expose reduce, scalars are a
+    /// single field). Every field needs a token and no token can be left.
+    template <typename RowT>
+    [[nodiscard]] bool parse_row(std::string_view line, RowT&& row, DelimSet const& delims) {
+        auto toks = tokenize(line, delims);
+        auto it   = toks.begin();
+        auto next = [&](auto& field) {
+            if (it == toks.end() || !parse_token(*it, field))
+                return false;
+            ++it;
+            return true;
+        };
+        bool ok = false;
+        if constexpr (requires { row.reduce([](auto&&...) { return true; }); })
+            ok = row.reduce([&](auto&... fields) { return (next(fields) && ...); });
+        else
+            ok = next(row);
+        return ok && it == toks.end();
+    }
+
+    template <typename DestT>
+    [[nodiscard]] ingest_result parse_chunk(std::string_view chunk,
+                                            DestT&           dest,
+                                            size_t           first_row,
+                                            DelimSet const&  delims) {
+        size_t row = first_row;
+        for (std::string_view line : lines(chunk)) {
+            if (is_blank(line))
+                continue;
+            if (row >= std::size(dest) || !parse_row(line, dest[row], delims))
+                return {row - first_row, row};
+            ++row;
+        }
+        return {row - first_row};
+    }
+}  // namespace detail
+
+/// @brief Parse each non-blank line of text into a row of dest (dest[i] is either a tuple/SoA row
+/// proxy with one field per token or a single value), e.g. SoAArray, SoAVector or OwnSpan sized
+/// with count_rows. With n_threads > 1 the text is split with split_at_lines and the chunks are
+/// parsed concurrently (after a parallel pass that counts the rows of each chunk). The result is
+/// the same for any n_threads, but on error the rows after bad_row may have been written too.
+template <typename DestT>
+ingest_result parse_rows(std::string_view text,
+                         DestT&           dest,
+                         size_t           n_threads = 1,
+                         DelimSet const&  delims    = {}) {
+    if (n_threads <= 1)
+        return detail::parse_chunk(text, dest, 0, delims);
+
+    auto chunks  = split_at_lines(text, n_threads);
+    auto offsets = std::vector<size_t>(chunks.size() + 1);
+    {
+        auto workers = std::vector<std::jthread>();
+        for (size_t c = 0; c < chunks.size(); ++c)
+            workers.emplace_back([&, c] { offsets[c + 1] = count_rows(chunks[c]); });
+    }
+    for (size_t c = 0; c < chunks.size(); ++c)
+        offsets[c + 1] += offsets[c];
+
+    auto results = std::vector<ingest_result>(chunks.size());
+    {
+        auto workers = std::vector<std::jthread>();
+        for (size_t c = 0; c < chunks.size(); ++c)
+            workers.emplace_back([&, c] {
+                results[c] = detail::parse_chunk(chunks[c], dest, offsets[c], delims);
+            });
+    }
+
+    auto total = ingest_result{};
+    for (ingest_result const& res : results) {  // up to the first error, as a single thread
+        total.rows += res.rows;
+        if (!res.ok()) {
+            total.bad_row = res.bad_row;
+            break;
+        }
+    }
+    return total;
+}
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    CAV_BLOCK_PASS({
+        auto crlf = std::vector<std::string_view>();
+        for (std::string_view line : lines("a b\r\nc\r\n"))
+            crlf.push_back(line);
+        assert(crlf.size() == 2 && crlf[0] == "a b" && crlf[1] == "c");  // no '\r', no extra line
+
+        auto no_final = std::vector<std::string_view>();
+        for (std::string_view line : lines("1\n2"))
+            no_final.push_back(line);
+        assert(no_final.size() == 2 && no_final[1] == "2");
+    });
+
+    CAV_PASS(count_rows("") == 0 && count_rows("\n\n") == 0);
+    CAV_PASS(count_rows("1\n\n  \t\n2\r\n\r\n3") == 3);  // blank and CRLF-only lines skipped
+    CAV_PASS(count_rows("1 2\n3 4") == 2);                // missing final newline
+
+    CAV_BLOCK_PASS({
+        auto parts = split_at_lines("1\n2\n", 8);  // more parts than lines
+        assert(parts.size() == 2 && parts[0] == "1\n" && parts[1] == "2\n");
+
+        parts = split_at_lines("10\n20\n30", 2);
+        assert(parts.size() == 2 && parts[0] == "10\n20\n" && parts[1] == "30");
+
+        assert(split_at_lines("", 4).empty());
+        assert(split_at_lines("abc", 0).size() == 1);  // at least one part
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_STRING_FILE_INGEST_HPP */
@@ -16,7 +16,14 @@
 #ifndef CAV_INCLUDE_STRINGUTILS_HPP
 #define CAV_INCLUDE_STRINGUTILS_HPP
 
+#include <array>
+#include <bit>
+#include <cassert>
 #include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
 #include <ranges>
 #include <string>
 #include <string_view>
@@ -26,6 +33,10 @@
 #include "../comptime/enum_name.hpp"
 #include "../comptime/type_name.hpp"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #if __has_include(<fmt/core.h>)
 #define CAV_FOUND_FMT
 #include <fmt/core.h>
@@ -92,21 +103,21 @@ static inline void remove_multiple_adj(std::string& s, std::string_view delim =
 }
 
 // Return "new" object with string_view (which are only a proxy on the same memory)
-static inline std::string_view ltrim(std::string_view s, char const* delim = SPACES) {
+static constexpr std::string_view ltrim(std::string_view s, char const* delim = SPACES) {
     auto pos = s.find_first_not_of(delim);
     if (pos != std::string_view::npos)
         return s.substr(pos);
     return {};
 }
 
-static inline std::string_view rtrim(std::string_view s, char const* delim = SPACES) {
+static constexpr std::string_view rtrim(std::string_view s, char const* delim = SPACES) {
     auto pos = s.find_last_not_of(delim);
     if (pos != std::string_view::npos)
         return s.substr(0, pos + 1);
     return {};
 }
 
-static inline std::string_view trim(std::string_view s, char const* delim = SPACES) {
+static constexpr std::string_view trim(std::string_view s, char const* delim = SPACES) {
     return rtrim(ltrim(s, delim), delim);
 }
 
@@ -116,29 +127,190 @@ inline std::string remove_multiple_adj(std::string_view& s, char const* delim =
     return s_new;
 }
 
-inline auto split_line(std::string_view line, std::string_view delim = SPACES) {
-    std::vector<std::string_view> tokens;
+/// @brief Set of delimiter chars as a 256-bit lookup table. Sets of up to simd_max chars are also
+/// kept as a list, to scan 16 bytes at a time with SSE2 compare masks.
+class DelimSet {
+public:
+    static constexpr size_t simd_max = 8;
+
+    constexpr DelimSet(std::string_view chars = SPACES)  // NOLINT(*explicit*)
+        : lut()
+        , list()
+        , list_sz(chars.size() <= simd_max ? chars.size() : 0) {
+        for (char c : chars)
+            lut[_uchar(c) / 64U] |= uint64_t{1} << (_uchar(c) % 64U);
+        for (size_t i = 0; i < list_sz; ++i)
+            list[i] = chars[i];
+    }
+
+    constexpr DelimSet(char const* chars)  // NOLINT(*explicit*)
+        : DelimSet(std::string_view(chars)) {
+    }
+
+    constexpr DelimSet(char delim)  // NOLINT(*explicit*)
+        : DelimSet(std::string_view(&delim, 1)) {
+    }
+
+    [[nodiscard]] constexpr bool contains(char c) const {
+        return (lut[_uchar(c) / 64U] >> (_uchar(c) % 64U) & 1U) != 0;
+    }
+
+    /// @brief Index of the first delimiter in s[from, s.size()), s.size() if none
+    [[nodiscard]] constexpr size_t find_in(std::string_view s, size_t from) const {
+#if defined(__SSE2__)
+        if (!std::is_constant_evaluated() && list_sz > 0)
+            from = _simd_skip(s, from);
+#endif
+        while (from < s.size() && !contains(s[from]))
+            ++from;
+        return from;
+    }
+
+private:
+    std::array<uint64_t, 4>    lut;
+    std::array<char, simd_max> list;
+    size_t                     list_sz;
+
+    [[nodiscard]] static constexpr unsigned _uchar(char c) {
+        return static_cast<unsigned char>(c);
+    }
+
+#if defined(__SSE2__)
+    /// @brief Skip the 16-byte blocks without delimiters, return the position of the first
+    /// delimiter found or of the first unchecked char
+    [[nodiscard]] size_t _simd_skip(std::string_view s, size_t from) const {
+        __m128i needles[simd_max];
+        for (size_t k = 0; k < list_sz; ++k)
+            needles[k] = _mm_set1_epi8(list[k]);
+
+        for (; from + 16 <= s.size(); from += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s.data() + from));
+            __m128i match = _mm_cmpeq_epi8(block, needles[0]);
+            for (size_t k = 1; k < list_sz; ++k)
+                match = _mm_or_si128(match, _mm_cmpeq_epi8(block, needles[k]));
+            if (auto mask = static_cast<unsigned>(_mm_movemask_epi8(match)); mask != 0)
+                return from + static_cast<size_t>(std::countr_zero(mask));
+        }
+        return from;
+    }
+#endif
+};
+
+/// @brief Lazy, allocation-free range over the tokens of a line: maximal runs of non-delimiter
+/// chars, each trimmed of SPACES (same tokens as split_line). Iterators point to the range, which
+/// must outlive them.
+class TokenRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::string_view;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::string_view const*;
+        using reference         = std::string_view const&;
+
+        constexpr iterator() = default;
+
+        constexpr iterator(TokenRange const* rng)  // NOLINT(*explicit*)
+            : range(rng) {
+            _next(0);
+        }
+
+        [[nodiscard]] constexpr reference operator*() const {
+            return token;
+        }
 
-    int lsize  = static_cast<int>(line.size());
-    int last_i = 0;
-    for (int i = 0; i < lsize; ++i) {
-        if (std::ranges::find(delim, line[i]) != delim.end()) {
-            if (i > last_i) {
-                tokens.emplace_back(line.data() + last_i, i - last_i);
-                tokens.back() = trim(tokens.back());
+        [[nodiscard]] constexpr pointer operator->() const {
+            return &token;
+        }
+
+        constexpr iterator& operator++() {
+            _next(tok_end);
+            return *this;
+        }
+
+        constexpr iterator operator++(int) {
+            iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        [[nodiscard]] constexpr bool operator==(iterator const& other) const {
+            return tok_beg == other.tok_beg;
+        }
+
+        [[nodiscard]] constexpr bool operator==(std::default_sentinel_t /*s*/) const {
+            return tok_beg == std::string_view::npos;
+        }
+
+    private:
+        TokenRange const* range   = nullptr;
+        size_t            tok_beg = std::string_view::npos;
+        size_t            tok_end = std::string_view::npos;
+        std::string_view  token   = {};
+
+        constexpr void _next(size_t from) {
+            std::string_view line = range->line;
+            while (from < line.size() && range->delims.contains(line[from]))
+                ++from;
+            if (from >= line.size()) {
+                tok_beg = tok_end = std::string_view::npos;
+                return;
             }
-            last_i = i + 1;
+            tok_beg = from;
+            tok_end = range->delims.find_in(line, from + 1);
+
+            constexpr auto spaces = DelimSet(SPACES);  // trim, as split_line
+            size_t         beg    = tok_beg;
+            size_t         end    = tok_end;
+            while (beg < end && spaces.contains(line[beg]))
+                ++beg;
+            while (end > beg && spaces.contains(line[end - 1]))
+                --end;
+            token = beg < end ? line.substr(beg, end - beg) : std::string_view{};
         }
+    };
+
+    constexpr TokenRange(std::string_view ln, DelimSet const& dlms)
+        : line(ln)
+        , delims(dlms) {
+    }
+
+    [[nodiscard]] constexpr iterator begin() const {
+        return {this};
     }
-    if (last_i < lsize) {
-        tokens.emplace_back(line.data() + last_i, lsize - last_i);
-        tokens.back() = trim(tokens.back());
+
+    [[nodiscard]] constexpr std::default_sentinel_t end() const {
+        return {};
     }
+
+private:
+    std::string_view line;
+    DelimSet         delims;
+};
+
+/// @brief Lazy split of line into tokens, see TokenRange
+[[nodiscard]] constexpr TokenRange tokenize(std::string_view line, DelimSet const& delims = {}) {
+    return {line, delims};
+}
+
+/// @brief Split line into the caller-provided buffer (cleared first, its capacity is reused)
+inline void split_line(std::string_view               line,
+                       std::vector<std::string_view>& tokens,
+                       DelimSet const&                delims = {}) {
+    tokens.clear();
+    for (std::string_view tok : tokenize(line, delims))
+        tokens.push_back(tok);
+}
+
+inline auto split_line(std::string_view line, std::string_view delim = SPACES) {
+    std::vector<std::string_view> tokens;
+    split_line(line, tokens, DelimSet(delim));
     return tokens;
 }
 
 inline auto split_line(std::string_view line, char delim) {
-    return split_line(line, std::string(1, delim));
+    return split_line(line, std::string_view(&delim, 1));
 }
 
 template <typename T>
@@ -169,12 +341,10 @@ void from_string_view_checked(std::string_view str, T& val, OnErrT&& on_error =
 template <typename T, typename OnErrT = decltype([] { abort(); })>
 requires std::is_enum_v<T>
 void from_string_view_checked(std::string_view str, T& val, OnErrT&& on_error = {}) {
-    using utype = std::underlying_type_t<T>;
-    for (utype i = 0; i < enum_size<T>::value; ++i)
-        if (enum_name<T>(static_cast<T>(i)) == str) {
-            val = static_cast<T>(i);
-            return;
-        }
+    if (std::optional<T> found = enum_from_name<T>(str)) {
+        val = *found;
+        return;
+    }
     fmt::print(stderr, "Error: enum value {} not found in enum {}\n", str, type_name<T>::name);
     on_error();
 }
@@ -0,0 +1,207 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_TUPLISH_TASK_GRAPH_HPP
+#define CAV_TUPLISH_TASK_GRAPH_HPP
+
+#include <array>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../comptime/test.hpp"
+#include "../mish/util_functions.hpp"
+#include "dependencies.hpp"
+
+namespace cav {
+
+/// @brief Executor of a DAG of components described with dependencies.hpp. Each component is
+/// default constructible and has a run member taking its resolved deps (as const&, in deps order):
+///
+///     struct Load  { void run() { ... } };
+///     struct Parse { using deps = deps_t<Load>; void run(Load const& l) { ... } };
+///
+/// The components (and their transitive dependencies) are stored in the make_dependency_set_t
+/// type_set. The level of a component (0 without deps, 1 + the max level of its deps otherwise)
+/// is computed at compile time, and run() executes the levels in order, running the components of
+/// the same level concurrently.
+
+namespace detail {
+    template <typename T>
+    consteval int dep_level();
+
+    template <typename... Ds>
+    consteval int max_dep_level(pack<Ds...> /*p*/) {
+        int lvl = -1;
+        ((lvl = max(lvl, dep_level<Ds>())), ...);
+        return lvl;
+    }
+
+    template <typename T>
+    consteval int dep_level() {
+        if constexpr (REQUIRES_TYPE(T::deps))
+            return 1 + max_dep_level(typename T::deps{});
+        else
+            return 0;
+    }
+
+    template <typename... Ts>
+    consteval int graph_depth(pack<Ts...> /*p*/) {
+        int depth = 0;
+        ((depth = max(depth, dep_level<Ts>() + 1)), ...);
+        return depth;
+    }
+}  // namespace detail
+
+template <typename... Ts>
+class TaskGraph {
+public:
+    using order_type      = resolve_deps_t<Ts...>;  // topological order
+    using components_type = make_dependency_set_t<Ts...>;
+
+    static constexpr int n_levels = detail::graph_depth(order_type{});
+
+    /// @brief Compile-time level of T in the graph
+    template <typename T>
+    static constexpr int level_of = detail::dep_level<T>();
+
+    components_type components = {};
+
+    template <typename T>
+    [[nodiscard]] T& get() {
+        return components[tag<T>];
+    }
+
+    template <typename T>
+    [[nodiscard]] T const& get() const {
+        return components[tag<T>];
+    }
+
+    /// @brief Run every component once, level by level, on up to n_threads threads (the calling
+    /// one included). The first exception thrown by a run() is rethrown after its level completes.
+    void run(unsigned n_threads = std::thread::hardware_concurrency()) {
+        n_threads = max(n_threads, 1U);
+        [&]<int... Ls>(std::integer_sequence<int, Ls...> /*s*/) {
+            (_run_level<Ls>(n_threads), ...);
+        }(std::make_integer_sequence<int, n_levels>{});
+    }
+
+private:
+    using task_fn = void (*)(components_type&);
+
+    template <typename T>
+    static void _run_one(components_type& comps) {
+        if constexpr (REQUIRES_TYPE(T::deps))
+            [&]<typename... Ds>(pack<Ds...> /*p*/) {
+                comps[tag<T>].run(std::as_const(comps[tag<Ds>])...);
+            }(typename T::deps{});
+        else
+            comps[tag<T>].run();
+    }
+
+    template <int L>
+    static constexpr auto level_tasks = []<typename... Us>(pack<Us...> /*p*/) {
+        constexpr int n_tasks = ((detail::dep_level<Us>() == L ? 1 : 0) + ... + 0);
+        auto          tasks   = std::array<task_fn, n_tasks>{};
+        int           i       = 0;
+        ((detail::dep_level<Us>() == L ? (tasks[i++] = &_run_one<Us>, 0) : 0), ...);
+        return tasks;
+    }(order_type{});
+
+    template <int L>
+    void _run_level(unsigned n_threads) {
+        static constexpr auto const& tasks = level_tasks<L>;
+        if (tasks.size() == 1 || n_threads == 1) {
+            for (task_fn task : tasks)
+                task(components);
+            return;
+        }
+
+        auto next  = std::atomic<size_t>(0);
+        auto error = std::exception_ptr();
+        auto flag  = std::atomic_flag();
+        auto work  = [&] {
+            for (size_t t = next++; t < tasks.size(); t = next++) {
+#if __cpp_exceptions
+                try {
+                    tasks[t](components);
+                } catch (...) {
+                    if (!flag.test_and_set())
+                        error = std::current_exception();
+                }
+#else
+                tasks[t](components);
+#endif
+            }
+        };
+        {
+            auto workers = std::vector<std::jthread>();
+            for (size_t w = 1; w < min(size_t{n_threads}, tasks.size()); ++w)
+                workers.emplace_back(work);
+            work();
+        }
+        if (error)
+            std::rethrow_exception(error);
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    struct TG_A {
+        int val = 0;
+
+        void run() {
+            val = 1;
+        }
+    };
+
+    struct TG_B {
+        using deps = deps_t<TG_A>;
+        int val    = 0;
+
+        void run(TG_A const& a) {
+            val = a.val + 1;
+        }
+    };
+
+    struct TG_C {
+        using deps = deps_t<TG_A>;
+        int val    = 0;
+
+        void run(TG_A const& a) {
+            val = a.val + 2;
+        }
+    };
+
+    struct TG_D {
+        using deps = deps_t<TG_B, TG_C>;
+        int val    = 0;
+
+        void run(TG_A const& a, TG_B const& b, TG_C const& c) {
+            val = a.val + b.val + c.val;
+        }
+    };
+
+    using tg_t = TaskGraph<TG_D>;
+    CAV_PASS(tg_t::n_levels == 3);
+    CAV_PASS(tg_t::level_of<TG_A> == 0 && tg_t::level_of<TG_C> == 1 && tg_t::level_of<TG_D> == 2);
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_TUPLISH_TASK_GRAPH_HPP */
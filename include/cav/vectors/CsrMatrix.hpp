@@ -0,0 +1,324 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_VECTORS_CSRMATRIX_HPP
+#define CAV_INCLUDE_VECTORS_CSRMATRIX_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "../comptime/test.hpp"
+#include "../mish/ThreadPool.hpp"
+#include "../mish/util_functions.hpp"
+#include "../numeric/sort.hpp"
+#include "OwnSpan.hpp"
+
+namespace cav {
+
+/// @brief Compressed sparse row matrix, the sparse counterpart of MatrixKD<T, 2>: the columns and
+/// values of row i are cols[row_beg[i], row_beg[i + 1]) and vals[...], sorted by column, in three
+/// OwnSpan. The compressed column form of a matrix is the CSR form of its transpose(), which is a
+/// counting sort in O(nnz + n_cols).
+///
+/// The parallel kernels run on a ThreadPool, splitting the rows in chunks of about the same
+/// number of non-zeros (very uneven rows are the rule in constraint matrices).
+///
+/// @tparam SzT  Row/column index and offset type (as in Sorter<SzT>): nnz must fit in it
+template <typename T, typename SzT = uint32_t>
+class CsrMatrix {
+public:
+    using value_type = T;
+    using size_type  = SzT;
+
+    struct row_view {
+        std::span<SzT const> cols;
+        std::span<T const>   vals;
+
+        [[nodiscard]] constexpr size_t size() const noexcept {
+            return cols.size();
+        }
+    };
+
+    constexpr CsrMatrix() = default;
+
+    /// @brief Adopt already compressed arrays (row_beg has n_rows + 1 offsets, columns sorted)
+    constexpr CsrMatrix(SzT          c_n_rows,
+                        SzT          c_n_cols,
+                        OwnSpan<SzT> c_row_beg,
+                        OwnSpan<SzT> c_cols,
+                        OwnSpan<T>   c_vals)
+        : row_beg(std::move(c_row_beg))
+        , cols(std::move(c_cols))
+        , vals(std::move(c_vals))
+        , nrows(c_n_rows)
+        , ncols(c_n_cols) {
+        assert(row_beg.size() == static_cast<size_t>(nrows) + 1);
+        assert(cols.size() == vals.size() && row_beg[nrows] == cols.size());
+    }
+
+    [[nodiscard]] constexpr SzT n_rows() const noexcept {
+        return nrows;
+    }
+
+    [[nodiscard]] constexpr SzT n_cols() const noexcept {
+        return ncols;
+    }
+
+    [[nodiscard]] constexpr size_t nnz() const noexcept {
+        return cols.size();
+    }
+
+    [[nodiscard]] constexpr row_view row(SzT i) const noexcept {
+        assert(i < nrows);
+        size_t beg = row_beg[i];
+        size_t len = row_beg[i + 1] - beg;
+        return {std::span(cols.data() + beg, len), std::span(vals.data() + beg, len)};
+    }
+
+    [[nodiscard]] constexpr std::span<SzT const> row_begins() const noexcept {
+        return {row_beg.data(), row_beg.size()};
+    }
+
+    [[nodiscard]] constexpr std::span<SzT const> col_indexes() const noexcept {
+        return {cols.data(), cols.size()};
+    }
+
+    /// @brief The non-zeros (modifiable in place, the sparsity pattern is not)
+    [[nodiscard]] constexpr std::span<T> values() noexcept {
+        return {vals.data(), vals.size()};
+    }
+
+    [[nodiscard]] constexpr std::span<T const> values() const noexcept {
+        return {vals.data(), vals.size()};
+    }
+
+    /// @brief Element (i, j), T{} if not stored (binary search in the row)
+    [[nodiscard]] constexpr T at(SzT i, SzT j) const noexcept {
+        row_view r  = row(i);
+        auto     it = std::lower_bound(r.cols.begin(), r.cols.end(), j);
+        return it != r.cols.end() && *it == j ? r.vals[it - r.cols.begin()] : T{};
+    }
+
+    /// @brief The transpose (equivalently, the compressed column form of this matrix)
+    [[nodiscard]] constexpr CsrMatrix transpose() const {
+        auto t_beg = OwnSpan<SzT>(static_cast<size_t>(ncols) + 1, SzT{0});
+        for (SzT c : cols)
+            ++t_beg[c + 1];
+        for (size_t c = 0; c < ncols; ++c)
+            t_beg[c + 1] += t_beg[c];
+
+        // Scanning the rows in order leaves the transposed rows sorted by column
+        auto t_cols = OwnSpan<SzT>(nnz(), uninit);
+        auto t_vals = OwnSpan<T>(nnz());
+        auto next   = OwnSpan<SzT>(ncols, uninit);
+        std::copy_n(t_beg.begin(), ncols, next.begin());
+        for (SzT i = 0; i < nrows; ++i)
+            for (size_t k = row_beg[i]; k < row_beg[i + 1]; ++k) {
+                SzT dest     = next[cols[k]]++;
+                t_cols[dest] = i;
+                t_vals[dest] = vals[k];
+            }
+        return {ncols, nrows, std::move(t_beg), std::move(t_cols), std::move(t_vals)};
+    }
+
+    /////////////////////////////// KERNELS ///////////////////////////////
+
+    /// @brief y = A x
+    constexpr void multiply(std::span<T const> x, std::span<T> y) const noexcept {
+        assert(x.size() == ncols && y.size() == nrows);
+        _multiply_rows(x, y, 0, nrows);
+    }
+
+    /// @brief y = A^T x
+    constexpr void multiply_transposed(std::span<T const> x, std::span<T> y) const noexcept {
+        assert(x.size() == nrows && y.size() == ncols);
+        std::fill(y.begin(), y.end(), T{});
+        _scatter_rows(x, y, 0, nrows);
+    }
+
+    /// @brief y = A x, each chunk of rows (about 8 per worker, same nnz) writes its slice of y
+    void parallel_multiply(std::span<T const> x,
+                           std::span<T>       y,
+                           ThreadPool&        pool = ThreadPool::global()) const {
+        assert(x.size() == ncols && y.size() == nrows);
+        auto bounds = nnz_chunks(size_t{8} * pool.size());
+        pool.parallel_for(size_t{0}, bounds.size() - 1, 1, [&](size_t c) {
+            _multiply_rows(x, y, bounds[c], bounds[c + 1]);
+        });
+    }
+
+    /// @brief y = A^T x, row-partitioned: each of the pool.size() nnz-balanced row chunks scatters
+    /// into a private n_cols() buffer (the first one into y), then the buffers are summed column
+    /// by column. For repeated products, multiplying the transpose() is cheaper.
+    void parallel_multiply_transposed(std::span<T const> x,
+                                      std::span<T>       y,
+                                      ThreadPool&        pool = ThreadPool::global()) const {
+        assert(x.size() == nrows && y.size() == ncols);
+        auto   bounds  = nnz_chunks(pool.size());
+        size_t n_part  = bounds.size() - 1;
+        auto   partial = OwnSpan<T>(n_part > 1 ? (n_part - 1) * ncols : 0);
+        pool.parallel_for(size_t{0}, n_part, 1, [&](size_t p) {
+            auto out = p == 0 ? y : std::span(partial.data() + (p - 1) * ncols, ncols);
+            std::fill(out.begin(), out.end(), T{});
+            _scatter_rows(x, out, bounds[p], bounds[p + 1]);
+        });
+        if (n_part > 1)
+            pool.parallel_for(size_t{0}, size_t{ncols}, 0, [&](size_t beg, size_t end) {
+                for (size_t p = 0; p + 1 < n_part; ++p)
+                    for (size_t c = beg; c < end; ++c)
+                        y[c] += partial[p * ncols + c];
+            });
+    }
+
+    /// @brief n_chunks + 1 row boundaries splitting the rows in chunks of about nnz() / n_chunks
+    /// non-zeros each (a chunk is never split inside a row, so some can be empty)
+    [[nodiscard]] constexpr OwnSpan<SzT> nnz_chunks(size_t n_chunks) const {
+        n_chunks    = max(n_chunks, size_t{1});
+        auto bounds = OwnSpan<SzT>(n_chunks + 1, nrows);
+        bounds[0]   = 0;
+        for (size_t c = 1; c < n_chunks; ++c) {
+            size_t target = nnz() * c / n_chunks;
+            auto   first  = row_beg.begin() + bounds[c - 1];
+            auto   it     = std::lower_bound(first, row_beg.end() - 1, target);
+            bounds[c]     = static_cast<SzT>(it - row_beg.begin());
+        }
+        return bounds;
+    }
+
+private:
+    OwnSpan<SzT> row_beg = OwnSpan<SzT>(1, SzT{0});
+    OwnSpan<SzT> cols    = {};
+    OwnSpan<T>   vals    = {};
+    SzT          nrows   = 0;
+    SzT          ncols   = 0;
+
+    constexpr void _multiply_rows(std::span<T const> x, std::span<T> y, SzT beg, SzT end) const {
+        for (SzT i = beg; i < end; ++i) {
+            T sum = {};
+            for (size_t k = row_beg[i]; k < row_beg[i + 1]; ++k)
+                sum += vals[k] * x[cols[k]];
+            y[i] = sum;
+        }
+    }
+
+    constexpr void _scatter_rows(std::span<T const> x, std::span<T> y, SzT beg, SzT end) const {
+        for (SzT i = beg; i < end; ++i)
+            for (size_t k = row_beg[i]; k < row_beg[i + 1]; ++k)
+                y[cols[k]] += vals[k] * x[i];
+    }
+};
+
+/// @brief Triplet (row, col, val) accumulator compressed into a CsrMatrix by build(): the
+/// triplets are radix sorted by (row, col) with Sorter (one pass on a 64-bit key when SzT fits
+/// in 32 bits, otherwise two stable passes) and duplicates are summed.
+template <typename T, typename SzT = uint32_t>
+class CsrBuilder {
+public:
+    struct triplet {
+        SzT row, col;
+        T   val;
+    };
+
+    constexpr CsrBuilder(SzT c_n_rows, SzT c_n_cols, size_t expected_nnz = 0)
+        : nrows(c_n_rows)
+        , ncols(c_n_cols) {
+        triplets.reserve(expected_nnz);
+    }
+
+    constexpr void add(SzT row, SzT col, T val) {
+        assert(row < nrows && col < ncols);
+        triplets.push_back({row, col, std::move(val)});
+    }
+
+    [[nodiscard]] constexpr size_t size() const noexcept {
+        return triplets.size();
+    }
+
+    /// @brief Compress the triplets (left sorted) into a CsrMatrix
+    [[nodiscard]] CsrMatrix<T, SzT> build() {
+        auto sorter = Sorter<SzT>();
+        return build(sorter);
+    }
+
+    [[nodiscard]] CsrMatrix<T, SzT> build(Sorter<SzT>& sorter) {
+        if constexpr (sizeof(SzT) <= sizeof(uint32_t))
+            sorter.radix_sort(triplets, [](triplet const& t) {
+                return (static_cast<uint64_t>(t.row) << 32U) | static_cast<uint64_t>(t.col);
+            });
+        else {
+            sorter.radix_sort(triplets, [](triplet const& t) { return t.col; });
+            sorter.radix_sort(triplets, [](triplet const& t) { return t.row; });
+        }
+
+        size_t n_unique = 0;
+        for (size_t k = 0; k < triplets.size(); ++k)
+            n_unique += k == 0 || triplets[k].row != triplets[k - 1].row ||
+                        triplets[k].col != triplets[k - 1].col;
+
+        auto   row_beg = OwnSpan<SzT>(static_cast<size_t>(nrows) + 1, SzT{0});
+        auto   cols    = OwnSpan<SzT>(n_unique, uninit);
+        auto   vals    = OwnSpan<T>(n_unique);
+        size_t nz      = 0;
+        for (size_t k = 0; k < triplets.size(); ++k) {
+            triplet const& t = triplets[k];
+            if (nz > 0 && t.row == triplets[k - 1].row && t.col == cols[nz - 1]) {
+                vals[nz - 1] += t.val;
+                continue;
+            }
+            ++row_beg[t.row + 1];
+            cols[nz]   = t.col;
+            vals[nz++] = t.val;
+        }
+        for (size_t i = 0; i < nrows; ++i)
+            row_beg[i + 1] += row_beg[i];
+        return {nrows, ncols, std::move(row_beg), std::move(cols), std::move(vals)};
+    }
+
+private:
+    std::vector<triplet> triplets = {};
+    SzT                  nrows;
+    SzT                  ncols;
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    CAV_BLOCK_PASS({
+        auto own = []<typename U>(std::initializer_list<U> list) {
+            auto res = OwnSpan<U>(list.size());
+            std::copy(list.begin(), list.end(), res.begin());
+            return res;
+        };
+        auto mat = CsrMatrix<int>(2, 3, own({0U, 2U, 3U}), own({0U, 2U, 1U}), own({1, 2, 3}));
+        auto tr = mat.transpose();
+        assert(tr.n_rows() == 3 && tr.nnz() == 3 && tr.at(2, 0) == 2 && tr.at(1, 1) == 3);
+        assert(tr.at(0, 1) == 0 && tr.row(0).size() == 1);
+
+        int x[]  = {1, 10, 100};
+        int y[2] = {};
+        mat.multiply(x, y);
+        assert(y[0] == 201 && y[1] == 30);
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_VECTORS_CSRMATRIX_HPP */
@@ -19,8 +19,12 @@
 
 #include <array>
 #include <cassert>
+#include <cstring>
+#include <memory>
+#include <type_traits>
 
 #include "../comptime/syntactic_sugars.hpp"
+#include "../comptime/test.hpp"
 
 namespace cav {
 
@@ -30,7 +34,8 @@ namespace cav {
 ///
 /// @tparam T value type
 /// @tparam N max size
-template <typename T, int N>
+/// @tparam Uninit if true, keep raw storage and construct only the used elements (see below)
+template <typename T, int N, bool Uninit = false>
 class GrowArray : public std::array<T, N> {
 public:
     using value_type = T;
@@ -80,6 +85,197 @@ private:
     int sz{};
 };
 
+/// @brief GrowArray on uninitialized storage: elements are constructed in place on insertion and
+/// only [0, size()) is destroyed, copied or moved (with memcpy when T is trivially copyable).
+/// Creating and discarding one costs nothing regardless of N.
+template <typename T, int N>
+class GrowArray<T, N, true> {
+    static constexpr bool memcpy_ok = std::is_trivially_copyable_v<T>;
+
+    union storage {
+        T elems[N];
+
+        constexpr storage() {
+        }
+
+        constexpr ~storage() requires std::is_trivially_destructible_v<T>
+        = default;
+
+        constexpr ~storage() {
+        }
+    };
+
+public:
+    using value_type = T;
+
+    constexpr GrowArray() = default;
+
+    constexpr GrowArray(GrowArray const& other) {
+        _copy_from(other);
+    }
+
+    constexpr GrowArray(GrowArray&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        _move_from(other);
+    }
+
+    constexpr GrowArray& operator=(GrowArray const& other) {
+        if (this != &other) {
+            clear();
+            _copy_from(other);
+        }
+        return *this;
+    }
+
+    constexpr GrowArray& operator=(GrowArray&& other) noexcept(
+        std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            clear();
+            _move_from(other);
+        }
+        return *this;
+    }
+
+    constexpr ~GrowArray() requires std::is_trivially_destructible_v<T>
+    = default;
+
+    constexpr ~GrowArray() {
+        clear();
+    }
+
+    template <typename OtherT>
+    requires std::same_as<no_cvr<OtherT>, T>
+    constexpr void push_back(OtherT&& val) {
+        emplace_back(FWD(val));
+    }
+
+    constexpr auto emplace_back(auto&&... args) {
+        assert(sz < N);
+        std::construct_at(data() + sz, FWD(args)...);
+        return begin() + sz++;
+    }
+
+    constexpr void pop_back() {
+        assert(sz > 0);
+        std::destroy_at(data() + --sz);
+    }
+
+    [[nodiscard]] constexpr T const& operator[](int i) const {
+        assert(0 <= i && i < sz);
+        return data()[i];
+    }
+
+    [[nodiscard]] constexpr T& operator[](int i) {
+        assert(0 <= i && i < sz);
+        return data()[i];
+    }
+
+    [[nodiscard]] constexpr T const& back() const {
+        return (*this)[sz - 1];
+    }
+
+    [[nodiscard]] constexpr T& back() {
+        return (*this)[sz - 1];
+    }
+
+    [[nodiscard]] constexpr T const* data() const {
+        return store.elems;
+    }
+
+    [[nodiscard]] constexpr T* data() {
+        return store.elems;
+    }
+
+    [[nodiscard]] constexpr auto begin() const {
+        return data();
+    }
+
+    [[nodiscard]] constexpr auto begin() {
+        return data();
+    }
+
+    [[nodiscard]] constexpr auto end() const {
+        return data() + sz;
+    }
+
+    [[nodiscard]] constexpr auto end() {
+        return data() + sz;
+    }
+
+    [[nodiscard]] constexpr bool empty() const {
+        return sz == 0;
+    }
+
+    [[nodiscard]] constexpr int size() const {
+        return sz;
+    }
+
+    [[nodiscard]] static constexpr int max_size() {
+        return N;
+    }
+
+    constexpr void clear() {
+        std::destroy(begin(), end());
+        sz = 0;
+    }
+
+private:
+    storage store;
+    int     sz{};
+
+    constexpr void _copy_from(GrowArray const& other) {
+        if constexpr (memcpy_ok)
+            if (!std::is_constant_evaluated()) {
+                std::memcpy(data(), other.data(), static_cast<size_t>(other.sz) * sizeof(T));
+                sz = other.sz;
+                return;
+            }
+        for (; sz < other.sz; ++sz)  // sz counts only the constructed ones if a ctor throws
+            std::construct_at(data() + sz, other.data()[sz]);
+    }
+
+    constexpr void _move_from(GrowArray& other) {
+        if constexpr (memcpy_ok)
+            if (!std::is_constant_evaluated()) {
+                std::memcpy(data(), other.data(), static_cast<size_t>(other.sz) * sizeof(T));
+                sz = other.sz;
+                return;
+            }
+        for (; sz < other.sz; ++sz)  // sz counts only the constructed ones if a ctor throws
+            std::construct_at(data() + sz, std::move(other.data()[sz]));
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    CAV_BLOCK_PASS({
+        auto arr = GrowArray<int, 8, true>();
+        arr.push_back(1);
+        arr.emplace_back(2);
+        auto copy = arr;
+        arr.pop_back();
+        assert(arr.size() == 1 && copy.size() == 2 && copy.back() == 2);
+        arr = std::move(copy);
+        assert(arr.size() == 2 && arr[0] == 1 && arr[1] == 2);
+    });
+
+    CAV_BLOCK_PASS({  // non trivial T: only [0, size()) is constructed and destroyed
+        auto arr = GrowArray<std::vector<int>, 4, true>();
+        arr.emplace_back(3, 1);
+        arr.emplace_back(4, 2);
+        auto moved = std::move(arr);
+        assert(moved.size() == 2 && moved[1].size() == 4 && moved[1][3] == 2);
+        moved.clear();
+        assert(moved.empty());
+    });
+
+    CAV_BLOCK_FAIL({
+        auto arr = GrowArray<int, 1, true>();
+        arr.push_back(1);
+        arr.push_back(2);  // past N
+    });
+}  // namespace
+#endif
+
 }  // namespace cav
 
 
@@ -24,7 +24,9 @@
 #include <cstdint>
 #include <numeric>
 #include <span>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include "../comptime/syntactic_sugars.hpp"
 #include "../comptime/test.hpp"
@@ -50,42 +52,77 @@ template <int K, typename MatT>
         return SubMatrixKD<mat_t, K>{FWD(mat), offset};
 
     else if constexpr (K == 0)
-        return mat.own_span[offset];
+        return mat.data()[offset];
 }
 
+/// @brief Default MatrixKD storage deleter (aligned allocation when rows are aligned)
+template <typename T, size_t RowAlign>
+using matrix_del_t = std::conditional_t<RowAlign == 0, AllocatorDel<T>, AlignedDel<T, RowAlign>>;
+
 /// @brief Matrix with K dimensions.
 /// Barebones implementation to keep it readable and avoid hunderd of line of iterator shenanigans.
 /// Sub-matrices are represented using SubMatrixKD proxy and have the mat[i][j] syntax.
 /// Strides for each dimentsion are stored in explicitly.
+/// With RowAlign > 0 the allocation is RowAlign-aligned and the innermost rows are padded to a
+/// multiple of RowAlign bytes (e.g., 64 to avoid false sharing between rows written by different
+/// threads, or the SIMD width for aligned row loads). The padding is part of data_span().
+/// DelT is the OwnSpan deleter of the storage (e.g., a MappableDel for snapshot reloads).
 /// Some compile-time testing at the end of the header.
-template <typename T, int K = 1>
+template <typename T, int K = 1, size_t RowAlign = 0, typename DelT = matrix_del_t<T, RowAlign>>
 struct MatrixKD {
-    using self       = MatrixKD<T, K>;
+    using self       = MatrixKD<T, K, RowAlign, DelT>;
     using value_type = T;
+    using deleter    = DelT;
 
     static constexpr int dimensions = K;
 
-    OwnSpan<T>         own_span = {};
-    std::array<int, K> sizes    = {};
-    std::array<int, K> strides  = {};
+    /// @brief Innermost stride granularity (in elements)
+    static constexpr int row_pad = RowAlign == 0 ? 1 : std::lcm(RowAlign, sizeof(T)) / sizeof(T);
+
+    OwnSpan<T, deleter> own_span = {};
+    std::array<int, K>  sizes    = {};
+    std::array<int, K>  strides  = {};
 
     constexpr MatrixKD() = default;
 
     template <std::integral... Ts>
     requires(sizeof...(Ts) == K)
     constexpr MatrixKD(T const& default_val, Ts... c_sizes)
-        : own_span{(c_sizes * ...), default_val}
+        : own_span{_n_elems({static_cast<int>(c_sizes)...}), default_val}
         , sizes{static_cast<int>(c_sizes)...}
-        , strides{static_cast<int>(c_sizes)...} {
+        , strides{_strides(sizes)} {
+    }
 
-        auto rbeg = strides.rbegin(), rend = strides.rend();
-        std::exclusive_scan(rbeg, rend, rbeg, 1, [](int x, int y) { return x * y; });
+    /// @brief Trivial element types only, the elements are left uninitialized
+    template <std::integral... Ts>
+    requires(sizeof...(Ts) == K)
+    constexpr MatrixKD(uninit_t tag, Ts... c_sizes)
+        : own_span{_n_elems({static_cast<int>(c_sizes)...}), tag}
+        , sizes{static_cast<int>(c_sizes)...}
+        , strides{_strides(sizes)} {
+    }
+
+    /// @brief Parallel first-touch initialization, partitioned along the first dimension (the
+    /// ft.grain is ignored): with a static schedule over mat[i], each thread finds its rows on its
+    /// own NUMA node.
+    template <std::integral... Ts>
+    requires(sizeof...(Ts) == K)
+    MatrixKD(first_touch ft, T const& default_val, Ts... c_sizes)
+        : own_span{_n_elems({static_cast<int>(c_sizes)...}),
+                   first_touch{ft.n_threads, _row_grain({static_cast<int>(c_sizes)...})},
+                   default_val}
+        , sizes{static_cast<int>(c_sizes)...}
+        , strides{_strides(sizes)} {
     }
 
     [[nodiscard]] constexpr int size() const noexcept {
         return sizes[0];
     }
 
+    [[nodiscard]] constexpr std::array<int, K> const& extents() const noexcept {
+        return sizes;
+    }
+
     [[nodiscard]] constexpr int stride() const noexcept {
         return strides[0];
     }
@@ -115,11 +152,97 @@ struct MatrixKD {
     [[nodiscard]] constexpr auto const& data_span() const {
         return own_span;
     }
+
+private:
+    [[nodiscard]] static constexpr std::array<int, K> _strides(std::array<int, K> szs) {
+        if constexpr (K > 1)
+            szs[K - 1] = (szs[K - 1] + row_pad - 1) / row_pad * row_pad;
+        auto rbeg = szs.rbegin(), rend = szs.rend();
+        std::exclusive_scan(rbeg, rend, rbeg, 1, [](int x, int y) { return x * y; });
+        return szs;
+    }
+
+    [[nodiscard]] static constexpr int _n_elems(std::array<int, K> const& szs) {
+        return szs[0] * _strides(szs)[0];
+    }
+
+    [[nodiscard]] static constexpr size_t _row_grain(std::array<int, K> const& szs) {
+        return max(static_cast<size_t>(_strides(szs)[0]), size_t{1});  // 0 with empty rows
+    }
 };
 
 template <typename T, typename... SzTs>
 MatrixKD(T, SzTs...) -> MatrixKD<cav::no_cvr<T>, sizeof...(SzTs)>;
 
+/// @brief Matrix with compile-time shape, e.g., FixedMatrixKD<int, 16, 16, 4>.
+/// Same mat[i][j] interface of MatrixKD (through SubMatrixKD), but sizes and strides are static
+/// constants, so the index arithmetic folds into immediate offsets and the element storage is
+/// inline (no allocation). Meant for the small tables of the inner loops.
+template <typename T, int... Szs>
+struct FixedMatrixKD {
+    using self       = FixedMatrixKD;
+    using value_type = T;
+
+    static constexpr int    dimensions = sizeof...(Szs);
+    static constexpr size_t n_elems    = (static_cast<size_t>(Szs) * ...);
+    static_assert(dimensions > 0 && ((Szs > 0) && ...), "Sizes must be positive");
+
+    static constexpr std::array<int, dimensions> sizes = {Szs...};
+
+    static constexpr std::array<int, dimensions> strides = [] {
+        auto strd = sizes;
+        auto rbeg = strd.rbegin(), rend = strd.rend();
+        std::exclusive_scan(rbeg, rend, rbeg, 1, [](int x, int y) { return x * y; });
+        return strd;
+    }();
+
+    std::array<T, n_elems> elems = {};
+
+    constexpr FixedMatrixKD() = default;
+
+    constexpr FixedMatrixKD(T const& default_val) {
+        elems.fill(default_val);
+    }
+
+    [[nodiscard]] static constexpr int size() noexcept {
+        return sizes[0];
+    }
+
+    [[nodiscard]] static constexpr std::array<int, dimensions> const& extents() noexcept {
+        return sizes;
+    }
+
+    [[nodiscard]] static constexpr int stride() noexcept {
+        return strides[0];
+    }
+
+    [[nodiscard]] constexpr decl_auto operator[](int i) {
+        assert(0 <= i && i < size());
+        return sub_object<dimensions - 1>(*this, i * stride());
+    }
+
+    [[nodiscard]] constexpr decl_auto operator[](int i) const {
+        assert(0 <= i && i < size());
+        return sub_object<dimensions - 1>(*this, i * stride());
+    }
+
+    [[nodiscard]] constexpr T* data() {
+        return elems.data();
+    }
+
+    [[nodiscard]] constexpr T const* data() const {
+        return elems.data();
+    }
+
+    [[nodiscard]] constexpr auto data_span() {
+        return std::span<T, n_elems>{elems};
+    }
+
+    [[nodiscard]] constexpr auto data_span() const {
+        return std::span<T const, n_elems>{elems};
+    }
+};
+
 template <typename MatT, int K>
 struct SubMatrixKD {
     static constexpr int sizes_idx = MatT::dimensions - K;
@@ -133,6 +256,13 @@ struct SubMatrixKD {
         return mat.sizes[sizes_idx];
     }
 
+    [[nodiscard]] constexpr std::array<int, K> extents() const noexcept {
+        auto ext = std::array<int, K>{};
+        for (int d = 0; d < K; ++d)
+            ext[d] = mat.sizes[sizes_idx + d];
+        return ext;
+    }
+
     [[nodiscard]] constexpr int stride() const noexcept {
         if constexpr (K == 1)  // small optimization
             return 1;
@@ -167,6 +297,62 @@ struct SubMatrixKD {
     }
 };
 
+/// @brief Visit the box [0, sizes) in tiles, in row-major tile order, calling fn(beg, end) with the
+/// half-open bounds of each tile (tiles on the far edges are clipped).
+template <size_t D>
+constexpr void for_each_tile(std::array<int, D> const& sizes,
+                             std::array<int, D> const& tile,
+                             auto&&                    fn) {
+    for (size_t d = 0; d < D; ++d) {
+        assert(tile[d] > 0);
+        if (sizes[d] <= 0)
+            return;
+    }
+
+    auto beg = std::array<int, D>{};
+    for (;;) {
+        auto end = std::array<int, D>{};
+        for (size_t d = 0; d < D; ++d)
+            end[d] = min(beg[d] + tile[d], sizes[d]);
+        fn(std::as_const(beg), std::as_const(end));
+
+        size_t d = D;
+        for (; d > 0; --d) {
+            beg[d - 1] += tile[d - 1];
+            if (beg[d - 1] < sizes[d - 1])
+                break;
+            beg[d - 1] = 0;
+        }
+        if (d == 0)
+            return;
+    }
+}
+
+/// @brief Call fn(i, j, ...) for every element index of mat (MatrixKD, FixedMatrixKD or
+/// SubMatrixKD), tile by tile: each tile is fully visited (row-major) before moving to the next.
+/// Tiles that fit in cache make stencils reuse the neighbouring rows, and tile rows that are
+/// multiples of a cache line (see MatrixKD RowAlign) can be split among threads safely.
+template <typename MatT, size_t D>
+constexpr void tiled_for_each(MatT const& mat, std::array<int, D> const& tile, auto&& fn) {
+    using ext_t = no_cvr<decltype(mat.extents())>;
+    static_assert(D == std::tuple_size_v<ext_t>, "One tile size per dimension");
+
+    for_each_tile(mat.extents(), tile, [&](auto const& beg, auto const& end) {
+        auto idx = beg;
+        for (;;) {
+            std::apply(fn, idx);
+            size_t d = D;
+            for (; d > 0; --d) {
+                if (++idx[d - 1] < end[d - 1])
+                    break;
+                idx[d - 1] = beg[d - 1];
+            }
+            if (d == 0)
+                return;
+        }
+    });
+}
+
 ///////////// TESTS ////////////////
 #ifdef CAV_COMP_TESTS
 namespace {
@@ -220,6 +406,57 @@ namespace {
                     assert(cmat[i][j][k] == i * cmat.stride() + j * cmat[i].stride() + k);
     });
 
+    CAV_PASS(sizeof(MatrixKD<int, 2, 64>) == 32);
+    CAV_PASS(MatrixKD<int, 2, 64>::row_pad == 16);
+
+    // first_touch spawns threads and cannot be constant evaluated: checked once at startup
+    [[maybe_unused]] inline bool const matrix_first_touch_tests = [] {
+        auto empty_rows = MatrixKD<int, 3>(first_touch{4}, 0, 3, 0, 2);  // zero strides
+        assert(empty_rows.data_span().empty() && empty_rows.size() == 3);
+        auto no_rows = MatrixKD<int, 2>(first_touch{4}, 0, 0, 5);
+        assert(no_rows.data_span().empty());
+        auto mat = MatrixKD<int, 2>(first_touch{3}, 7, 5, 4);
+        assert(mat.data_span().size() == 20 && mat[4][3] == 7);
+        return true;
+    }();
+
+    CAV_BLOCK_PASS({
+        auto mat = MatrixKD<int, 3, 64>{0, 2, 3, 5};
+        assert(mat.stride() == 48 && mat[0].stride() == 16);
+        assert(mat.data_span().size() == 96);
+
+        int count = 0;
+        tiled_for_each(mat, std::array{1, 2, 4}, [&](int i, int j, int k) {
+            mat[i][j][k] = i * 100 + j * 10 + k;
+            ++count;
+        });
+        assert(count == 30 && mat[1][2][4] == 124);
+
+        auto copy = mat;
+        int  sum  = 0;
+        tiled_for_each(copy[1], std::array{2, 2}, [&](int j, int k) { sum += copy[1][j][k]; });
+        assert(sum == 15 * 100 + 5 * 30 + 3 * 10);
+    });
+
+    CAV_PASS(sizeof(FixedMatrixKD<int, 2, 3, 4>) == 24 * sizeof(int));
+    CAV_PASS(FixedMatrixKD<int, 2, 3, 4>::strides == std::array{12, 4, 1});
+
+    CAV_BLOCK_PASS({
+        auto mat = FixedMatrixKD<int, 2, 3, 4>{0};
+        for (int c = 0; int& n : mat.data_span())
+            n = c++;
+
+        auto const& cmat = mat;
+        assert(cmat.size() == 2 && cmat.stride() == 12);
+        assert(cmat[0].size() == 3 && cmat[0].stride() == 4);
+        assert(cmat[0][0].size() == 4 && cmat[0][0].data_span().size() == 4);
+
+        for (int i = 0; i < cmat.size(); ++i)
+            for (int j = 0; j < cmat[i].size(); ++j)
+                for (int k = 0; k < cmat[i][j].size(); ++k)
+                    assert(cmat[i][j][k] == i * cmat.stride() + j * cmat[i].stride() + k);
+    });
+
     CAV_BLOCK_FAIL({
         auto const cmat     = MatrixKD<int, 3>{0, 2, 3, 4};
         int        tot_size = cmat.data_span().size();
@@ -0,0 +1,125 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_VECTORS_MMAPSPAN_HPP
+#define CAV_INCLUDE_VECTORS_MMAPSPAN_HPP
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "../mish/RaiiWrap.hpp"
+#include "OwnSpan.hpp"
+
+namespace cav {
+
+/// @brief Backing pages of the MmapDel anonymous mappings
+enum class page_mode {
+    normal,            // default pages
+    transparent_huge,  // madvise(MADV_HUGEPAGE), the kernel promotes to huge pages when it can
+    huge_tlb           // MAP_HUGETLB reserved huge pages, transparent_huge if none is available
+};
+
+/// @brief OwnSpan allocator/deleter pair backed by mmap. OwnSpan sized constructors get an
+/// anonymous zero-filled mapping (OwnSpan(n, uninit) leaves it untouched), the deleter munmaps
+/// (also the read-only file mappings of map_file). Mappings are rounded up to whole pages (huge
+/// pages for the huge modes).
+template <typename T, page_mode Mode = page_mode::transparent_huge>
+struct MmapDel {
+    static constexpr size_t huge_page_size = size_t{2} << 20U;
+
+    [[nodiscard]] static size_t map_bytes(size_t n) noexcept {
+        size_t page = Mode == page_mode::normal ? static_cast<size_t>(::sysconf(_SC_PAGESIZE))
+                                                : huge_page_size;
+        return (n * sizeof(T) + page - 1) / page * page;
+    }
+
+    [[nodiscard]] static T* allocate(size_t n) {
+        size_t bytes = map_bytes(n);
+        int    prot  = PROT_READ | PROT_WRITE;
+        int    flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void*  ptr   = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        if constexpr (Mode == page_mode::huge_tlb)
+            ptr = ::mmap(nullptr, bytes, prot, flags | MAP_HUGETLB, -1, 0);
+#endif
+        if (ptr == MAP_FAILED)
+            ptr = ::mmap(nullptr, bytes, prot, flags, -1, 0);
+        if (ptr == MAP_FAILED)
+            throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        if constexpr (Mode != page_mode::normal)
+            ::madvise(ptr, bytes, MADV_HUGEPAGE);  // only a hint, failures are fine
+#endif
+        return static_cast<T*>(ptr);
+    }
+
+    void operator()(T ptr[], size_t n) const noexcept {
+        std::destroy(ptr, ptr + n);
+        ::munmap(const_cast<void*>(static_cast<void const*>(ptr)), map_bytes(n));
+    }
+};
+
+/// @brief OwnSpan on an anonymous mapping, on transparent huge pages by default
+template <typename T, page_mode Mode = page_mode::transparent_huge>
+using MmapSpan = OwnSpan<T, MmapDel<T, Mode>>;
+
+/// @brief Read-only file mapping, see map_file
+template <typename T>
+using FileSpan = OwnSpan<T const, MmapDel<T const, page_mode::normal>>;
+
+/// @brief Zero-copy read-only view of a binary file of T (e.g., a precomputed table). The file
+/// size must be a multiple of sizeof(T). Throws std::system_error on failure.
+template <typename T>
+[[nodiscard]] FileSpan<T> map_file(std::string const& path) {
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be mapped");
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+    auto fd_guard = RaiiWrap{fd, [](int f) { ::close(f); }};
+
+    struct stat st = {};
+    if (::fstat(fd, &st) != 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot stat " + path);
+
+    auto bytes = static_cast<size_t>(st.st_size);
+    if (bytes % sizeof(T) != 0)
+        throw std::system_error(std::make_error_code(std::errc::invalid_argument),
+                                path + " size is not a multiple of the element size");
+    if (bytes == 0)
+        return FileSpan<T>{};
+
+    void* ptr = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "Cannot map " + path);
+    return FileSpan<T>{static_cast<T const*>(ptr), bytes / sizeof(T)};
+}
+
+}  // namespace cav
+
+#endif
+
+#endif /* CAV_INCLUDE_VECTORS_MMAPSPAN_HPP */
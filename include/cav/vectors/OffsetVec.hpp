@@ -16,13 +16,20 @@
 #ifndef CAV_INCLUDE_UTILS_OFFSETVEC_HPP
 #define CAV_INCLUDE_UTILS_OFFSETVEC_HPP
 
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "../comptime/mp_base.hpp"
 #include "../comptime/test.hpp"
+#include "../mish/AllocStats.hpp"
 #include "cav/mish/util_functions.hpp"
 
 namespace cav {
@@ -35,8 +42,10 @@ namespace cav {
 /// uses a simple union type that defers initialization, making it transparent to std::vector and
 /// compatible with non-default constructible types.
 /// A union is preferred over reinterpret_cast to enable usage in C++20 constexpr context.
-///
-/// TODO(cava): atm iterators rely on implicit conversion, I should implement a custom iterator type
+/// The iterators are contiguous (std::to_address gives a T*), data()/data_span() give direct
+/// access to [begin(), end()) for algorithms that only special-case raw pointers (memmove copies).
+/// Note that operator[] is relative to mid(): index-based algorithms that loop over
+/// [0, size()) (e.g., Sorter) must be given data_span(), not the OffsetVec itself.
 template <typename T, typename AllocT = std::allocator<T>>
 class OffsetVec {
 
@@ -65,13 +74,107 @@ class OffsetVec {
         }
     };
 
+    static_assert(sizeof(maybe_uninit_wrap) == sizeof(T) &&
+                      alignof(maybe_uninit_wrap) == alignof(T),
+                  "The wrapped values must be laid out as a T array");
+
+    /// @brief Random access iterator over the values of a maybe_uninit_wrap array, WrapT is
+    /// maybe_uninit_wrap or maybe_uninit_wrap const
+    template <typename WrapT>
+    class contig_iter {
+        WrapT* wp = nullptr;
+
+        template <typename>
+        friend class contig_iter;
+
+    public:
+        using iterator_concept  = std::contiguous_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = T;
+        using element_type      = std::conditional_t<std::is_const_v<WrapT>, T const, T>;
+        using difference_type   = ptrdiff_t;
+        using pointer           = element_type*;
+        using reference         = element_type&;
+
+        constexpr contig_iter() = default;
+
+        explicit constexpr contig_iter(WrapT* c_wp)
+            : wp(c_wp) {
+        }
+
+        [[nodiscard]] constexpr operator contig_iter<WrapT const>() const {
+            return contig_iter<WrapT const>(wp);
+        }
+
+        [[nodiscard]] constexpr reference operator*() const {
+            return wp->value;
+        }
+
+        [[nodiscard]] constexpr pointer operator->() const {
+            return std::addressof(wp->value);
+        }
+
+        [[nodiscard]] constexpr reference operator[](difference_type n) const {
+            return wp[n].value;
+        }
+
+        constexpr contig_iter& operator++() {
+            ++wp;
+            return *this;
+        }
+
+        constexpr contig_iter operator++(int) {
+            return contig_iter(wp++);
+        }
+
+        constexpr contig_iter& operator--() {
+            --wp;
+            return *this;
+        }
+
+        constexpr contig_iter operator--(int) {
+            return contig_iter(wp--);
+        }
+
+        constexpr contig_iter& operator+=(difference_type n) {
+            wp += n;
+            return *this;
+        }
+
+        constexpr contig_iter& operator-=(difference_type n) {
+            wp -= n;
+            return *this;
+        }
+
+        [[nodiscard]] friend constexpr contig_iter operator+(contig_iter it, difference_type n) {
+            return contig_iter(it.wp + n);
+        }
+
+        [[nodiscard]] friend constexpr contig_iter operator+(difference_type n, contig_iter it) {
+            return contig_iter(it.wp + n);
+        }
+
+        [[nodiscard]] friend constexpr contig_iter operator-(contig_iter it, difference_type n) {
+            return contig_iter(it.wp - n);
+        }
+
+        [[nodiscard]] friend constexpr difference_type operator-(contig_iter it1, contig_iter it2) {
+            return it1.wp - it2.wp;
+        }
+
+        [[nodiscard]] friend constexpr bool operator==(contig_iter, contig_iter) = default;
+        [[nodiscard]] friend constexpr auto operator<=>(contig_iter, contig_iter) = default;
+    };
+
     using value_type          = T;
-    using real_allocator_type = typename std::allocator_traits<AllocT>::template rebind_alloc<
-        maybe_uninit_wrap>;
+    using real_allocator_type = alloc_stats_allocator_t<
+        typename std::allocator_traits<AllocT>::template rebind_alloc<maybe_uninit_wrap>,
+        OffsetVec>;
 
     using container_type  = std::vector<maybe_uninit_wrap, real_allocator_type>;
-    using iterator        = typename container_type::iterator;
-    using const_iterator  = typename container_type::const_iterator;
+    using vec_iterator    = typename container_type::iterator;
+    using iterator        = contig_iter<maybe_uninit_wrap>;
+    using const_iterator  = contig_iter<maybe_uninit_wrap const>;
     using reference       = T&;
     using const_reference = T const&;
     using pointer         = T*;
@@ -81,8 +184,8 @@ class OffsetVec {
     using allocator_type  = typename container_type::allocator_type;
 
     container_type vec       = {};
-    iterator       offset_it = {};
-    iterator       beg_it    = {};
+    vec_iterator   offset_it = {};
+    vec_iterator   beg_it    = {};
 
 public:
     constexpr OffsetVec()                                = default;
@@ -120,7 +223,7 @@ public:
 
     constexpr ~OffsetVec() {
         for (auto& elem : *this)
-            std::destroy_at(std::addressof(elem.value));
+            std::destroy_at(std::addressof(elem));
     }
 
     [[nodiscard]] constexpr size_type get_offset() const {
@@ -161,27 +264,46 @@ public:
     }
 
     [[nodiscard]] constexpr iterator begin() {
-        return beg_it;
+        return iterator(std::to_address(beg_it));
     }
 
     [[nodiscard]] constexpr const_iterator begin() const {
-        return beg_it;
+        return const_iterator(std::to_address(beg_it));
     }
 
     [[nodiscard]] constexpr iterator mid() {
-        return offset_it;
+        return iterator(std::to_address(offset_it));
     }
 
     [[nodiscard]] constexpr const_iterator mid() const {
-        return offset_it;
+        return const_iterator(std::to_address(offset_it));
     }
 
     [[nodiscard]] constexpr iterator end() {
-        return vec.end();
+        return iterator(vec.data() + vec.size());
     }
 
     [[nodiscard]] constexpr const_iterator end() const {
-        return vec.end();
+        return const_iterator(vec.data() + vec.size());
+    }
+
+    /// @brief Pointer to front() (null if empty), [data(), data() + size()) are the elements.
+    /// Outside constant evaluation only: for constexpr the wraps are not a T array.
+    [[nodiscard]] constexpr pointer data() noexcept {
+        return empty() ? nullptr : std::addressof(beg_it->value);
+    }
+
+    [[nodiscard]] constexpr const_pointer data() const noexcept {
+        return empty() ? nullptr : std::addressof(beg_it->value);
+    }
+
+    /// @brief [begin(), end()) as a span indexed from 0 (the route to Sorter & co.)
+    [[nodiscard]] constexpr std::span<T> data_span() noexcept {
+        return {data(), static_cast<size_t>(size())};
+    }
+
+    [[nodiscard]] constexpr std::span<T const> data_span() const noexcept {
+        return {data(), static_cast<size_t>(size())};
     }
 
     [[nodiscard]] constexpr size_type size() const {
@@ -212,7 +334,10 @@ public:
     constexpr void make_space_front(size_type n) {
         if (n > front_space()) {
             size_type offset = get_offset(), beg_offset = n - front_space();
+            size_t    old_cap = vec.capacity();
             vec.insert(vec.begin(), beg_offset, maybe_uninit_wrap{maybe_uninit_wrap::uninit_value});
+            if (old_cap > 0 && vec.capacity() != old_cap)
+                CAV_ALLOC_RECORD(OffsetVec, on_grow);
             beg_it    = vec.begin() + beg_offset;
             offset_it = beg_it + offset;
         }
@@ -230,12 +355,12 @@ public:
     constexpr void push_front(auto&& arg) {
         if (!std::is_constant_evaluated() && vec.capacity() > 0)  // alias check
             assert(std::less<>{}(&arg, &beg_it->value) ||
-                   std::greater_equal{}(&arg, &end()->value));
+                   std::greater_equal{}(&arg, std::to_address(end())));
         emplace_front(FWD(arg));
     }
 
     constexpr void pop_front() {
-        std::destroy_at(&beg_it->val);
+        std::destroy_at(&beg_it->value);
         ++beg_it;
     }
 
@@ -247,6 +372,8 @@ public:
     constexpr void make_space_back(size_type n) {
         if (n > back_space()) {
             size_type offset = get_offset(), beg_offset = front_space();
+            if (vec.capacity() > 0)
+                CAV_ALLOC_RECORD(OffsetVec, on_grow);
             vec.reserve(vec.size() + n);
             beg_it    = vec.begin() + beg_offset;
             offset_it = beg_it + offset;
@@ -262,7 +389,7 @@ public:
     constexpr void push_back(auto&& arg) {
         if (!std::is_constant_evaluated() && vec.capacity() > 0)  // alias check
             assert(std::less<>{}(&arg, &beg_it->value) ||
-                   std::greater_equal{}(&arg, &end()->value));
+                   std::greater_equal{}(&arg, std::to_address(end())));
         emplace_back(FWD(arg));
     }
 
@@ -270,11 +397,313 @@ public:
         vec.pop_back();
     }
 };
+
+/// @brief RingOffsetVec: OffsetVec alternative stored in a circular buffer with power-of-two
+/// capacity and masked indexing. Same offset semantics (negative indexes, an element keeps its
+/// index when the other end grows or shrinks), but push/pop at both ends never move elements, and
+/// growth only happens when the buffer is full (a sliding window never allocates).
+template <typename T, typename AllocT = std::allocator<T>>
+class RingOffsetVec : AllocT {
+    using alloc_traits = std::allocator_traits<AllocT>;
+
+public:
+    using value_type      = T;
+    using reference       = T&;
+    using const_reference = T const&;
+    using size_type       = ptrdiff_t;
+    using difference_type = ptrdiff_t;
+    using allocator_type  = AllocT;
+
+    template <typename Q>
+    struct ring_iter {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type        = std::remove_const_t<Q>;
+        using difference_type   = ptrdiff_t;
+        using pointer           = Q*;
+        using reference         = Q&;
+
+        Q*     buff = nullptr;
+        size_t mask = 0;
+        size_t pos  = 0;  // unmasked, so that end() != begin() on a full buffer
+
+        [[nodiscard]] constexpr operator ring_iter<Q const>() const {
+            return {buff, mask, pos};
+        }
+
+        [[nodiscard]] constexpr Q& operator*() const {
+            return buff[pos & mask];
+        }
+
+        [[nodiscard]] constexpr Q* operator->() const {
+            return buff + (pos & mask);
+        }
+
+        constexpr ring_iter& operator++() {
+            ++pos;
+            return *this;
+        }
+
+        constexpr ring_iter operator++(int) {
+            return {buff, mask, pos++};
+        }
+
+        constexpr ring_iter& operator--() {
+            --pos;
+            return *this;
+        }
+
+        constexpr ring_iter operator--(int) {
+            return {buff, mask, pos--};
+        }
+
+        [[nodiscard]] constexpr difference_type operator-(ring_iter const& other) const {
+            return static_cast<difference_type>(pos - other.pos);
+        }
+
+        [[nodiscard]] constexpr bool operator==(ring_iter const& other) const {
+            return pos == other.pos;
+        }
+    };
+
+    using iterator       = ring_iter<T>;
+    using const_iterator = ring_iter<T const>;
+
+private:
+    T*              buff     = nullptr;
+    size_t          cap      = 0;  // zero or a power of two
+    size_t          head     = 0;  // physical position of the front (unmasked)
+    size_type       sz       = 0;
+    difference_type front_ix = 0;  // index of the front element (beg_idx)
+
+public:
+    constexpr RingOffsetVec() = default;
+
+    explicit constexpr RingOffsetVec(AllocT const& alc)
+        : AllocT(alc) {
+    }
+
+    /// @brief n copies of val, with val[0] at position c_offset (as OffsetVec(c_offset, n, val))
+    constexpr RingOffsetVec(size_type c_offset, size_type n, T const& val = {})
+        : front_ix(-c_offset) {
+        assert(0 <= c_offset && c_offset < n);
+        reserve(n);
+        for (size_type i = 0; i < n; ++i)
+            emplace_back(val);
+    }
+
+    constexpr RingOffsetVec(size_type c_offset, std::initializer_list<T> l)
+        : front_ix(-c_offset) {
+        assert(0 <= c_offset && c_offset < static_cast<size_type>(l.size()));
+        reserve(static_cast<size_type>(l.size()));
+        for (auto const& val : l)
+            emplace_back(val);
+    }
+
+    constexpr RingOffsetVec(RingOffsetVec const& other)
+        : AllocT(alloc_traits::select_on_container_copy_construction(other))
+        , front_ix(other.front_ix) {
+        reserve(other.sz);
+        for (auto const& val : other)
+            emplace_back(val);
+    }
+
+    constexpr RingOffsetVec(RingOffsetVec&& other) noexcept
+        : AllocT(std::move(static_cast<AllocT&>(other)))
+        , buff(std::exchange(other.buff, nullptr))
+        , cap(std::exchange(other.cap, 0))
+        , head(std::exchange(other.head, 0))
+        , sz(std::exchange(other.sz, 0))
+        , front_ix(std::exchange(other.front_ix, 0)) {
+    }
+
+    constexpr RingOffsetVec& operator=(RingOffsetVec other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    constexpr ~RingOffsetVec() {
+        clear();
+        if (buff != nullptr) {
+            CAV_ALLOC_RECORD(RingOffsetVec, on_free, cap * sizeof(T));
+            alloc_traits::deallocate(*this, buff, cap);
+        }
+    }
+
+    constexpr void swap(RingOffsetVec& other) noexcept {
+        std::swap(static_cast<AllocT&>(*this), static_cast<AllocT&>(other));
+        std::swap(buff, other.buff);
+        std::swap(cap, other.cap);
+        std::swap(head, other.head);
+        std::swap(sz, other.sz);
+        std::swap(front_ix, other.front_ix);
+    }
+
+    [[nodiscard]] constexpr size_type get_offset() const {
+        return -front_ix;
+    }
+
+    constexpr size_type set_offset(size_type new_offset) {
+        assert(new_offset < size());
+        size_type old_offset = get_offset();
+        front_ix             = -new_offset;
+        return new_offset - old_offset;
+    }
+
+    [[nodiscard]] constexpr reference operator[](difference_type n) {
+        assert(beg_idx() <= n && n < end_idx());
+        return buff[(head + static_cast<size_t>(n - front_ix)) & (cap - 1)];
+    }
+
+    [[nodiscard]] constexpr const_reference operator[](difference_type n) const {
+        assert(beg_idx() <= n && n < end_idx());
+        return buff[(head + static_cast<size_t>(n - front_ix)) & (cap - 1)];
+    }
+
+    [[nodiscard]] constexpr reference front() {
+        return (*this)[beg_idx()];
+    }
+
+    [[nodiscard]] constexpr const_reference front() const {
+        return (*this)[beg_idx()];
+    }
+
+    [[nodiscard]] constexpr reference back() {
+        return (*this)[end_idx() - 1];
+    }
+
+    [[nodiscard]] constexpr const_reference back() const {
+        return (*this)[end_idx() - 1];
+    }
+
+    [[nodiscard]] constexpr iterator begin() {
+        return {buff, cap - 1, head};
+    }
+
+    [[nodiscard]] constexpr const_iterator begin() const {
+        return {buff, cap - 1, head};
+    }
+
+    [[nodiscard]] constexpr iterator end() {
+        return {buff, cap - 1, head + static_cast<size_t>(sz)};
+    }
+
+    [[nodiscard]] constexpr const_iterator end() const {
+        return {buff, cap - 1, head + static_cast<size_t>(sz)};
+    }
+
+    [[nodiscard]] constexpr size_type size() const {
+        return sz;
+    }
+
+    [[nodiscard]] constexpr bool empty() const {
+        return sz == 0;
+    }
+
+    [[nodiscard]] constexpr difference_type beg_idx() const {
+        return front_ix;
+    }
+
+    [[nodiscard]] constexpr difference_type end_idx() const {
+        return front_ix + sz;
+    }
+
+    [[nodiscard]] constexpr size_type capacity() const {
+        return static_cast<size_type>(cap);
+    }
+
+    /// @brief Grow the capacity to the next power of two >= n (elements keep their indexes)
+    constexpr void reserve(size_type n) {
+        if (static_cast<size_t>(n) <= cap)
+            return;
+
+        size_t new_cap  = std::bit_ceil(static_cast<size_t>(n));
+        T*     new_buff = alloc_traits::allocate(*this, new_cap);
+        CAV_ALLOC_RECORD(RingOffsetVec, on_alloc, new_cap * sizeof(T));
+        for (size_type i = 0; i < sz; ++i) {
+            T& old = buff[(head + static_cast<size_t>(i)) & (cap - 1)];
+            std::construct_at(new_buff + i, std::move(old));
+            std::destroy_at(std::addressof(old));
+        }
+        if (buff != nullptr) {
+            CAV_ALLOC_RECORD(RingOffsetVec, on_grow);
+            CAV_ALLOC_RECORD(RingOffsetVec, on_free, cap * sizeof(T));
+            alloc_traits::deallocate(*this, buff, cap);
+        }
+        buff = new_buff;
+        cap  = new_cap;
+        head = 0;
+    }
+
+    constexpr reference emplace_front(auto&&... args) {
+        if (static_cast<size_t>(sz) == cap) {  // args may alias an element, build it first
+            auto tmp = T(FWD(args)...);
+            reserve(cav::max(size_type{8}, sz * 2));
+            return _construct_front(std::move(tmp));
+        }
+        return _construct_front(FWD(args)...);
+    }
+
+    constexpr void push_front(auto&& arg) {
+        emplace_front(FWD(arg));
+    }
+
+    constexpr void pop_front() {
+        assert(!empty());
+        std::destroy_at(std::addressof(front()));
+        ++head;
+        ++front_ix;
+        --sz;
+    }
+
+    constexpr reference emplace_back(auto&&... args) {
+        if (static_cast<size_t>(sz) == cap) {  // args may alias an element, build it first
+            auto tmp = T(FWD(args)...);
+            reserve(cav::max(size_type{8}, sz * 2));
+            return _construct_back(std::move(tmp));
+        }
+        return _construct_back(FWD(args)...);
+    }
+
+    constexpr void push_back(auto&& arg) {
+        emplace_back(FWD(arg));
+    }
+
+    constexpr void pop_back() {
+        assert(!empty());
+        std::destroy_at(std::addressof(back()));
+        --sz;
+    }
+
+    /// @brief Destroy all the elements, beg_idx() is kept
+    constexpr void clear() {
+        for (auto& val : *this)
+            std::destroy_at(std::addressof(val));
+        sz = 0;
+    }
+
+private:
+    constexpr reference _construct_front(auto&&... args) {
+        T* slot = buff + ((head - 1) & (cap - 1));
+        std::construct_at(slot, FWD(args)...);
+        --head;
+        --front_ix;
+        ++sz;
+        return *slot;
+    }
+
+    constexpr reference _construct_back(auto&&... args) {
+        T* slot = buff + ((head + static_cast<size_t>(sz)) & (cap - 1));
+        std::construct_at(slot, FWD(args)...);
+        ++sz;
+        return *slot;
+    }
+};
 }  // namespace cav
 
 namespace cav {
 
 #ifdef CAV_COMP_TESTS
+#include <algorithm>
 
 namespace {
 
@@ -301,6 +730,30 @@ namespace {
     CAV_FAIL(CAV_TEST_OFFVEC_3_8[5] == 7);  // OOB
 #undef CAV_TEST_OFFVEC_3_8
 
+    CAV_PASS(std::contiguous_iterator<decltype(std::declval<OffsetVec<int>&>().begin())>);
+    CAV_PASS(std::contiguous_iterator<decltype(std::declval<OffsetVec<int> const&>().begin())>);
+
+    CAV_BLOCK_PASS({
+        auto ovec = OffsetVec<int>(0, {1, 2, 3});
+        ovec.push_front(0);
+        assert(ovec.get_offset() > 0);
+        assert(std::to_address(ovec.begin()) == ovec.data() && ovec.data() == &ovec.front());
+        assert(std::to_address(ovec.end() - 1) == &ovec.back());
+        assert(ovec.data_span().size() == 4 && &ovec.data_span().front() == &ovec.front());
+    });
+
+    // Pointer arithmetic over the wraps is not a constant expression: checked once at startup
+    [[maybe_unused]] inline bool const offvec_span_tests = [] {
+        auto ovec = OffsetVec<int>(0, {5, 3, 4});
+        ovec.push_front(9);
+        ovec.push_front(1);
+        auto span = ovec.data_span();
+        assert(&span.front() == &ovec.front() && &span.back() == &ovec.back());
+        std::ranges::sort(span);
+        assert(std::ranges::is_sorted(ovec) && ovec.front() == 1 && ovec.back() == 9);
+        return true;
+    }();
+
 
     CAV_BLOCK_PASS({
         auto ovec = OffsetVec<bool>(2, 7);
@@ -389,6 +842,26 @@ namespace {
         assert(ovec[3] == true);
     });
 
+    CAV_BLOCK_PASS({
+        auto ring = RingOffsetVec<int>(3, {0, 1, 2, 3, 4, 5, 6, 7});
+        assert(ring.beg_idx() == -3 && ring.end_idx() == 5 && ring.capacity() == 8);
+        assert(ring[-3] == 0 && ring[0] == 3 && ring[4] == 7);
+
+        // Sliding window: indexes are kept and the buffer is reused
+        for (int i = 0; i < 20; ++i) {
+            ring.pop_front();
+            ring.push_back(ring.back() + 1);
+        }
+        assert(ring.capacity() == 8 && ring.beg_idx() == 17 && ring[17] == 20 && ring[24] == 27);
+
+        ring.push_front(-1);  // full: grows to 16
+        assert(ring.capacity() == 16 && ring[16] == -1 && ring[24] == 27);
+
+        auto copy = ring;
+        copy.pop_back();
+        assert(copy.size() == 8 && copy.back() == 26 && ring.back() == 27);
+    });
+
 }  // namespace
 #endif
 
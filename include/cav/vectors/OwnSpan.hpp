@@ -16,15 +16,22 @@
 #ifndef CAV_BOUND_OWNSPAN_HPP
 #define CAV_BOUND_OWNSPAN_HPP
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <concepts>
 #include <cstddef>
 #include <memory>
+#include <new>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "../comptime/mp_base.hpp"
 #include "../comptime/syntactic_sugars.hpp"
 #include "../comptime/test.hpp"
+#include "../mish/AllocStats.hpp"
 
 namespace cav {
 
@@ -43,6 +50,51 @@ struct AllocatorDel {
     }
 };
 
+/// @brief Over-aligned allocation (e.g., cache-line or SIMD alignment). Deleters providing a static
+/// allocate(n) are also used by OwnSpan to allocate (sized constructors and copies).
+template <typename T, size_t Align>
+struct AlignedDel {
+    static_assert(std::has_single_bit(Align) && Align >= alignof(T), "Invalid alignment");
+
+    [[nodiscard]] static constexpr T* allocate(size_t n) {
+        if (std::is_constant_evaluated())
+            return std::allocator<T>{}.allocate(n);
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Align}));
+    }
+
+    constexpr void operator()(T ptr[], size_t n) const noexcept {
+        std::destroy(ptr, ptr + n);
+        if (std::is_constant_evaluated())
+            std::allocator<T>{}.deallocate(ptr, n);
+        else
+            ::operator delete(ptr, std::align_val_t{Align});
+    }
+};
+
+/// @brief Construction tag: allocate only, trivially default constructible elements are left
+/// uninitialized (and no page of a fresh allocation is touched).
+struct uninit_t {
+    explicit uninit_t() = default;
+};
+
+inline constexpr uninit_t uninit{};
+
+/// @brief Construction tag: parallel first-touch initialization. Thread t constructs the elements
+/// of the t-th static_chunk (in units of grain elements), so with first-touch NUMA policies the
+/// pages end up on the node of the thread that later processes the same chunk.
+struct first_touch {
+    size_t n_threads = 1;
+    size_t grain     = 1;
+};
+
+/// @brief Static partition of [0, n) in n_threads contiguous chunks, the t-th is returned
+[[nodiscard]] constexpr std::pair<size_t, size_t> static_chunk(size_t n,
+                                                               size_t n_threads,
+                                                               size_t t) noexcept {
+    assert(t < n_threads);
+    return {t * n / n_threads, (t + 1) * n / n_threads};
+}
+
 /// @brief Like std::span but it owns the underlying pointer and frees the memory on destruction.
 ///  Uses-defined template-deduction-guides are used to automatically selected ArrayDel (i.e.,
 ///  delete[]) when the span is init with a pointer to T.
@@ -102,21 +154,57 @@ public:
             std::construct_at(&val, args...);
     }
 
+    constexpr OwnSpan(std::integral auto c_size, uninit_t /*tag*/)
+    requires std::is_trivially_default_constructible_v<T>
+        : ptr(c_size > 0 ? _default_allocate(c_size) : nullptr)
+        , sz(c_size) {
+        assert(c_size >= 0);
+        if (std::is_constant_evaluated())  // lifetimes must be started explicitly
+            for (T& val : *this)
+                std::construct_at(&val);
+    }
+
+    template <typename... Ts>
+    OwnSpan(std::integral auto c_size, first_touch ft, Ts const&... args)
+        : ptr(c_size > 0 ? _default_allocate(c_size) : nullptr)
+        , sz(c_size) {
+        assert(c_size >= 0 && ft.n_threads > 0);
+        if (sz == 0)
+            return;
+
+        assert(ft.grain > 0);
+        size_t n_units = (sz + ft.grain - 1) / ft.grain;
+        auto   worker  = [&](size_t t) {
+            auto [beg, end] = static_chunk(n_units, ft.n_threads, t);
+            for (size_t i = beg * ft.grain; i < std::min(end * ft.grain, sz); ++i)
+                std::construct_at(ptr + i, args...);
+        };
+
+        auto threads = std::vector<std::jthread>();
+        threads.reserve(ft.n_threads - 1);
+        for (size_t t = 1; t < ft.n_threads; ++t)
+            threads.emplace_back(worker, t);
+        worker(0);
+    }
+
     constexpr OwnSpan(T* c_ptr, std::integral auto c_size, Deleter const& c_del)
         : ptr(c_size > 0 ? c_ptr : nullptr)
         , sz(c_size)
         , del(c_del) {
+        _record_adopted();
     }
 
     constexpr OwnSpan(T* c_ptr, std::integral auto c_size, Deleter&& c_del)
         : ptr(c_size > 0 ? c_ptr : nullptr)
         , sz(c_size)
         , del(std::move(c_del)) {
+        _record_adopted();
     }
 
     constexpr OwnSpan(T* c_ptr, std::integral auto c_size)
         : ptr(c_size > 0 ? c_ptr : nullptr)
         , sz(c_size) {
+        _record_adopted();
     }
 
     constexpr OwnSpan(OwnSpan const& other)
@@ -128,7 +216,8 @@ public:
 
     constexpr OwnSpan(OwnSpan&& other) noexcept
         : ptr(other.ptr)
-        , sz(other.sz) {
+        , sz(other.sz)
+        , del(std::move(other.del)) {  // stateful deleters (e.g., file mappings) follow the memory
         other.ptr = nullptr;
         other.sz  = 0;
     }
@@ -159,6 +248,7 @@ public:
         _free();
         std::swap(ptr, other.ptr);
         std::swap(sz, other.sz);
+        std::swap(del, other.del);
         return *this;
     }
 
@@ -243,16 +333,28 @@ public:
 
 private:
     constexpr auto* _default_allocate(size_t n) {
-        return std::allocator<no_cvr<T>>{}.allocate(n);
+        CAV_ALLOC_RECORD(self, on_alloc, n * sizeof(T));
+        if constexpr (requires { Deleter::allocate(n); })
+            return Deleter::allocate(n);
+        else
+            return std::allocator<no_cvr<T>>{}.allocate(n);
     }
 
     constexpr void _free() {
-        if (ptr != nullptr)
+        if (ptr != nullptr) {
+            CAV_ALLOC_RECORD(self, on_free, sz * sizeof(T));
             del(ptr, sz);
+        }
         ptr = nullptr;
         sz  = 0;
     }
 
+    /// @brief External memory released by del from now on counts as allocated by this container
+    constexpr void _record_adopted() {
+        if (ptr != nullptr)
+            CAV_ALLOC_RECORD(self, on_alloc, sz * sizeof(T));
+    }
+
     T*                            ptr = {};
     size_t                        sz  = {};
     [[no_unique_address]] Deleter del = {};
@@ -306,6 +408,13 @@ namespace {
         assert(span2[0] != span2[2]);
     });
 
+    CAV_BLOCK_PASS({
+        auto raw = OwnSpan<int>(4, uninit);
+        for (int i = 0; i < 4; ++i)
+            raw[i] = i;
+        assert(raw.size() == 4 && raw.back() == 3);
+    });
+
     // Test with non default constructible type
     CAV_PASS(OwnSpan<value_wrap<bool>>(1, [](auto& me) {
                  for (auto& s : me)
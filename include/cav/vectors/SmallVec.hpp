@@ -0,0 +1,344 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_UTILS_SMALLVEC_HPP
+#define CAV_INCLUDE_UTILS_SMALLVEC_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "../comptime/syntactic_sugars.hpp"
+#include "../comptime/test.hpp"
+#include "../mish/util_functions.hpp"
+
+namespace cav {
+
+/// @brief Small-buffer-optimized vector: the first N elements live inline (as in GrowArray, but
+/// without the hard limit), beyond that the elements spill transparently to a geometrically grown
+/// heap buffer obtained from AllocT (a std::pmr allocator makes it an arena). The inline storage is
+/// an uninitialized union, so only the live elements are constructed.
+///
+/// @tparam T value type
+/// @tparam N inline capacity
+template <typename T, int N, typename AllocT = std::allocator<T>>
+class SmallVec : AllocT {
+    static_assert(N > 0, "Inline capacity must be positive");
+    using alloc_traits = std::allocator_traits<AllocT>;
+
+public:
+    using value_type      = T;
+    using reference       = T&;
+    using const_reference = T const&;
+    using pointer         = T*;
+    using const_pointer   = T const*;
+    using iterator        = T*;
+    using const_iterator  = T const*;
+    using size_type       = size_t;
+    using difference_type = ptrdiff_t;
+    using allocator_type  = AllocT;
+
+private:
+    union inline_storage {
+        T elems[N];
+
+        constexpr inline_storage() {
+        }
+
+        constexpr ~inline_storage() {
+        }
+    };
+
+    T*             ptr = small.elems;
+    uint32_t       sz  = 0;
+    uint32_t       cap = N;
+    inline_storage small;
+
+public:
+    constexpr SmallVec() = default;
+
+    explicit constexpr SmallVec(AllocT const& alc)
+        : AllocT(alc) {
+    }
+
+    constexpr SmallVec(size_type n, T const& val = {}, AllocT const& alc = {})
+        : AllocT(alc) {
+        resize(n, val);
+    }
+
+    constexpr SmallVec(std::initializer_list<T> l, AllocT const& alc = {})
+        : SmallVec(l.begin(), l.end(), alc) {
+    }
+
+    constexpr SmallVec(std::input_iterator auto first,
+                       std::input_iterator auto last,
+                       AllocT const&            alc = {})
+        : AllocT(alc) {
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    constexpr SmallVec(SmallVec const& other)
+        : AllocT(alloc_traits::select_on_container_copy_construction(other)) {
+        reserve(other.size());
+        for (T const& val : other)
+            std::construct_at(ptr + sz++, val);
+    }
+
+    constexpr SmallVec(SmallVec&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : AllocT(std::move(static_cast<AllocT&>(other))) {
+        _steal(other);
+    }
+
+    constexpr SmallVec& operator=(SmallVec const& other) {
+        if (this == &other)
+            return *this;
+        clear();
+        reserve(other.size());
+        for (T const& val : other)
+            std::construct_at(ptr + sz++, val);
+        return *this;
+    }
+
+    /// @brief Throws only when the allocators differ (the elements are moved into a new buffer)
+    constexpr SmallVec& operator=(SmallVec&& other) noexcept(
+        std::is_nothrow_move_constructible_v<T> && alloc_traits::is_always_equal::value) {
+        if (this == &other)
+            return *this;
+        clear();
+        if (other.is_inline() || static_cast<AllocT&>(*this) == static_cast<AllocT&>(other)) {
+            _free_heap();
+            _steal(other);
+        } else {  // different arenas: move element-wise into our own buffer
+            reserve(other.size());
+            for (T& val : other)
+                std::construct_at(ptr + sz++, std::move(val));
+            other.clear();
+        }
+        return *this;
+    }
+
+    constexpr ~SmallVec() {
+        clear();
+        _free_heap();
+    }
+
+    // Element access
+    [[nodiscard]] constexpr reference operator[](size_type i) {
+        assert(i < size());
+        return ptr[i];
+    }
+
+    [[nodiscard]] constexpr const_reference operator[](size_type i) const {
+        assert(i < size());
+        return ptr[i];
+    }
+
+    [[nodiscard]] constexpr reference front() {
+        assert(!empty());
+        return ptr[0];
+    }
+
+    [[nodiscard]] constexpr const_reference front() const {
+        assert(!empty());
+        return ptr[0];
+    }
+
+    [[nodiscard]] constexpr reference back() {
+        assert(!empty());
+        return ptr[sz - 1];
+    }
+
+    [[nodiscard]] constexpr const_reference back() const {
+        assert(!empty());
+        return ptr[sz - 1];
+    }
+
+    [[nodiscard]] constexpr T* data() {
+        return ptr;
+    }
+
+    [[nodiscard]] constexpr T const* data() const {
+        return ptr;
+    }
+
+    // Iterators
+    [[nodiscard]] constexpr iterator begin() {
+        return ptr;
+    }
+
+    [[nodiscard]] constexpr const_iterator begin() const {
+        return ptr;
+    }
+
+    [[nodiscard]] constexpr iterator end() {
+        return ptr + sz;
+    }
+
+    [[nodiscard]] constexpr const_iterator end() const {
+        return ptr + sz;
+    }
+
+    // Capacity
+    [[nodiscard]] constexpr bool empty() const {
+        return sz == 0;
+    }
+
+    [[nodiscard]] constexpr size_type size() const {
+        return sz;
+    }
+
+    [[nodiscard]] constexpr size_type capacity() const {
+        return cap;
+    }
+
+    [[nodiscard]] static constexpr size_type inline_capacity() {
+        return N;
+    }
+
+    /// @brief True if the elements are stored in the inline buffer
+    [[nodiscard]] constexpr bool is_inline() const {
+        return ptr == small.elems;
+    }
+
+    [[nodiscard]] constexpr allocator_type get_allocator() const {
+        return static_cast<AllocT const&>(*this);
+    }
+
+    constexpr void reserve(size_type new_cap) {
+        if (new_cap > cap)
+            _reallocate(new_cap);
+    }
+
+    /// @brief Release the unused heap capacity (moving back inline if the elements fit)
+    constexpr void shrink_to_fit() {
+        if (!is_inline() && sz < cap)
+            _reallocate(sz);
+    }
+
+    // Modifiers
+    constexpr reference emplace_back(auto&&... args) {
+        if (sz == cap) {  // args may alias an element, build the new one first
+            auto tmp = T(FWD(args)...);
+            _reallocate(_grown_cap());
+            return *std::construct_at(ptr + sz++, std::move(tmp));
+        }
+        return *std::construct_at(ptr + sz++, FWD(args)...);
+    }
+
+    constexpr void push_back(T const& val) {
+        emplace_back(val);
+    }
+
+    constexpr void push_back(T&& val) {
+        emplace_back(std::move(val));
+    }
+
+    constexpr void pop_back() {
+        assert(!empty());
+        std::destroy_at(ptr + --sz);
+    }
+
+    constexpr void resize(size_type n, T const& val = {}) {
+        if (n < sz) {
+            std::destroy(ptr + n, ptr + sz);
+            sz = static_cast<uint32_t>(n);
+            return;
+        }
+        reserve(n);
+        while (sz < n)
+            std::construct_at(ptr + sz++, val);
+    }
+
+    constexpr void clear() {
+        std::destroy(ptr, ptr + sz);
+        sz = 0;
+    }
+
+private:
+    [[nodiscard]] constexpr size_type _grown_cap() const {
+        return max(size_type{2} * cap, size_type{N} + 1);
+    }
+
+    /// @brief Move the elements into a buffer of new_cap >= sz elements (inline if it fits)
+    constexpr void _reallocate(size_type new_cap) {
+        assert(new_cap >= sz && new_cap <= std::numeric_limits<uint32_t>::max());
+        bool to_inline = new_cap <= N;
+        if (to_inline && is_inline())
+            return;
+
+        T* new_ptr = to_inline ? small.elems : alloc_traits::allocate(*this, new_cap);
+        for (uint32_t i = 0; i < sz; ++i) {
+            std::construct_at(new_ptr + i, std::move(ptr[i]));
+            std::destroy_at(ptr + i);
+        }
+        _free_heap();
+        ptr = new_ptr;
+        cap = to_inline ? N : static_cast<uint32_t>(new_cap);
+    }
+
+    constexpr void _free_heap() {
+        if (!is_inline())
+            alloc_traits::deallocate(*this, ptr, cap);
+        ptr = small.elems;
+        cap = N;
+    }
+
+    /// @brief Take other's elements (empty and inline this), leaving other empty and inline
+    constexpr void _steal(SmallVec& other) {
+        assert(sz == 0 && is_inline());
+        if (other.is_inline()) {
+            for (uint32_t i = 0; i < other.sz; ++i)
+                std::construct_at(ptr + i, std::move(other.ptr[i]));
+            sz = other.sz;
+            other.clear();
+            return;
+        }
+        ptr = std::exchange(other.ptr, other.small.elems);
+        sz  = std::exchange(other.sz, 0);
+        cap = std::exchange(other.cap, N);
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    CAV_BLOCK_PASS({
+        auto vec = SmallVec<int, 4>{1, 2, 3};
+        assert(vec.is_inline() && vec.size() == 3 && vec.capacity() == 4);
+
+        for (int i = 4; i <= 10; ++i)
+            vec.push_back(i);
+        assert(!vec.is_inline() && vec.size() == 10 && vec[9] == 10);
+
+        vec.resize(2);
+        vec.shrink_to_fit();
+        assert(vec.is_inline() && vec.back() == 2);
+
+        auto moved = std::move(vec);
+        assert(moved.size() == 2 && vec.empty());
+        moved.emplace_back(moved.front());  // aliasing
+        assert(moved.back() == 1);
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_UTILS_SMALLVEC_HPP */
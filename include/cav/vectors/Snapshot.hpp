@@ -0,0 +1,578 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_VECTORS_SNAPSHOT_HPP
+#define CAV_INCLUDE_VECTORS_SNAPSHOT_HPP
+
+/// Binary snapshots of OwnSpan, SoAArray (column blocks) and MatrixKD containers, reloaded by
+/// mapping the file instead of parsing it.
+///
+/// File layout (version 1, native endianness, checked on load):
+///   snapshot_header | data blocks | snapshot_entry directory
+/// Each data block starts at a multiple of its alignment and holds the exact in-memory storage of
+/// the container: the elements of an OwnSpan, the padded columns of a SoAArray block (one after
+/// the other, as in soa_base::col_offsets), the padded rows of a MatrixKD. The directory records,
+/// for each named entry, the kind of container, the element sizes, alignments and type name
+/// hashes of every column and the MatrixKD sizes/strides, so that a reload into a different type
+/// or layout is rejected.
+///
+/// Snapshot::load maps a block in place (copy-on-write private mapping, the file is never
+/// modified) when the container deleter is a MappableDel, otherwise (or when the mapping is not
+/// aligned enough for the container) the block is copied into a regular allocation. The mapping
+/// is unmapped when the Snapshot and the last container mapped from it are gone.
+///
+/// Only trivially copyable element types can be stored. Type hashes come from type_name, so
+/// snapshots are meant to be reloaded by a build of the same program.
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../comptime/instance_of.hpp"
+#include "../comptime/type_name.hpp"
+#include "../mish/RaiiWrap.hpp"
+#include "../string/PerfectHash.hpp"
+#include "../tuplish/type_map.hpp"
+#include "MatrixKD.hpp"
+#include "OwnSpan.hpp"
+#include "SoAArray.hpp"
+
+namespace cav {
+
+namespace detail {
+    /// @brief Reference-counted file mapping shared by a Snapshot and its mapped containers
+    struct mapped_region {
+        void*               addr = nullptr;
+        size_t              size = 0;
+        std::atomic<size_t> refs = 1;
+    };
+
+    inline void retain_region(mapped_region* region) noexcept {
+        region->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void release_region(mapped_region* region) noexcept {
+        if (region->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ::munmap(region->addr, region->size);
+            delete region;
+        }
+    }
+}  // namespace detail
+
+/// @brief Deleter that either releases a snapshot mapping (the memory was mapped by
+/// Snapshot::load) or behaves as BaseDelT (including its static allocate, if any). After a
+/// release it goes back to BaseDelT, so containers can reallocate normally. Usable wherever
+/// BaseDelT is: OwnSpan and MatrixKD deleters, soa_aligned_tag block deleters.
+template <typename BaseDelT>
+class MappableDel : public BaseDelT {
+public:
+    constexpr MappableDel() = default;
+
+    /// @brief Take a new reference to region
+    explicit MappableDel(detail::mapped_region* region_ptr) noexcept
+        : region(region_ptr) {
+        detail::retain_region(region);
+    }
+
+    MappableDel(MappableDel const& other) noexcept
+        : BaseDelT(other)
+        , region(other.region) {
+        if (region != nullptr)
+            detail::retain_region(region);
+    }
+
+    constexpr MappableDel(MappableDel&& other) noexcept
+        : BaseDelT(std::move(other))
+        , region(std::exchange(other.region, nullptr)) {
+    }
+
+    constexpr MappableDel& operator=(MappableDel other) noexcept {
+        std::swap(region, other.region);
+        return *this;
+    }
+
+    constexpr ~MappableDel() {
+        _release();
+    }
+
+    template <typename... Args>
+    constexpr void operator()(Args... args) {
+        if (region == nullptr)
+            BaseDelT::operator()(args...);
+        else
+            _release();
+    }
+
+    [[nodiscard]] constexpr bool is_mapped() const noexcept {
+        return region != nullptr;
+    }
+
+private:
+    detail::mapped_region* region = nullptr;
+
+    constexpr void _release() noexcept {
+        if (region != nullptr)
+            detail::release_region(std::exchange(region, nullptr));
+    }
+};
+
+template <typename T>
+using MappableSpan = OwnSpan<T, MappableDel<AllocatorDel<T>>>;
+
+template <typename T, int K = 1, size_t RowAlign = 0>
+using MappableMatrixKD = MatrixKD<T, K, RowAlign, MappableDel<matrix_del_t<T, RowAlign>>>;
+
+/// @brief SoAArray tag of soa_aligned_tag<Align> blocks that can be mapped from a snapshot
+template <size_t Align = 64>
+using soa_mappable_tag = soa_aligned_tag<Align, MappableDel<SoABlockDel>>;
+
+inline constexpr uint32_t snapshot_version   = 1;
+inline constexpr size_t   snapshot_max_cols  = 16;
+inline constexpr size_t   snapshot_max_dims  = 8;
+inline constexpr size_t   snapshot_name_size = 64;
+
+enum class snapshot_kind : uint32_t {
+    span,
+    soa,
+    matrix
+};
+
+struct snapshot_header {
+    std::array<char, 8>  magic      = {'C', 'A', 'V', 'S', 'N', 'A', 'P', '\0'};
+    uint32_t             version    = snapshot_version;
+    uint32_t             endian     = 0x01020304;
+    uint64_t             n_entries  = 0;
+    uint64_t             dir_offset = 0;
+    uint64_t             file_size  = 0;
+    std::array<char, 24> reserved   = {};
+};
+
+static_assert(sizeof(snapshot_header) == 64);
+
+/// @brief Directory record of one container
+struct snapshot_entry {
+    std::array<char, snapshot_name_size>    name      = {};
+    snapshot_kind                           kind      = snapshot_kind::span;
+    uint32_t                                n_cols    = 0;
+    uint64_t                                n_elems   = 0;  // size() (MatrixKD: total slots)
+    uint64_t                                offset    = 0;
+    uint64_t                                bytes     = 0;
+    uint64_t                                align     = 0;
+    uint32_t                                dims      = 0;
+    uint32_t                                row_align = 0;
+    std::array<int32_t, snapshot_max_dims>  sizes     = {};
+    std::array<int32_t, snapshot_max_dims>  strides   = {};
+    std::array<uint32_t, snapshot_max_cols> t_sizes   = {};
+    std::array<uint32_t, snapshot_max_cols> t_align   = {};
+    std::array<uint64_t, snapshot_max_cols> t_hash    = {};
+
+    [[nodiscard]] constexpr std::string_view name_view() const noexcept {
+        return {name.data(),
+                static_cast<size_t>(std::find(name.begin(), name.end(), '\0') - name.begin())};
+    }
+};
+
+namespace detail {
+    template <typename T>
+    [[nodiscard]] constexpr uint64_t snapshot_type_hash() noexcept {
+        return fnv1a(static_cast<std::string_view>(type_name<no_cvr<T>>::name));
+    }
+
+    template <typename... Ts>
+    constexpr void set_snapshot_cols(snapshot_entry& entry) noexcept {
+        static_assert(sizeof...(Ts) <= snapshot_max_cols, "Too many columns for a snapshot");
+        static_assert((std::is_trivially_copyable_v<Ts> && ...),
+                      "Only trivially copyable types can be stored in a snapshot");
+        entry.n_cols  = sizeof...(Ts);
+        size_t c      = 0;
+        ((entry.t_sizes[c] = sizeof(Ts),
+          entry.t_align[c] = alignof(Ts),
+          entry.t_hash[c]  = snapshot_type_hash<Ts>(),
+          ++c),
+         ...);
+    }
+
+    [[noreturn]] inline void snapshot_error(std::string const& msg) {
+        throw std::system_error(std::make_error_code(std::errc::invalid_argument), msg);
+    }
+}  // namespace detail
+
+/// @brief Writer of a snapshot file. Containers are appended with add(), finish() writes the
+/// directory (the destructor calls it, call it explicitly to get the errors as exceptions).
+/// Throws std::system_error on failure.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::string const& path)
+        : file(std::fopen(path.c_str(), "wb"))
+        , file_path(path) {
+        if (file == nullptr)
+            throw std::system_error(errno, std::generic_category(), "Cannot create " + path);
+        _write(&header, sizeof(header));
+    }
+
+    SnapshotWriter(SnapshotWriter const&)            = delete;
+    SnapshotWriter& operator=(SnapshotWriter const&) = delete;
+
+    ~SnapshotWriter() {
+        if (file != nullptr)
+            finish();
+    }
+
+    template <typename T, typename DelT>
+    void add(std::string_view name, OwnSpan<T, DelT> const& span) {
+        snapshot_entry& entry = _new_entry(name, snapshot_kind::span, alignof(T));
+        detail::set_snapshot_cols<no_cvr<T>>(entry);
+        entry.n_elems = span.size();
+        entry.bytes   = span.size() * sizeof(T);
+        _write(span.data(), entry.bytes);
+    }
+
+    template <size_t Align, typename BlockDelT, typename... Ts>
+    void add(std::string_view name, SoAArray<soa_aligned_tag<Align, BlockDelT>, Ts...> const& soa) {
+        using layout = typename SoAArray<soa_aligned_tag<Align, BlockDelT>, Ts...>::soa_base;
+        snapshot_entry& entry = _new_entry(name, snapshot_kind::soa, layout::block_align);
+        detail::set_snapshot_cols<Ts...>(entry);
+        entry.n_elems = soa.size();
+
+        auto offs = layout::col_offsets(soa.size());
+        entry.bytes = offs[sizeof...(Ts)];
+        for_each_idx<sizeof...(Ts)>([&](auto i) {  // column by column, padded as in memory
+            size_t col_bytes = layout::t_sizes[i] * soa.size();
+            _write(soa.base.ptrs[i], col_bytes);
+            _pad(offs[i + 1] - offs[i] - col_bytes);
+        });
+    }
+
+    template <typename T, int K, size_t RowAlign, typename DelT>
+    void add(std::string_view name, MatrixKD<T, K, RowAlign, DelT> const& mat) {
+        static_assert(K <= snapshot_max_dims, "Too many dimensions for a snapshot");
+        snapshot_entry& entry = _new_entry(name, snapshot_kind::matrix, max(alignof(T), RowAlign));
+        detail::set_snapshot_cols<T>(entry);
+        entry.dims      = K;
+        entry.row_align = RowAlign;
+        std::copy(mat.sizes.begin(), mat.sizes.end(), entry.sizes.begin());
+        std::copy(mat.strides.begin(), mat.strides.end(), entry.strides.begin());
+        entry.n_elems = mat.own_span.size();
+        entry.bytes   = mat.own_span.size() * sizeof(T);
+        _write(mat.data(), entry.bytes);
+    }
+
+    /// @brief Write the directory and close the file
+    void finish() {
+        header.n_entries  = entries.size();
+        header.dir_offset = _align_to(alignof(snapshot_entry));
+        _write(entries.data(), entries.size() * sizeof(snapshot_entry));
+        header.file_size = offset;
+
+        bool ok = std::fseek(file, 0, SEEK_SET) == 0 &&
+                  std::fwrite(&header, sizeof(header), 1, file) == 1;
+        ok      = std::fclose(std::exchange(file, nullptr)) == 0 && ok;
+        if (!ok)
+            throw std::system_error(errno, std::generic_category(), "Cannot write " + file_path);
+    }
+
+private:
+    std::FILE*                  file;
+    std::string                 file_path;
+    snapshot_header             header  = {};
+    std::vector<snapshot_entry> entries = {};
+    uint64_t                    offset  = 0;
+
+    snapshot_entry& _new_entry(std::string_view name, snapshot_kind kind, size_t align) {
+        if (name.empty() || name.size() >= snapshot_name_size)
+            detail::snapshot_error("Invalid snapshot entry name: " + std::string(name));
+        for (snapshot_entry const& entry : entries)
+            if (entry.name_view() == name)
+                detail::snapshot_error("Duplicated snapshot entry: " + std::string(name));
+
+        snapshot_entry& entry = entries.emplace_back();
+        std::copy(name.begin(), name.end(), entry.name.begin());
+        entry.kind   = kind;
+        entry.align  = max(align, size_t{64});
+        entry.offset = _align_to(entry.align);
+        return entry;
+    }
+
+    uint64_t _align_to(size_t align) {
+        _pad((align - offset % align) % align);
+        return offset;
+    }
+
+    void _pad(size_t bytes) {
+        static constexpr auto zeros = std::array<char, 4096>{};
+        for (; bytes > zeros.size(); bytes -= zeros.size())
+            _write(zeros.data(), zeros.size());
+        _write(zeros.data(), bytes);
+    }
+
+    void _write(void const* data, size_t bytes) {
+        if (bytes != 0 && std::fwrite(data, 1, bytes, file) != bytes)
+            throw std::system_error(errno, std::generic_category(), "Cannot write " + file_path);
+        offset += bytes;
+    }
+};
+
+/// @brief A mapped snapshot file whose entries can be loaded into containers. Throws
+/// std::system_error on I/O failures, on malformed files and on entries that do not match the
+/// requested container.
+class Snapshot {
+public:
+    explicit Snapshot(std::string const& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+        auto fd_guard = RaiiWrap{fd, [](int f) { ::close(f); }};
+
+        struct stat st = {};
+        if (::fstat(fd, &st) != 0)
+            throw std::system_error(errno, std::generic_category(), "Cannot stat " + path);
+        auto size = static_cast<size_t>(st.st_size);
+        if (size < sizeof(snapshot_header))
+            detail::snapshot_error(path + " is not a snapshot");
+
+        // Private writable mapping: mapped containers can be modified, the file is not
+        void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "Cannot map " + path);
+        // Owned by the guard until validated: a rejected file never reaches the destructor
+        auto region_guard = RaiiWrap{new detail::mapped_region{addr, size},
+                                     [](detail::mapped_region* r) {
+                                         if (r != nullptr)
+                                             detail::release_region(r);
+                                     }};
+        region            = region_guard.val;
+        _validate(path);
+        region_guard.val = nullptr;
+    }
+
+    Snapshot(Snapshot const&)            = delete;
+    Snapshot& operator=(Snapshot const&) = delete;
+
+    ~Snapshot() {
+        detail::release_region(region);
+    }
+
+    [[nodiscard]] std::span<snapshot_entry const> entries() const noexcept {
+        return {_dir(), static_cast<size_t>(_header().n_entries)};
+    }
+
+    [[nodiscard]] bool contains(std::string_view name) const noexcept {
+        return _find(name) != nullptr;
+    }
+
+    /// @brief Entry name as a ContT (an OwnSpan, a soa_aligned_tag SoAArray or a MatrixKD)
+    template <typename ContT>
+    [[nodiscard]] ContT load(std::string_view name) const {
+        return _load(name, tag<ContT>);
+    }
+
+private:
+    detail::mapped_region* region = nullptr;
+
+    [[nodiscard]] snapshot_header const& _header() const noexcept {
+        return *static_cast<snapshot_header const*>(region->addr);
+    }
+
+    [[nodiscard]] snapshot_entry const* _dir() const noexcept {
+        return reinterpret_cast<snapshot_entry const*>(static_cast<char const*>(region->addr) +
+                                                       _header().dir_offset);
+    }
+
+    [[nodiscard]] char* _block(snapshot_entry const& entry) const noexcept {
+        return static_cast<char*>(region->addr) + entry.offset;
+    }
+
+    void _validate(std::string const& path) const {
+        snapshot_header const& hdr = _header();
+        if (hdr.magic != snapshot_header{}.magic)
+            detail::snapshot_error(path + " is not a snapshot");
+        if (hdr.version != snapshot_version || hdr.endian != snapshot_header{}.endian)
+            detail::snapshot_error(path + ": unsupported snapshot version or endianness");
+        size_t dir_bytes = hdr.n_entries * sizeof(snapshot_entry);
+        if (hdr.file_size != region->size || hdr.dir_offset > region->size ||
+            dir_bytes > region->size - hdr.dir_offset ||
+            hdr.dir_offset % alignof(snapshot_entry) != 0)
+            detail::snapshot_error(path + ": truncated or corrupted snapshot");
+        for (snapshot_entry const& entry : entries())
+            if (entry.offset > hdr.dir_offset || entry.bytes > hdr.dir_offset - entry.offset)
+                detail::snapshot_error(path + ": corrupted entry " +
+                                       std::string(entry.name_view()));
+    }
+
+    [[nodiscard]] snapshot_entry const* _find(std::string_view name) const noexcept {
+        for (snapshot_entry const& entry : entries())
+            if (entry.name_view() == name)
+                return &entry;
+        return nullptr;
+    }
+
+    template <typename... Ts>
+    [[nodiscard]] snapshot_entry const& _checked(std::string_view name,
+                                                 snapshot_kind    kind,
+                                                 size_t           align) const {
+        snapshot_entry const* entry = _find(name);
+        if (entry == nullptr)
+            detail::snapshot_error("Snapshot entry not found: " + std::string(name));
+
+        auto expected = snapshot_entry{};
+        detail::set_snapshot_cols<Ts...>(expected);
+        if (entry->kind != kind || entry->n_cols != expected.n_cols ||
+            entry->t_sizes != expected.t_sizes || entry->t_align != expected.t_align ||
+            entry->t_hash != expected.t_hash || entry->align != max(align, size_t{64}))
+            detail::snapshot_error("Snapshot entry " + std::string(name) +
+                                   " does not match the requested container");
+        return *entry;
+    }
+
+    /// @brief True if the block can be used in place by a container deleting through DelT
+    template <typename DelT>
+    [[nodiscard]] bool _mappable(snapshot_entry const& entry, size_t align) const noexcept {
+        return is_inst_of_v<DelT, MappableDel> &&
+               reinterpret_cast<uintptr_t>(_block(entry)) % align == 0;
+    }
+
+    /// @brief Throws unless the entry block holds exactly n_elems values of type T
+    template <typename T>
+    static void _check_bytes(snapshot_entry const& entry) {
+        if (entry.n_elems > type_max<uint64_t> / sizeof(T) ||
+            entry.bytes != entry.n_elems * sizeof(T))
+            detail::snapshot_error("Snapshot entry " + std::string(entry.name_view()) +
+                                   " has a wrong size");
+    }
+
+    template <typename T, typename DelT>
+    [[nodiscard]] OwnSpan<T, DelT> _load(std::string_view           name,
+                                         tag_type<OwnSpan<T, DelT>> /*t*/) const {
+        snapshot_entry const& entry = _checked<no_cvr<T>>(name, snapshot_kind::span, alignof(T));
+        _check_bytes<T>(entry);
+        auto n = static_cast<size_t>(entry.n_elems);
+        if constexpr (is_inst_of_v<DelT, MappableDel>)
+            if (_mappable<DelT>(entry, alignof(T)))
+                return {reinterpret_cast<T*>(_block(entry)), n, DelT(region)};
+        auto span = OwnSpan<T, DelT>(n, uninit);
+        std::memcpy(static_cast<void*>(span.data()), _block(entry), entry.bytes);
+        return span;
+    }
+
+    template <size_t Align, typename BlockDelT, typename... Ts>
+    [[nodiscard]] SoAArray<soa_aligned_tag<Align, BlockDelT>, Ts...> _load(
+        std::string_view                                            name,
+        tag_type<SoAArray<soa_aligned_tag<Align, BlockDelT>, Ts...>> /*t*/) const {
+        using soa_t  = SoAArray<soa_aligned_tag<Align, BlockDelT>, Ts...>;
+        using layout = typename soa_t::soa_base;
+        snapshot_entry const& entry = _checked<Ts...>(name,
+                                                      snapshot_kind::soa,
+                                                      layout::block_align);
+        auto                  n     = static_cast<size_t>(entry.n_elems);
+        if (entry.n_elems > entry.bytes || entry.bytes != layout::col_offsets(n)[sizeof...(Ts)])
+            detail::snapshot_error("Snapshot entry " + std::string(name) + " has a wrong size");
+
+        auto soa = soa_t();
+        if constexpr (is_inst_of_v<BlockDelT, MappableDel>)
+            if (_mappable<BlockDelT>(entry, layout::block_align)) {
+                soa.base = layout(_block(entry), n, BlockDelT(region));
+                return soa;
+            }
+        soa      = soa_t(n);
+        auto offs = layout::col_offsets(n);
+        for_each_idx<sizeof...(Ts)>([&](auto i) {
+            std::memcpy(static_cast<void*>(soa.base.ptrs[i]),
+                        _block(entry) + offs[i],
+                        layout::t_sizes[i] * n);
+        });
+        return soa;
+    }
+
+    template <typename T, int K, size_t RowAlign, typename DelT>
+    [[nodiscard]] MatrixKD<T, K, RowAlign, DelT> _load(
+        std::string_view                            name,
+        tag_type<MatrixKD<T, K, RowAlign, DelT>> /*t*/) const {
+        size_t                align = max(alignof(T), RowAlign);
+        snapshot_entry const& entry = _checked<T>(name, snapshot_kind::matrix, align);
+        if (entry.dims != K || entry.row_align != RowAlign)
+            detail::snapshot_error("Snapshot entry " + std::string(name) + " has a wrong shape");
+
+        auto mat = MatrixKD<T, K, RowAlign, DelT>();
+        std::copy_n(entry.sizes.begin(), K, mat.sizes.begin());
+        std::copy_n(entry.strides.begin(), K, mat.strides.begin());
+        if (static_cast<uint64_t>(mat.sizes[0]) * static_cast<uint64_t>(mat.strides[0]) !=
+            entry.n_elems)
+            detail::snapshot_error("Snapshot entry " + std::string(name) + " has a wrong size");
+        _check_bytes<T>(entry);
+
+        auto n = static_cast<size_t>(entry.n_elems);
+        if constexpr (is_inst_of_v<DelT, MappableDel>)
+            if (_mappable<DelT>(entry, align)) {
+                auto* ptr    = reinterpret_cast<T*>(_block(entry));
+                mat.own_span = OwnSpan<T, DelT>(ptr, n, DelT(region));
+                return mat;
+            }
+        mat.own_span = OwnSpan<T, DelT>(n, uninit);
+        std::memcpy(static_cast<void*>(mat.data()), _block(entry), entry.bytes);
+        return mat;
+    }
+};
+
+#ifdef CAV_COMP_TESTS
+// The file round trip (SnapshotWriter::add, Snapshot::load) is I/O and cannot be constant
+// evaluated, these cover the directory records the load checks rely on.
+namespace {
+    CAV_BLOCK_PASS({
+        auto entry = snapshot_entry{};
+        assert(entry.name_view().empty());
+        entry.name[0] = 'a';
+        entry.name[1] = 'b';
+        assert(entry.name_view() == "ab");
+        entry.name.fill('x');  // no terminator: the whole array
+        assert(entry.name_view().size() == snapshot_name_size);
+    });
+
+    CAV_BLOCK_PASS({
+        auto same  = snapshot_entry{};
+        auto other = snapshot_entry{};
+        detail::set_snapshot_cols<int, double>(same);
+        detail::set_snapshot_cols<int, double>(other);
+        assert(same.n_cols == 2 && same.t_sizes[1] == sizeof(double));
+        assert(same.t_hash == other.t_hash);
+
+        detail::set_snapshot_cols<int, float>(other);  // same sizes, different type
+        assert(same.t_sizes[0] == other.t_sizes[0] && same.t_hash != other.t_hash);
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif
+
+#endif /* CAV_INCLUDE_VECTORS_SNAPSHOT_HPP */
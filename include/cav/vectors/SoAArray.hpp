@@ -16,21 +16,50 @@
 #ifndef CAV_INCLUDE_UTILS_SOAARRAY_HPP
 #define CAV_INCLUDE_UTILS_SOAARRAY_HPP
 
+#include <array>
+#include <bit>
 #include <memory>
+#include <new>
+#include <span>
+#include <utility>
 
 #include "../comptime/test.hpp"
+#include "../mish/AllocStats.hpp"
 #include "../mish/util_functions.hpp"
 #include "../tuplish/tuple.hpp"
 #include "../vectors/IndexProxyIter.hpp"
 
 namespace cav {
 
-struct soa_tag;
+/// @brief Default (de)allocation of the SoA column blocks: aligned operator new/delete
+struct SoABlockDel {
+    [[nodiscard]] static void* allocate(size_t bytes, size_t align) {
+        return ::operator new(bytes, std::align_val_t{align});
+    }
+
+    void operator()(void* block, size_t /*bytes*/, size_t align) const noexcept {
+        ::operator delete(block, std::align_val_t{align});
+    }
+};
+
+/// @brief Structure of Arrays layout with all the columns in one block, each one starting at a
+/// multiple of Align bytes (e.g., 32/64 for aligned SIMD loads, 2M for huge pages). The block is
+/// allocated and freed through BlockDelT (e.g., a MappableDel for snapshot reloads).
+template <size_t Align, typename BlockDelT = SoABlockDel>
+struct soa_aligned_tag;
+
+using soa_tag = soa_aligned_tag<64>;
 struct aos_tag;
 
-/// @brief SoAArray: abstraction that provides easy access to either Structure of Arrays (SoA) or
-/// Array of Structures (AoS) data types. The interface is designed to be as similar as possible
-/// between the two versions.
+/// @brief Hybrid (tiled) layout: tiles of Tile elements stored field-by-field inside each tile
+/// (e.g., Tile = SIMD width or a multiple of cache-line/sizeof(T)). Fields of the same element stay
+/// close, while each tile column is still a contiguous array.
+template <size_t Tile>
+struct aosoa_tag;
+
+/// @brief SoAArray: abstraction that provides easy access to either Structure of Arrays (SoA),
+/// Array of Structures (AoS) or tiled Array of Structures of Arrays (AoSoA) data types. The
+/// interface is designed to be as similar as possible between the three versions.
 ///
 /// The SoAArray was initially designed to be a full std::vector-like container with support for
 /// custom allocators and resizing. However, these features have been removed for simplicity, as
@@ -92,7 +121,7 @@ struct TupleProxyLRef<SoaT, std::index_sequence<Is...>> {
         using base = TupleProxyLRef;
 
         [[nodiscard]] constexpr decl_auto operator[](auto i) const {
-            return std::move(soa_array->base.ptrs[i][idx]);
+            return std::move(soa_array->base.at(i, idx));
         }
 
         [[nodiscard]] constexpr decl_auto reduce(auto&& fn) const {
@@ -150,7 +179,7 @@ public:
     }
 
     [[nodiscard]] constexpr decl_auto operator[](auto i) const {
-        return soa_array->base.ptrs[i][idx];
+        return soa_array->base.at(i, idx);
     }
 
     [[nodiscard]] constexpr decl_auto reduce(auto&& fn) const {
@@ -187,13 +216,81 @@ template <typename SoaT, typename ISeqT>
 
 namespace cav {
 
+/// @brief Column-wise access for the SoA containers (D exposes base.ptrs, size() and col_align):
+/// std::span views of single columns and kernels on the raw aligned column pointers, for loops
+/// that compilers can vectorize (proxy references and iterators get in the way).
+template <typename D>
+struct SoAColumns {
+    template <size_t I>
+    [[nodiscard]] constexpr auto column() {
+        auto& me = static_cast<D&>(*this);
+        return std::span(_aligned(me.base.ptrs[ct_v<I>]), me.size());
+    }
+
+    template <size_t I>
+    [[nodiscard]] constexpr auto column() const {
+        auto const& me = static_cast<D const&>(*this);
+        return std::span(_caligned(me.base.ptrs[ct_v<I>]), me.size());
+    }
+
+    /// @brief Call fn(ptr, size) for each column
+    constexpr void for_each_column(auto&& fn) {
+        auto& me = static_cast<D&>(*this);
+        me.base.ptrs.for_each([&](auto* ptr) { fn(_aligned(ptr), me.size()); });
+    }
+
+    constexpr void for_each_column(auto&& fn) const {
+        auto const& me = static_cast<D const&>(*this);
+        me.base.ptrs.for_each([&](auto* ptr) { fn(_caligned(ptr), me.size()); });
+    }
+
+    /// @brief Return fn(size, ptrs...) with the pointers of the columns Is... (all if empty)
+    template <size_t... Is>
+    constexpr decl_auto transform_columns(auto&& fn) {
+        auto& me = static_cast<D&>(*this);
+        if constexpr (sizeof...(Is) == 0)
+            return [&]<size_t... Js>(std::index_sequence<Js...>) -> decl_auto {
+                return FWD(fn)(me.size(), _aligned(me.base.ptrs[ct_v<Js>])...);
+            }(std::make_index_sequence<D::ntypes>{});
+        else
+            return FWD(fn)(me.size(), _aligned(me.base.ptrs[ct_v<Is>])...);
+    }
+
+    template <size_t... Is>
+    constexpr decl_auto transform_columns(auto&& fn) const {
+        auto const& me = static_cast<D const&>(*this);
+        if constexpr (sizeof...(Is) == 0)
+            return [&]<size_t... Js>(std::index_sequence<Js...>) -> decl_auto {
+                return FWD(fn)(me.size(), _caligned(me.base.ptrs[ct_v<Js>])...);
+            }(std::make_index_sequence<D::ntypes>{});
+        else
+            return FWD(fn)(me.size(), _caligned(me.base.ptrs[ct_v<Is>])...);
+    }
+
+private:
+    template <typename T>
+    [[nodiscard]] static constexpr T* _aligned(T* ptr) {
+        if (std::is_constant_evaluated() || ptr == nullptr)
+            return ptr;
+        return std::assume_aligned<D::col_align>(ptr);
+    }
+
+    template <typename T>
+    [[nodiscard]] static constexpr T const* _caligned(T* ptr) {
+        return _aligned(static_cast<T const*>(ptr));
+    }
+};
+
 /// @brief SoAArray specialization for Structure of arrays.
+/// At runtime all the columns live in a single allocation, padded to Align bytes each (in constant
+/// evaluation each column is a separate std::allocator allocation).
 /// Possible extensions:
 /// - support for resize (make it vector-like)
 /// - support for custom allocators (will I ever use them tho?)
 /// - full pointer-proxy abstaction (with operator& overloading)
-template <typename... Ts>
-class SoAArray<soa_tag, Ts...> {
+template <size_t Align, typename BlockDelT, typename... Ts>
+class SoAArray<soa_aligned_tag<Align, BlockDelT>, Ts...>
+    : public SoAColumns<SoAArray<soa_aligned_tag<Align, BlockDelT>, Ts...>> {
 public:
     using self                   = SoAArray;
     using value_type             = tuple<Ts...>;
@@ -216,10 +313,50 @@ public:
 
         [[no_unique_address]] ptr_tuple_t ptrs = {};
         size_t                            sz   = {};
+        [[no_unique_address]] BlockDelT   del  = {};
+
+        [[nodiscard]] constexpr decl_auto at(auto i, size_t j) const {
+            return ptrs[i][j];
+        }
+
+        /// @brief Block (and columns) alignment
+        static constexpr size_t block_align = max(Align, alignof(Ts)...);
+        static_assert(std::has_single_bit(block_align), "Alignment must be a power of two");
+
+        [[nodiscard]] static constexpr size_t _pad(size_t bytes) {
+            return (bytes + block_align - 1) / block_align * block_align;
+        }
+
+        /// @brief Byte offsets of each column inside the block (last one is the block size)
+        [[nodiscard]] static constexpr std::array<size_t, ntypes + 1> col_offsets(size_t n) {
+            auto offs = std::array<size_t, ntypes + 1>{};
+            for (size_t i = 0; i < ntypes; ++i)
+                offs[i + 1] = offs[i] + _pad(t_sizes[i] * n);
+            return offs;
+        }
 
         constexpr ptr_tuple_t allocate(size_t n) {
             auto ptr = ptr_tuple_t{};
-            ptr.for_each([n]<class T>(T*& ptr) { ptr = std::allocator<T>{}.allocate(n); });
+            if (n == 0)
+                return ptr;
+
+            if (std::is_constant_evaluated()) {
+                ptr.for_each([n]<class T>(T*& p) { p = std::allocator<T>{}.allocate(n); });
+                return ptr;
+            }
+
+            CAV_ALLOC_RECORD(self, on_alloc, col_offsets(n)[ntypes]);
+            return columns_of(BlockDelT::allocate(col_offsets(n)[ntypes], block_align), n);
+        }
+
+        /// @brief Column pointers inside a block of n elements
+        [[nodiscard]] static ptr_tuple_t columns_of(void* block, size_t n) {
+            auto ptr  = ptr_tuple_t{};
+            auto offs = col_offsets(n);
+            for_each_idx<ntypes>([&](auto i) {
+                using T = std::remove_pointer_t<no_cvr<decltype(ptr[i])>>;
+                ptr[i]  = static_cast<T*>(static_cast<void*>(static_cast<char*>(block) + offs[i]));
+            });
             return ptr;
         }
 
@@ -231,7 +368,15 @@ public:
         }
 
         constexpr void deallocate() {
-            ptrs.for_each([this]<class T>(T* ptr) { std::allocator<T>{}.deallocate(ptr, sz); });
+            if (sz > 0) {
+                if (std::is_constant_evaluated())
+                    ptrs.for_each(
+                        [this]<class T>(T* ptr) { std::allocator<T>{}.deallocate(ptr, sz); });
+                else if constexpr (ntypes > 0) {
+                    CAV_ALLOC_RECORD(self, on_free, col_offsets(sz)[ntypes]);
+                    del(static_cast<void*>(ptrs[ct_v<0_uz>]), col_offsets(sz)[ntypes], block_align);
+                }
+            }
             ptrs = {};
             sz   = 0;
         }
@@ -259,16 +404,27 @@ public:
         }
 
         constexpr soa_base(soa_base&& other) noexcept
-            : ptrs{std::exchange(other.ptrs, nullptr)}
-            , sz{std::exchange(other.sz, 0)} {
+            : ptrs{std::exchange(other.ptrs, {})}
+            , sz{std::exchange(other.sz, 0)}
+            , del{std::move(other.del)} {
+        }
+
+        /// @brief Adopt a block of n constructed elements laid out as by allocate(n), released
+        /// with block_del
+        soa_base(void* block, size_t n, BlockDelT block_del)
+            : ptrs{n > 0 ? columns_of(block, n) : ptr_tuple_t{}}
+            , sz{n}
+            , del{std::move(block_del)} {
+            if (n > 0)
+                CAV_ALLOC_RECORD(self, on_alloc, col_offsets(n)[ntypes]);
         }
 
         constexpr soa_base(std::input_iterator auto first, std::input_iterator auto last)
             : sz(std::distance(first, last)) {
             ptrs = allocate(sz);
-            for (int j = 0; auto& tup : std::span(first, last)) {
+            for (size_t j = 0; first != last; ++first, ++j) {
+                decl_auto tup = *first;
                 for_each_idx<ntypes>([&](auto i) { std::construct_at(ptrs[i] + j, tup[i]); });
-                ++j;
             }
         }
 
@@ -285,9 +441,9 @@ public:
             }
 
             destroy();
-            deallocate(ptrs, sz);
+            deallocate();
+            ptrs = allocate(other.sz);
             sz   = other.sz;
-            ptrs = allocate(sz);
             for_each_idx<ntypes>([&](auto i) {
                 for (size_t j = 0; j < sz; ++j)
                     std::construct_at(ptrs[i] + j, other.ptrs[i][j]);
@@ -300,9 +456,11 @@ public:
                 return *this;
 
             destroy();
-            deallocate(ptrs, sz);
-            ptrs = std::exchange(other.ptrs, nullptr);
+            deallocate();
+            ptrs = std::exchange(other.ptrs, {});
             sz   = std::exchange(other.sz, 0);
+            std::swap(del, other.del);
+            return *this;
         }
 
         constexpr ~soa_base() {
@@ -313,11 +471,14 @@ public:
 
     soa_base base = {};
 
+    static constexpr size_t col_align = soa_base::block_align;
 
 public:
     constexpr SoAArray() = default;
 
-    constexpr SoAArray(auto&&... args)
+    template <typename... Args>
+    requires(!(sizeof...(Args) == 1 && (eq<no_cvr<Args>, self> && ...)))  // not a copy
+    constexpr SoAArray(Args&&... args)
         : base(FWD(args)...) {
     }
 
@@ -375,13 +536,269 @@ public:
     }
 
     // Modifiers
-    constexpr void assign_all(value_type const& tup) noexcept {
+    constexpr void assign_all(value_type const& tup) {
         for_each_idx<ntypes>([&](auto i) {
             for (size_t j = 0; j < base.sz; ++j)
-                base[i].ptr[i], tup[i];
+                base.ptrs[i][j] = tup[i];
         });
     }
 };
+/// @brief SoAArray specialization for tiled Array of Structures of Arrays.
+/// Elements are grouped in tiles of Tile elements, each tile stores its fields one after the other
+/// as arrays of Tile lanes (cache-line aligned tiles). Accessing a few fields of the same element
+/// touches a single tile, while full-field sweeps still run over contiguous lanes (see
+/// transform_tiles). The lanes past size() of the last tile are left uninitialized.
+template <size_t Tile, typename... Ts>
+class SoAArray<aosoa_tag<Tile>, Ts...> {
+public:
+    using self                   = SoAArray;
+    using value_type             = tuple<Ts...>;
+    using reference              = TupleProxyLRef<self, std::index_sequence_for<Ts...>>;
+    using const_reference        = TupleProxyLRef<self const, std::index_sequence_for<Ts...>>;
+    using iterator               = IndexProxyIter<self>;
+    using const_iterator         = IndexProxyIter<self const>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using size_type              = size_t;
+    using difference_type        = ptrdiff_t;
+    using allocator_type         = std::allocator<value_type>;  // lie
+
+    static constexpr size_t ntypes    = sizeof...(Ts);
+    static constexpr size_t tile_size = Tile;
+    static_assert(Tile > 0, "Tile must be positive");
+
+    /// @brief Tile column with manually managed lifetime of the lanes
+    template <typename T>
+    union tile_col {
+        T lanes[Tile];
+
+        constexpr tile_col() {
+        }
+
+        constexpr ~tile_col() {
+        }
+    };
+
+    struct alignas(64) tile_t {
+        tuple<tile_col<Ts>...> cols = {};
+    };
+
+    struct aosoa_base {
+        tile_t* tiles = nullptr;
+        size_t  sz    = {};
+
+        [[nodiscard]] static constexpr size_t n_tiles(size_t n) {
+            return (n + Tile - 1) / Tile;
+        }
+
+        [[nodiscard]] constexpr decl_auto at(auto i, size_t j) const {
+            return tiles[j / Tile].cols[i].lanes[j % Tile];
+        }
+
+        constexpr void allocate(size_t n) {
+            tiles = nullptr;
+            sz    = n;
+            if (n == 0)
+                return;
+            tiles = std::allocator<tile_t>{}.allocate(n_tiles(n));
+            for (size_t t = 0; t < n_tiles(n); ++t)
+                std::construct_at(tiles + t);
+        }
+
+        constexpr void destroy() {
+            for_each_idx<ntypes>([&](auto i) {
+                for (size_t j = 0; j < sz; ++j)
+                    std::destroy_at(std::addressof(at(i, j)));
+            });
+        }
+
+        constexpr void deallocate() {
+            if (sz > 0) {
+                std::destroy(tiles, tiles + n_tiles(sz));
+                std::allocator<tile_t>{}.deallocate(tiles, n_tiles(sz));
+            }
+            tiles = nullptr;
+            sz    = 0;
+        }
+
+        constexpr void construct_all(auto&& get_field) {
+            for_each_idx<ntypes>([&](auto i) {
+                for (size_t j = 0; j < sz; ++j)
+                    std::construct_at(std::addressof(at(i, j)), get_field(i, j));
+            });
+        }
+
+        constexpr aosoa_base() = default;
+
+        constexpr aosoa_base(size_t n, value_type const& tup = {}) {
+            allocate(n);
+            construct_all([&](auto i, size_t /*j*/) -> decl_auto { return tup[i]; });
+        }
+
+        constexpr aosoa_base(aosoa_base const& other) {
+            allocate(other.sz);
+            construct_all([&](auto i, size_t j) -> decl_auto { return other.at(i, j); });
+        }
+
+        constexpr aosoa_base(aosoa_base&& other) noexcept
+            : tiles{std::exchange(other.tiles, nullptr)}
+            , sz{std::exchange(other.sz, 0)} {
+        }
+
+        constexpr aosoa_base(std::input_iterator auto first, std::input_iterator auto last) {
+            allocate(std::distance(first, last));
+            for (size_t j = 0; first != last; ++first, ++j) {
+                decl_auto tup = *first;
+                for_each_idx<ntypes>(
+                    [&](auto i) { std::construct_at(std::addressof(at(i, j)), tup[i]); });
+            }
+        }
+
+        constexpr aosoa_base& operator=(aosoa_base const& other) {
+            if (this == &other)
+                return *this;
+
+            if (sz == other.sz) {
+                for_each_idx<ntypes>([&](auto i) {
+                    for (size_t j = 0; j < sz; ++j)
+                        at(i, j) = other.at(i, j);
+                });
+                return *this;
+            }
+
+            destroy();
+            deallocate();
+            allocate(other.sz);
+            construct_all([&](auto i, size_t j) -> decl_auto { return other.at(i, j); });
+            return *this;
+        }
+
+        constexpr aosoa_base& operator=(aosoa_base&& other) noexcept {
+            if (this == &other)
+                return *this;
+
+            destroy();
+            deallocate();
+            tiles = std::exchange(other.tiles, nullptr);
+            sz    = std::exchange(other.sz, 0);
+            return *this;
+        }
+
+        constexpr ~aosoa_base() {
+            destroy();
+            deallocate();
+        }
+    };
+
+    aosoa_base base = {};
+
+public:
+    constexpr SoAArray() = default;
+
+    template <typename... Args>
+    requires(!(sizeof...(Args) == 1 && (eq<no_cvr<Args>, self> && ...)))  // not a copy
+    constexpr SoAArray(Args&&... args)
+        : base(FWD(args)...) {
+    }
+
+    // Element access
+    [[nodiscard]] constexpr reference operator[](size_t i) noexcept {
+        assert(i < size());
+        return {i, this};
+    }
+
+    [[nodiscard]] constexpr const_reference operator[](size_t i) const noexcept {
+        assert(i < size());
+        return {i, this};
+    }
+
+    [[nodiscard]] constexpr reference front() {
+        return (*this)[0];
+    }
+
+    [[nodiscard]] constexpr const_reference front() const {
+        return (*this)[0];
+    }
+
+    [[nodiscard]] constexpr reference back() {
+        return (*this)[size() - 1];
+    }
+
+    [[nodiscard]] constexpr const_reference back() const {
+        return (*this)[size() - 1];
+    }
+
+    // Iterators
+    [[nodiscard]] constexpr iterator begin() {
+        return {0, this};
+    }
+
+    [[nodiscard]] constexpr const_iterator begin() const {
+        return {0, this};
+    }
+
+    [[nodiscard]] constexpr iterator end() {
+        return {size(), this};
+    }
+
+    [[nodiscard]] constexpr const_iterator end() const {
+        return {size(), this};
+    }
+
+    // Capacity
+    [[nodiscard]] constexpr bool empty() const {
+        return size() == 0;
+    }
+
+    [[nodiscard]] constexpr size_type size() const {
+        return base.sz;
+    }
+
+    [[nodiscard]] constexpr size_type n_tiles() const {
+        return aosoa_base::n_tiles(base.sz);
+    }
+
+    // Tile-wise access
+    /// @brief Call fn(n, lanes...) for each tile with the lane pointers of the columns Is... (all
+    /// if empty), n is Tile for all the tiles but (possibly) the last one.
+    template <size_t... Is>
+    constexpr void transform_tiles(auto&& fn) {
+        _transform_tiles<Is...>(*this, fn);
+    }
+
+    template <size_t... Is>
+    constexpr void transform_tiles(auto&& fn) const {
+        _transform_tiles<Is...>(*this, fn);
+    }
+
+    // Modifiers
+    constexpr void assign_all(value_type const& tup) {
+        for_each_idx<ntypes>([&](auto i) {
+            for (size_t j = 0; j < base.sz; ++j)
+                base.at(i, j) = tup[i];
+        });
+    }
+
+private:
+    template <size_t... Is>
+    static constexpr void _transform_tiles(auto& me, auto& fn) {
+        auto const lanes_of = [&](tile_t& tile, auto i) {
+            using T = no_cvr<decltype(tile.cols[i].lanes[0])>;
+            if constexpr (std::is_const_v<std::remove_reference_t<decltype(me)>>)
+                return static_cast<T const*>(tile.cols[i].lanes);
+            else
+                return static_cast<T*>(tile.cols[i].lanes);
+        };
+        for (size_t t = 0; t < me.n_tiles(); ++t) {
+            size_t n = min(Tile, me.size() - t * Tile);
+            [&]<size_t... Js>(std::index_sequence<Js...>) {
+                fn(n, lanes_of(me.base.tiles[t], ct_v<Js>)...);
+            }(std::conditional_t<sizeof...(Is) == 0,
+                                 std::make_index_sequence<ntypes>,
+                                 std::index_sequence<Is...>>{});
+        }
+    }
+};
 }  // namespace cav
 
 #ifdef CAV_COMP_TESTS
@@ -477,14 +894,38 @@ namespace {
         auto vec = std::move(s3[5])[2_ct];
         assert(vec[2] == 999 && s3[5][2_ct].empty());
 
+        s3.assign_all({7, 0.7, std::vector<int>{7, 7}});
+        for (auto const& tup : s3)
+            assert(tup[0_ct] == 7 && tup[1_ct] == 0.7 && tup[2_ct].size() == 2);
+
         auto a3 = aos3{s3.begin(), s3.end()};
         assert(s3.size() == a3.size());
         assert(s3[0][0_ct] == a3[0][0_ct]);
         assert(s3[1][1_ct] == a3[1][1_ct]);
         assert(s3[2][2_ct].size() == a3[2][2_ct].size());
     });
+
+    CAV_BLOCK_PASS({
+        using tiled3 = SoAArray<aosoa_tag<4>, int, double, std::vector<int>>;
+        auto t3      = tiled3{10, tuple{1, 2.0, std::vector<int>{1, 2, 3}}};
+        t3[5]        = {5, 0.5, std::vector<int>{5}};
+        t3[9]        = std::move(t3[5]);
+        assert(t3.n_tiles() == 3);
+        assert(t3[9][0_ct] == 5 && t3[9][2_ct][0] == 5 && t3[5][2_ct].empty());
+
+        auto s3 = soa3{t3.begin(), t3.end()};
+        auto c3 = tiled3{s3.begin(), s3.end()};
+        assert(c3[8][1_ct] == 2.0 && c3[9][1_ct] == 0.5 && c3[0][2_ct][2] == 3);
+
+        int sum = 0;
+        c3.transform_tiles<0>([&](size_t n, int* xs) {
+            for (size_t j = 0; j < n; ++j)
+                sum += xs[j];
+        });
+        assert(sum == 18);
+    });
 }  // namespace
-#endif
 }  // namespace cav
+#endif
 
 #endif /* CAV_INCLUDE_UTILS_SOAARRAY_HPP */
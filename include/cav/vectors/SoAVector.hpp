@@ -0,0 +1,396 @@
+// Copyright (c) 2024 Francesco Cavaliere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAV_INCLUDE_UTILS_SOAVECTOR_HPP
+#define CAV_INCLUDE_UTILS_SOAVECTOR_HPP
+
+#include <cstddef>
+#include <memory>
+
+#include "../comptime/test.hpp"
+#include "../mish/util_functions.hpp"
+#include "../tuplish/tuple.hpp"
+#include "IndexProxyIter.hpp"
+#include "SoAArray.hpp"
+
+namespace cav {
+
+/// @brief Growable Structure of Arrays: a std::vector-like container whose columns live in a
+/// single allocation (same layout of SoAArray<soa_aligned_tag<Align>, Ts...>), reallocated all
+/// together with geometric growth. Elements are accessed through the same TupleProxyLRef proxies
+/// and IndexProxyIter iterators of SoAArray.
+///
+/// @tparam AlcT  Allocator (rebound internally to Align-aligned blocks, e.g., pmr allocators work)
+/// @tparam Align Columns alignment
+/// @tparam ...Ts Columns types
+template <typename AlcT, size_t Align, typename... Ts>
+class BasicSoAVector
+    : AlcT
+    , public SoAColumns<BasicSoAVector<AlcT, Align, Ts...>> {
+public:
+    using self                   = BasicSoAVector;
+    using value_type             = tuple<Ts...>;
+    using reference              = TupleProxyLRef<self, std::index_sequence_for<Ts...>>;
+    using const_reference        = TupleProxyLRef<self const, std::index_sequence_for<Ts...>>;
+    using iterator               = IndexProxyIter<self>;
+    using const_iterator         = IndexProxyIter<self const>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using size_type              = size_t;
+    using difference_type        = ptrdiff_t;
+    using allocator_type         = AlcT;
+
+    static constexpr size_t ntypes = sizeof...(Ts);
+
+private:
+    using layout = typename SoAArray<soa_aligned_tag<Align>, Ts...>::soa_base;
+
+public:
+    static constexpr size_t col_align = layout::block_align;
+
+private:
+    struct alignas(layout::block_align) block_t {
+        std::byte bytes[layout::block_align];
+    };
+
+    using block_alloc = typename std::allocator_traits<AlcT>::template rebind_alloc<block_t>;
+
+public:
+    struct soa_base {
+        using ptr_tuple_t = tuple<Ts*...>;
+
+        [[no_unique_address]] ptr_tuple_t ptrs = {};
+        size_t                            sz   = {};
+        size_t                            cap  = {};
+
+        [[nodiscard]] constexpr decl_auto at(auto i, size_t j) const {
+            return ptrs[i][j];
+        }
+    };
+
+    soa_base base = {};
+
+    constexpr BasicSoAVector() = default;
+
+    explicit constexpr BasicSoAVector(AlcT const& alc)
+        : AlcT(alc) {
+    }
+
+    explicit constexpr BasicSoAVector(size_t n, value_type const& tup = {}, AlcT const& alc = {})
+        : AlcT(alc) {
+        resize(n, tup);
+    }
+
+    constexpr BasicSoAVector(BasicSoAVector const& other)
+        : AlcT(std::allocator_traits<AlcT>::select_on_container_copy_construction(other)) {
+        _append_from(other);
+    }
+
+    constexpr BasicSoAVector(BasicSoAVector&& other) noexcept
+        : AlcT(std::move(static_cast<AlcT&>(other)))
+        , base(std::exchange(other.base, {})) {
+    }
+
+    constexpr BasicSoAVector& operator=(BasicSoAVector const& other) {
+        if (this != &other) {
+            clear();
+            using alc_traits = std::allocator_traits<AlcT>;
+            if constexpr (alc_traits::propagate_on_container_copy_assignment::value)
+                if (!(get_allocator() == other.get_allocator())) {  // the block belongs to ours
+                    _release();
+                    static_cast<AlcT&>(*this) = static_cast<AlcT const&>(other);
+                }
+            _append_from(other);
+        }
+        return *this;
+    }
+
+    /// @brief Throws only with unequal, non-propagating allocators (the fields are moved into a
+    /// new block)
+    constexpr BasicSoAVector& operator=(BasicSoAVector&& other) noexcept(
+        std::allocator_traits<AlcT>::propagate_on_container_move_assignment::value ||
+        std::allocator_traits<AlcT>::is_always_equal::value) {
+        if (this == &other)
+            return *this;
+        clear();
+        if constexpr (std::allocator_traits<AlcT>::propagate_on_container_move_assignment::value) {
+            _release();
+            static_cast<AlcT&>(*this) = std::move(static_cast<AlcT&>(other));
+        } else if (!(get_allocator() == other.get_allocator())) {  // different arenas, move fields
+            _append_from(std::move(other));
+            other.clear();
+            return *this;
+        } else {
+            _release();
+        }
+        base = std::exchange(other.base, {});
+        return *this;
+    }
+
+    constexpr ~BasicSoAVector() {
+        clear();
+        _release();
+    }
+
+    [[nodiscard]] constexpr allocator_type get_allocator() const noexcept {
+        return static_cast<AlcT const&>(*this);
+    }
+
+    // Element access
+    [[nodiscard]] constexpr reference operator[](size_t i) noexcept {
+        assert(i < size());
+        return {i, this};
+    }
+
+    [[nodiscard]] constexpr const_reference operator[](size_t i) const noexcept {
+        assert(i < size());
+        return {i, this};
+    }
+
+    [[nodiscard]] constexpr reference front() {
+        return (*this)[0];
+    }
+
+    [[nodiscard]] constexpr const_reference front() const {
+        return (*this)[0];
+    }
+
+    [[nodiscard]] constexpr reference back() {
+        return (*this)[size() - 1];
+    }
+
+    [[nodiscard]] constexpr const_reference back() const {
+        return (*this)[size() - 1];
+    }
+
+    // Iterators
+    [[nodiscard]] constexpr iterator begin() {
+        return {0, this};
+    }
+
+    [[nodiscard]] constexpr const_iterator begin() const {
+        return {0, this};
+    }
+
+    [[nodiscard]] constexpr iterator end() {
+        return {size(), this};
+    }
+
+    [[nodiscard]] constexpr const_iterator end() const {
+        return {size(), this};
+    }
+
+    // Capacity
+    [[nodiscard]] constexpr bool empty() const {
+        return size() == 0;
+    }
+
+    [[nodiscard]] constexpr size_type size() const {
+        return base.sz;
+    }
+
+    [[nodiscard]] constexpr size_type capacity() const {
+        return base.cap;
+    }
+
+    constexpr void reserve(size_t new_cap) {
+        if (new_cap > base.cap)
+            _reallocate(new_cap, [](auto&) {});
+    }
+
+    constexpr void shrink_to_fit() {
+        if (base.sz == 0) {
+            _release();
+        } else if (base.sz < base.cap) {
+            _reallocate(base.sz, [](auto&) {});
+        }
+    }
+
+    // Modifiers
+    constexpr void clear() noexcept {
+        _destroy_tail(0);
+    }
+
+    constexpr void push_back(value_type const& tup) {
+        _emplace_with([&](auto i, auto* p) { std::construct_at(p, tup[i]); });
+    }
+
+    constexpr void push_back(value_type&& tup) {
+        _emplace_with([&](auto i, auto* p) { std::construct_at(p, std::move(tup)[i]); });
+    }
+
+    /// @brief From any tuple-like indexed with ct_v<I> (e.g., TupleProxyLRef/TupleProxyRRef)
+    template <typename TupT>
+    requires(!eq<no_cvr<TupT>, value_type>)
+    constexpr void push_back(TupT&& tup) {
+        _emplace_with([&](auto i, auto* p) { std::construct_at(p, FWD(tup)[i]); });
+    }
+
+    /// @brief One constructor argument per column
+    template <typename... Args>
+    requires(sizeof...(Args) == ntypes)
+    constexpr reference emplace_back(Args&&... args) {
+        auto fields = std::forward_as_tuple(FWD(args)...);
+        _emplace_with([&](auto i, auto* p) {
+            std::construct_at(p, std::get<decltype(i)::value>(std::move(fields)));
+        });
+        return back();
+    }
+
+    constexpr void pop_back() {
+        assert(!empty());
+        _destroy_tail(base.sz - 1);
+    }
+
+    constexpr void resize(size_t n, value_type const& tup = {}) {
+        if (n <= base.sz)
+            return _destroy_tail(n);
+
+        reserve(n);
+        for_each_idx<ntypes>([&](auto i) {
+            for (size_t j = base.sz; j < n; ++j)
+                std::construct_at(base.ptrs[i] + j, tup[i]);
+        });
+        base.sz = n;
+    }
+
+private:
+    constexpr void _destroy_tail(size_t new_sz) noexcept {
+        base.ptrs.for_each([&]<class T>(T* ptr) {
+            for (size_t j = new_sz; j < base.sz; ++j)
+                std::destroy_at(ptr + j);
+        });
+        base.sz = min(base.sz, new_sz);
+    }
+
+    [[nodiscard]] static constexpr size_t _n_blocks(size_t cap) {
+        return layout::col_offsets(cap)[ntypes] / sizeof(block_t);
+    }
+
+    [[nodiscard]] constexpr soa_base _allocate(size_t cap) {
+        auto new_base = soa_base{{}, 0, cap};
+        if (cap == 0 || ntypes == 0)
+            return new_base;
+
+        if (std::is_constant_evaluated()) {
+            new_base.ptrs.for_each([&]<class T>(T*& ptr) {
+                using col_alloc = typename std::allocator_traits<AlcT>::template rebind_alloc<T>;
+                ptr             = col_alloc(get_allocator()).allocate(cap);
+            });
+            return new_base;
+        }
+
+        auto  offs  = layout::col_offsets(cap);
+        auto  alc   = block_alloc(get_allocator());
+        auto* block = reinterpret_cast<std::byte*>(alc.allocate(_n_blocks(cap)));
+        for_each_idx<ntypes>([&](auto i) {
+            using T          = std::remove_pointer_t<no_cvr<decltype(new_base.ptrs[i])>>;
+            new_base.ptrs[i] = reinterpret_cast<T*>(block + offs[i]);
+        });
+        return new_base;
+    }
+
+    /// @brief Free the block, the elements must be already destroyed
+    constexpr void _release() noexcept {
+        if (base.cap > 0 && std::is_constant_evaluated()) {
+            base.ptrs.for_each([&]<class T>(T* ptr) {
+                using col_alloc = typename std::allocator_traits<AlcT>::template rebind_alloc<T>;
+                col_alloc(get_allocator()).deallocate(ptr, base.cap);
+            });
+        } else if constexpr (ntypes > 0) {
+            if (base.cap > 0) {
+                auto alc = block_alloc(get_allocator());
+                alc.deallocate(reinterpret_cast<block_t*>(base.ptrs[ct_v<0_uz>]),
+                               _n_blocks(base.cap));
+            }
+        }
+        base = {};
+    }
+
+    /// @brief Move the elements to a new block of new_cap elements. construct_new is called on the
+    /// new base before the move (so it can read references to the old elements).
+    constexpr void _reallocate(size_t new_cap, auto&& construct_new) {
+        assert(new_cap >= base.sz);
+        soa_base new_base = _allocate(new_cap);
+        construct_new(new_base);
+        for_each_idx<ntypes>([&](auto i) {
+            for (size_t j = 0; j < base.sz; ++j)
+                std::construct_at(new_base.ptrs[i] + j, std::move(base.ptrs[i][j]));
+        });
+        new_base.sz = base.sz;
+        clear();
+        _release();
+        base = new_base;
+    }
+
+    constexpr void _emplace_with(auto&& construct_field) {
+        auto construct_at_end = [&](soa_base& b) {
+            for_each_idx<ntypes>([&](auto i) { construct_field(i, b.ptrs[i] + base.sz); });
+        };
+        if (base.sz == base.cap)
+            _reallocate(max(size_t{8}, base.cap * 2), construct_at_end);
+        else
+            construct_at_end(base);
+        ++base.sz;
+    }
+
+    template <typename OtherT>
+    constexpr void _append_from(OtherT&& other) {
+        reserve(base.sz + other.size());
+        for_each_idx<ntypes>([&](auto i) {
+            for (size_t j = 0; j < other.size(); ++j)
+                if constexpr (std::is_rvalue_reference_v<OtherT&&>)
+                    std::construct_at(base.ptrs[i] + base.sz + j, std::move(other.base.ptrs[i][j]));
+                else
+                    std::construct_at(base.ptrs[i] + base.sz + j, other.base.ptrs[i][j]);
+        });
+        base.sz += other.size();
+    }
+};
+
+template <typename... Ts>
+using SoAVector = BasicSoAVector<std::allocator<std::byte>, 64, Ts...>;
+
+#ifdef CAV_COMP_TESTS
+namespace {
+    CAV_BLOCK_PASS({
+        auto v = SoAVector<int, double>{};
+        for (int i = 0; i < 20; ++i)
+            v.push_back({i, i * 0.5});
+        v.emplace_back(20, 10.0);
+        assert(v.size() == 21 && v.capacity() >= 21);
+        assert(v[20][0_ct] == 20 && v[20][1_ct] == 10.0);
+        v.push_back(v[3]);
+        assert(v[21][0_ct] == 3);
+        v.resize(5);
+        v.shrink_to_fit();
+        assert(v.size() == 5 && v.capacity() == 5);
+    });
+
+    CAV_BLOCK_PASS({
+        auto v = SoAVector<int, double>(3, {1, 2.0});
+        auto w = SoAVector<int, double>{};
+        w.push_back({7, 7.0});
+        w = v;
+        assert(w.size() == 3 && w[2][0_ct] == 1 && w[2][1_ct] == 2.0);
+        w = std::move(v);
+        assert(w.size() == 3 && v.empty());
+    });
+}  // namespace
+#endif
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_UTILS_SOAVECTOR_HPP */